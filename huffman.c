@@ -0,0 +1,453 @@
+/*
+ * Algoritmo de Codificação de Huffman - Núcleo do codificador
+ *
+ * Descrição:
+ * Calcula frequências de caracteres, constrói uma árvore de Huffman usando
+ * apenas arrays de tamanho fixo e sem recursão na geração de códigos, e
+ * comprime os dados de entrada em um fluxo binário emitido em blocos de
+ * tamanho fixo. Os bits dos códigos canônicos são atribuídos por
+ * assignCanonicalCodes, em huffman_decode.c, que o decodificador também usa:
+ * ligue os dois arquivos juntos.
+ *
+ * Memória:
+ * Todos os arrays são dimensionados pelo perfil de huffman_config.h. A
+ * árvore fica na HuffmanTreeWork do chamador; a de HuffmanCodes é estática,
+ * e o total dos objetos estáticos é verificado em tempo de compilação
+ * contra HUFF_RAM_BUDGET.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "huffman.h"
+
+// Um MinHeap de índices de nós
+struct MinHeap
+{
+  unsigned size;                             // Número atual de elementos no heap
+  unsigned capacity;                         // Capacidade máxima do heap
+  const struct MinHeapNode *nodes;           // Pool de onde vêm os índices
+  unsigned short array[HUFF_ALPHABET_SIZE]; // Índices dos nós em nodes[]
+};
+
+// Variáveis globais de HuffmanCodes: a árvore, as frequências e os códigos
+static struct HuffmanTreeWork tree;
+static unsigned freq[HUFF_ALPHABET_SIZE];
+static struct HuffmanCodeTable table;
+static struct HuffmanEncoder encoder;
+
+// Todos os objetos que ocupam RAM, para o orçamento e o relatório
+#define HUFF_STATIC_OBJECTS(X) \
+  X(tree)                      \
+  X(freq)                      \
+  X(table)                     \
+  X(encoder)
+
+#define HUFF_SIZEOF_PLUS(obj) sizeof(obj) +
+
+_Static_assert(HUFF_STATIC_OBJECTS(HUFF_SIZEOF_PLUS) sizeof(struct MinHeap) <=
+                   HUFF_RAM_BUDGET,
+               "O perfil de Huffman excede HUFF_RAM_BUDGET");
+
+#ifdef HUFF_FOOTPRINT_REPORT
+#define HUFF_FOOTPRINT_ENTRY(obj) {#obj, sizeof(obj), 0},
+
+const struct HuffmanFootprint huffmanFootprint[] = {
+    HUFF_STATIC_OBJECTS(HUFF_FOOTPRINT_ENTRY)
+    {"MinHeap", sizeof(struct MinHeap), 1},
+    {NULL, 0, 0}};
+#endif
+
+/**
+ * Aloca um novo MinHeapNode.
+ *
+ * @param work Memória de trabalho com o pool de nós.
+ * @param data Caractere para o nó.
+ * @param freq Frequência do caractere.
+ * @return Índice do novo nó.
+ */
+static unsigned short newNode(struct HuffmanTreeWork *work, unsigned char data,
+                              unsigned freq)
+{
+  struct MinHeapNode *temp = &work->nodes[work->nodeIndex];
+  temp->left = temp->right = HUFF_NO_NODE;
+  temp->data = data;
+  temp->depth = 0;
+  temp->freq = freq;
+  return (unsigned short)work->nodeIndex++;
+}
+
+/**
+ * Ordem total usada pelo heap: menor frequência primeiro; empates são
+ * decididos pelo símbolo e depois pela profundidade do nó.
+ *
+ * Como cada nó interno carrega o menor símbolo da sua subárvore, dois nós
+ * no heap nunca têm o mesmo símbolo e a árvore resultante depende apenas do
+ * histograma, não da posição dos nós no heap.
+ *
+ * @param nodes Pool de nós.
+ * @param a Índice do primeiro nó.
+ * @param b Índice do segundo nó.
+ * @return 1 se a deve sair do heap antes de b, 0 caso contrário.
+ */
+static int nodeLess(const struct MinHeapNode *nodes, unsigned short a,
+                    unsigned short b)
+{
+  if (nodes[a].freq != nodes[b].freq)
+    return nodes[a].freq < nodes[b].freq;
+  if (nodes[a].data != nodes[b].data)
+    return nodes[a].data < nodes[b].data;
+  return nodes[a].depth < nodes[b].depth;
+}
+
+// Função utilitária para trocar dois nós de min heap
+static void swapMinHeapNode(unsigned short *a, unsigned short *b)
+{
+  unsigned short t = *a;
+  *a = *b;
+  *b = t;
+}
+
+/**
+ * Função MinHeapify para manter a propriedade do heap.
+ *
+ * @param minHeap Ponteiro para a estrutura MinHeap.
+ * @param idx Índice do nó atual para aplicar heapify.
+ */
+static void minHeapify(struct MinHeap *minHeap, int idx)
+{
+  int smallest = idx;
+  int left = 2 * idx + 1;
+  int right = 2 * idx + 2;
+
+  if (left < (int)minHeap->size &&
+      nodeLess(minHeap->nodes, minHeap->array[left], minHeap->array[smallest]))
+    smallest = left;
+
+  if (right < (int)minHeap->size &&
+      nodeLess(minHeap->nodes, minHeap->array[right], minHeap->array[smallest]))
+    smallest = right;
+
+  if (smallest != idx)
+  {
+    swapMinHeapNode(&minHeap->array[smallest], &minHeap->array[idx]);
+    minHeapify(minHeap, smallest);
+  }
+}
+
+/**
+ * Extrai o nó com a frequência mínima do heap.
+ *
+ * @param minHeap Ponteiro para a estrutura MinHeap.
+ * @return Índice do nó extraído.
+ */
+static unsigned short extractMin(struct MinHeap *minHeap)
+{
+  unsigned short temp = minHeap->array[0];
+  minHeap->array[0] = minHeap->array[minHeap->size - 1];
+  --minHeap->size;
+  minHeapify(minHeap, 0);
+  return temp;
+}
+
+/**
+ * Insere um novo nó no MinHeap.
+ *
+ * @param minHeap Ponteiro para a estrutura MinHeap.
+ * @param node Índice do nó a ser inserido.
+ */
+static void insertMinHeap(struct MinHeap *minHeap, unsigned short node)
+{
+  ++minHeap->size;
+  int i = minHeap->size - 1;
+
+  while (i && nodeLess(minHeap->nodes, node, minHeap->array[(i - 1) / 2]))
+  {
+    minHeap->array[i] = minHeap->array[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  minHeap->array[i] = node;
+}
+
+/**
+ * Verifica se um nó é uma folha.
+ *
+ * @param root Ponteiro para a estrutura MinHeapNode.
+ * @return 1 se for folha, 0 caso contrário.
+ */
+static int isLeaf(const struct MinHeapNode *root)
+{
+  return root->left == HUFF_NO_NODE && root->right == HUFF_NO_NODE;
+}
+
+/**
+ * Cria e constrói um MinHeap com uma folha por símbolo presente.
+ *
+ * Cada peso é a frequência deslocada por shift, nunca menor que 1, o que
+ * permite achatar a árvore quando ela excede HUFF_MAX_CODE_LEN.
+ *
+ * @param work Memória de trabalho com o pool de nós.
+ * @param minHeap Ponteiro para a estrutura MinHeap.
+ * @param freq Array de frequências.
+ * @param shift Deslocamento aplicado aos pesos.
+ */
+static void createAndBuildMinHeap(struct HuffmanTreeWork *work,
+                                  struct MinHeap *minHeap, const unsigned freq[],
+                                  int shift)
+{
+  minHeap->size = 0;
+  minHeap->capacity = HUFF_ALPHABET_SIZE;
+  minHeap->nodes = work->nodes;
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (freq[i] > 0)
+    {
+      unsigned weight = freq[i] >> shift;
+      minHeap->array[minHeap->size++] =
+          newNode(work, (unsigned char)i, weight ? weight : 1);
+    }
+  }
+
+  for (int i = ((int)minHeap->size - 2) / 2; i >= 0; --i)
+    minHeapify(minHeap, i);
+}
+
+struct MinHeapNode *buildHuffmanTree(struct HuffmanTreeWork *work,
+                                     const unsigned freq[], int shift)
+{
+  struct MinHeapNode *nodes = work->nodes;
+  unsigned short left, right, top;
+  struct MinHeap minHeap;
+
+  work->nodeIndex = 0;
+  createAndBuildMinHeap(work, &minHeap, freq, shift);
+
+  if (minHeap.size == 0)
+    return NULL;
+
+  while (minHeap.size > 1)
+  {
+    left = extractMin(&minHeap);
+    right = extractMin(&minHeap);
+
+    // O nó interno herda o menor símbolo e a maior profundidade dos filhos
+    top = newNode(work, nodes[left].data, nodes[left].freq + nodes[right].freq);
+    if (nodes[right].data < nodes[left].data)
+      nodes[top].data = nodes[right].data;
+    nodes[top].depth = (nodes[left].depth > nodes[right].depth
+                            ? nodes[left].depth
+                            : nodes[right].depth) +
+                       1;
+    nodes[top].left = left;
+    nodes[top].right = right;
+
+    insertMinHeap(&minHeap, top);
+  }
+
+  return &nodes[extractMin(&minHeap)];
+}
+
+int calculateFrequencyInChunks(const char data[], unsigned freq[], int size,
+                               int chunkSize)
+{
+  for (int start = 0; start < size; start += chunkSize)
+  {
+    int end = (start + chunkSize < size) ? start + chunkSize : size; // Garante que não ultrapasse o tamanho total
+    for (int i = start; i < end; ++i)
+    {
+      unsigned char c = (unsigned char)data[i]; // Acessa diretamente a memória Flash
+#if HUFF_ALPHABET_SIZE < 256
+      if (c >= HUFF_ALPHABET_SIZE)
+        return -1;
+#endif
+      freq[c]++;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Percorre a árvore de forma iterativa e grava o comprimento do código de
+ * cada folha. Os bits são atribuídos depois, de forma canônica.
+ *
+ * A árvore já deve estar limitada a HUFF_MAX_CODE_LEN níveis, que é o
+ * tamanho da pilha usada no percurso.
+ *
+ * @param work Memória de trabalho onde a árvore foi construída.
+ * @param root Ponteiro para a raiz da árvore de Huffman.
+ * @param table Tabela onde os comprimentos são gravados.
+ */
+static void generateCodes(struct HuffmanTreeWork *work,
+                          const struct MinHeapNode *root,
+                          struct HuffmanCodeTable *table)
+{
+  const struct MinHeapNode *nodes = work->nodes;
+  unsigned short *stack = work->stack;
+  unsigned char *visited = work->visited;
+  int stackTop = 0;
+  unsigned short current = (unsigned short)(root - nodes);
+
+  // Um único símbolo ainda precisa de um bit por ocorrência
+  if (isLeaf(root))
+  {
+    table->len[root->data] = 1;
+    return;
+  }
+
+  while (stackTop > 0 || current != HUFF_NO_NODE)
+  {
+    while (current != HUFF_NO_NODE)
+    {
+      visited[stackTop] = 0;
+      stack[stackTop++] = current;
+      current = nodes[current].left;
+    }
+
+    current = stack[stackTop - 1];
+
+    if (nodes[current].right != HUFF_NO_NODE && !visited[stackTop - 1])
+    {
+      visited[stackTop - 1] = 1;
+      current = nodes[current].right;
+    }
+    else
+    {
+      stackTop--;
+
+      if (isLeaf(&nodes[current]))
+        table->len[nodes[current].data] = (unsigned char)stackTop;
+
+      current = HUFF_NO_NODE;
+    }
+  }
+}
+
+void buildCodeTable(struct HuffmanTreeWork *work, const unsigned freq[],
+                    struct HuffmanCodeTable *table)
+{
+  struct MinHeapNode *root;
+  int shift = 0;
+
+  memset(table, 0, sizeof(*table));
+
+  // Reduz a precisão dos pesos até a árvore caber em HUFF_MAX_CODE_LEN
+  while ((root = buildHuffmanTree(work, freq, shift)) != NULL &&
+         root->depth > HUFF_MAX_CODE_LEN)
+    shift++;
+
+  if (root != NULL)
+  {
+    generateCodes(work, root, table);
+    assignCanonicalCodes(table);
+  }
+}
+
+// Destino da saída comprimida: imprime cada bloco assim que ele enche
+static void printChunk(const unsigned char *chunk, int size, void *context)
+{
+  (void)context;
+  for (int i = 0; i < size; ++i)
+  {
+    putchar(chunk[i]);
+  }
+}
+
+/**
+ * Logaritmo na base 2 em ponto fixo Q8 (8 bits de fração).
+ *
+ * @param x Valor maior que zero.
+ * @return log2(x) * 256, truncado: a parte inteira é a posição do bit mais
+ *         alto, e cada quadrado da mantissa revela um bit da fração.
+ */
+static unsigned log2Q8(unsigned long long x)
+{
+  unsigned n = 0;
+
+  while ((x >> n) > 1)
+    n++;
+
+  // Mantissa em [1, 2) com 16 bits de fração
+  unsigned long long mantissa = n >= 16 ? x >> (n - 16) : x << (16 - n);
+  unsigned result = n * 256;
+  for (int bit = 7; bit >= 0; --bit)
+  {
+    mantissa = (mantissa * mantissa) >> 16;
+    if (mantissa >= 2ull << 16)
+    {
+      mantissa >>= 1;
+      result |= 1u << bit;
+    }
+  }
+  return result;
+}
+
+unsigned long long estimateEntropyBits(const unsigned freq[])
+{
+  unsigned long long total = 0;
+  unsigned long long sum = 0;
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    total += freq[i];
+  if (total == 0)
+    return 0;
+
+  // Soma de f * log2(total / f)
+  unsigned logTotal = log2Q8(total);
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (freq[i] > 0)
+      sum += (unsigned long long)freq[i] * (logTotal - log2Q8(freq[i]));
+  }
+  return sum / 256;
+}
+
+void printHuffmanCodes(const struct HuffmanCodeTable *table)
+{
+  printf("Huffman Codes:\n");
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (table->len[i] != 0)
+    {
+      if (i < ' ' || i > '~')
+      {
+        printf("\\x%02X: ", i);
+      }
+      else
+      {
+        printf("%c: ", i);
+      }
+      for (int j = table->len[i] - 1; j >= 0; --j)
+        putchar('0' + ((table->bits[i] >> j) & 1));
+      putchar('\n');
+    }
+  }
+}
+
+int HuffmanCodes(const char data[], int size)
+{
+  memset(freq, 0, sizeof(freq));
+
+  // Chama a função que calcula a frequência em partes (1000 caracteres por vez)
+  if (calculateFrequencyInChunks(data, freq, size, 1000) != 0)
+  {
+    printf("Caractere fora do alfabeto do perfil (%d simbolos)\n",
+           HUFF_ALPHABET_SIZE);
+    return -1;
+  }
+
+  buildCodeTable(&tree, freq, &table);
+
+  // Imprime os códigos de Huffman gerados
+  printHuffmanCodes(&table);
+
+  printf("Compressed (ASCII):\n");
+  huffmanEncoderInit(&encoder, &table, freq, printChunk, NULL);
+  huffmanEncodeUpdate(&encoder, data, size);
+  huffmanEncoderFinish(&encoder);
+  putchar('\n');
+
+  printf("Tamanho previsto: %llu bytes\n",
+         HUFF_FRAME_HEADER_SIZE + (huffmanEncodedBits(freq, &table) + 7) / 8);
+
+  printf("Number of ASCII characters generated: %lu\n", encoder.total);
+  return 0;
+}
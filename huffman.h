@@ -0,0 +1,420 @@
+/*
+ * Algoritmo de Codificação de Huffman - Interface pública
+ *
+ * Funções de cálculo de frequência, construção da árvore, geração de códigos
+ * e compressão, compartilhadas pelos programas huffman_t2*.c. Os tamanhos
+ * dos arrays vêm do perfil selecionado em huffman_config.h.
+ */
+#ifndef HUFFMAN_H
+#define HUFFMAN_H
+
+#include "huffman_config.h"
+
+// Cabeçalho do fluxo: tamanho original (4 bytes, little-endian) seguido da
+// quantidade de bits de preenchimento do último byte (1 byte)
+#define HUFF_FRAME_HEADER_SIZE 5
+
+// n folhas geram no máximo 2n - 1 nós
+#define HUFF_MAX_NODES (2 * HUFF_ALPHABET_SIZE - 1)
+#define HUFF_NO_NODE 0xFFFF // Índice de filho ausente
+
+// Um nó na árvore de Huffman. Os filhos são índices no pool de nós
+// (HuffmanTreeWork), e não ponteiros, para que o tamanho do nó não dependa
+// da ABI.
+struct MinHeapNode
+{
+  unsigned freq;        // Frequência do caractere
+  unsigned short left;  // Índice do filho esquerdo (HUFF_NO_NODE se folha)
+  unsigned short right; // Índice do filho direito (HUFF_NO_NODE se folha)
+  unsigned char data;   // Caractere (nós internos: menor símbolo da subárvore)
+  unsigned char depth;  // Altura da subárvore (0 para folhas)
+};
+
+// Memória de trabalho de buildHuffmanTree e buildCodeTable: o pool de nós
+// e a pilha do percurso. Uma por thread; o conteúdo não precisa ser
+// preservado entre chamadas.
+struct HuffmanTreeWork
+{
+  struct MinHeapNode nodes[HUFF_MAX_NODES];     // Pool de nós da árvore
+  int nodeIndex;                                // Próximo nó livre
+  unsigned short stack[HUFF_MAX_CODE_LEN + 1];  // Nós do percurso de códigos
+  unsigned char visited[HUFF_MAX_CODE_LEN + 1]; // Filho direito já visitado
+};
+
+// Códigos de Huffman de todo o alfabeto
+struct HuffmanCodeTable
+{
+  unsigned short bits[HUFF_ALPHABET_SIZE]; // Código (bits menos significativos)
+  unsigned char len[HUFF_ALPHABET_SIZE];   // Comprimento (0 se ausente)
+};
+
+/**
+ * Destino dos blocos comprimidos (UART, arquivo, socket...).
+ *
+ * @param chunk Bytes do bloco; válidos apenas durante a chamada.
+ * @param size Quantidade de bytes (HUFF_OUT_CHUNK, exceto no último bloco).
+ * @param context Ponteiro repassado de huffmanEncoderInit.
+ */
+typedef void (*HuffmanSink)(const unsigned char *chunk, int size, void *context);
+
+// Estado do codificador em fluxo: ocupa O(HUFF_OUT_CHUNK) bytes
+struct HuffmanEncoder
+{
+  const struct HuffmanCodeTable *table; // Códigos usados na compressão
+  HuffmanSink sink;                     // Recebe cada bloco cheio
+  void *context;                        // Repassado ao sink
+  unsigned long total;                  // Bytes já entregues ao sink
+  unsigned long remaining;              // Símbolos anunciados no cabeçalho e ainda não codificados
+  unsigned bitBuffer;                   // Bits que ainda não completam um byte
+  int bitCount;                         // Quantidade de bits em bitBuffer
+  int size;                             // Bytes ocupados em chunk
+  unsigned char chunk[HUFF_OUT_CHUNK];  // Bloco em preenchimento
+};
+
+// Marca de folha nas entradas de HuffmanDecodeTable (símbolo nos bits baixos)
+#define HUFF_LEAF 0x8000
+
+// Árvore de decodificação reconstruída a partir dos códigos canônicos.
+// Cada nó interno tem dois filhos: índice de outro nó interno, HUFF_LEAF |
+// símbolo ou HUFF_NO_NODE. A raiz é o nó 0. Pode ser compartilhada por
+// quantos decodificadores forem necessários.
+struct HuffmanDecodeTable
+{
+  unsigned short child[HUFF_ALPHABET_SIZE][2];
+};
+
+// Decodificação canônica sem árvore: códigos de mesmo comprimento são
+// consecutivos, então basta saber, para cada comprimento, o primeiro código,
+// quantos existem e onde começam na lista de símbolos. Ocupa
+// 6 * (HUFF_MAX_CODE_LEN + 1) + HUFF_ALPHABET_SIZE bytes (206 no STM32F030),
+// contra 4 * HUFF_ALPHABET_SIZE da árvore.
+struct HuffmanCanonicalTable
+{
+  unsigned short first[HUFF_MAX_CODE_LEN + 1];  // Primeiro código de cada comprimento
+  unsigned short count[HUFF_MAX_CODE_LEN + 1];  // Quantidade de códigos de cada comprimento
+  unsigned short offset[HUFF_MAX_CODE_LEN + 1]; // Posição do primeiro deles em symbols
+  unsigned char symbols[HUFF_ALPHABET_SIZE];    // Em ordem de comprimento e de símbolo
+};
+
+// Estado de um decodificador em fluxo: alguns bytes por conexão
+struct HuffmanDecoder
+{
+  const struct HuffmanDecodeTable *table; // Árvore compartilhada
+  unsigned long remaining;                // Símbolos ainda não decodificados
+  unsigned short node;                    // Nó atual dentro de um código
+  unsigned char bits;                     // Byte de entrada em consumo
+  unsigned char bitCount;                 // Bits ainda não lidos de bits
+  unsigned char headerPos;                // Bytes do cabeçalho já lidos
+  unsigned char padding;                  // Bits de preenchimento do último byte
+};
+
+// Resultados de huffmanDecodeUpdate
+#define HUFF_DECODE_NEED_INPUT 0  // Toda a entrada foi consumida
+#define HUFF_DECODE_OUTPUT_FULL 1 // Buffer de saída cheio
+#define HUFF_DECODE_DONE 2        // Todos os símbolos do cabeçalho decodificados
+#define HUFF_DECODE_ERROR -1      // Código inexistente ou preenchimento incorreto
+
+/**
+ * Calcula a frequência dos caracteres por partes (ex: 1000 caracteres por vez).
+ *
+ * @param data Dados de entrada.
+ * @param freq Array de frequências (HUFF_ALPHABET_SIZE posições) a acumular.
+ * @param size Tamanho dos dados de entrada.
+ * @param chunkSize Quantidade de caracteres processados por parte.
+ * @return 0 em caso de sucesso, -1 se algum caractere estiver fora do alfabeto.
+ */
+int calculateFrequencyInChunks(const char data[], unsigned freq[], int size,
+                               int chunkSize);
+
+/**
+ * Constrói uma Árvore de Huffman a partir das frequências.
+ *
+ * @param work Memória de trabalho, onde ficam os nós.
+ * @param freq Array de frequências (HUFF_ALPHABET_SIZE posições).
+ * @param shift Deslocamento aplicado aos pesos (0 para as frequências reais).
+ * @return Ponteiro para a raiz (dentro de work), ou NULL se não houver
+ *         nenhum símbolo.
+ */
+struct MinHeapNode *buildHuffmanTree(struct HuffmanTreeWork *work,
+                                     const unsigned freq[], int shift);
+
+/**
+ * Gera os códigos de Huffman limitados a HUFF_MAX_CODE_LEN bits.
+ *
+ * @param work Memória de trabalho da árvore.
+ * @param freq Array de frequências (HUFF_ALPHABET_SIZE posições).
+ * @param table Tabela onde os códigos são gravados.
+ */
+void buildCodeTable(struct HuffmanTreeWork *work, const unsigned freq[],
+                    struct HuffmanCodeTable *table);
+
+/**
+ * Atribui códigos canônicos a partir dos comprimentos em table->len.
+ *
+ * Os códigos dependem apenas dos comprimentos, de modo que basta transmitir
+ * table->len para que o decodificador reconstrua a mesma tabela.
+ *
+ * @param table Tabela com os comprimentos preenchidos; os bits são gravados.
+ * @return 0 em caso de sucesso, -1 se os comprimentos forem inválidos.
+ */
+int assignCanonicalCodes(struct HuffmanCodeTable *table);
+
+/**
+ * Estima, só com o histograma, o tamanho ideal da entrada codificada
+ * (entropia de ordem 0). Usa apenas aritmética inteira, sem construir a
+ * árvore; o logaritmo em Q8 erra menos de 1/128 bit por símbolo.
+ *
+ * @param freq Array de frequências (HUFF_ALPHABET_SIZE posições).
+ * @return Estimativa em bits; um código de Huffman nunca fica abaixo dela.
+ */
+unsigned long long estimateEntropyBits(const unsigned freq[]);
+
+/**
+ * Calcula o tamanho exato da entrada codificada: soma de freq[s] * len[s].
+ * Deve ser chamada logo após buildCodeTable, para alocar a saída uma vez só.
+ *
+ * @param freq Histograma da entrada.
+ * @param table Códigos gerados a partir desse histograma.
+ * @return Quantidade de bits (sem cabeçalho nem preenchimento).
+ */
+unsigned long long huffmanEncodedBits(const unsigned freq[],
+                                      const struct HuffmanCodeTable *table);
+
+/**
+ * Limite superior do fluxo completo (cabeçalho incluso) para qualquer entrada
+ * de size bytes, válido antes mesmo de calcular o histograma.
+ *
+ * @param size Tamanho da entrada.
+ * @return Bytes suficientes para a saída de huffmanEncoderInit/Update/Finish.
+ */
+unsigned long long huffmanEncodedBound(unsigned long size);
+
+/**
+ * Imprime os códigos de Huffman gerados.
+ *
+ * @param table Tabela de códigos.
+ */
+void printHuffmanCodes(const struct HuffmanCodeTable *table);
+
+/**
+ * Inicializa o codificador sem escrever o cabeçalho do fluxo, para quando o
+ * tamanho original é guardado em outro lugar (ex: cabeçalho de bloco).
+ *
+ * @param encoder Estado do codificador.
+ * @param table Códigos a usar; deve permanecer válida até o fim.
+ * @param rawSize Quantidade de símbolos que será passada a Update.
+ * @param sink Função chamada a cada HUFF_OUT_CHUNK bytes comprimidos.
+ * @param context Ponteiro repassado ao sink.
+ */
+void huffmanEncoderInitRaw(struct HuffmanEncoder *encoder,
+                           const struct HuffmanCodeTable *table,
+                           unsigned long rawSize, HuffmanSink sink,
+                           void *context);
+
+/**
+ * Inicializa o codificador em fluxo e escreve o cabeçalho do fluxo.
+ *
+ * O histograma da entrada que será codificada determina o tamanho original
+ * e o preenchimento anunciados no cabeçalho.
+ *
+ * @param encoder Estado do codificador.
+ * @param table Códigos a usar; deve permanecer válida até o fim.
+ * @param freq Histograma de toda a entrada que será passada a Update.
+ * @param sink Função chamada a cada HUFF_OUT_CHUNK bytes comprimidos.
+ * @param context Ponteiro repassado ao sink.
+ */
+void huffmanEncoderInit(struct HuffmanEncoder *encoder,
+                        const struct HuffmanCodeTable *table,
+                        const unsigned freq[], HuffmanSink sink, void *context);
+
+/**
+ * Comprime mais uma parte da entrada. Pode ser chamada quantas vezes for
+ * necessário; cada bloco é entregue ao sink assim que enche.
+ *
+ * @param encoder Estado do codificador.
+ * @param data Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @return 0 em caso de sucesso, -1 se algum caractere não tiver código ou
+ *         se a entrada exceder o tamanho anunciado no cabeçalho. Nesse caso
+ *         nada da parte é codificado e o estado fica como estava.
+ */
+int huffmanEncodeUpdate(struct HuffmanEncoder *encoder, const char data[],
+                        int size);
+
+/**
+ * Codifica um buffer inteiro de uma vez, sem cabeçalho e sem verificar
+ * limites a cada símbolo.
+ *
+ * Pré-condições: todos os símbolos de in têm código em table (ex: a tabela
+ * veio do histograma de in) e out tem ao menos
+ * (huffmanEncodedBits(freq, table) + 7) / 8 bytes. Com uma tabela constante
+ * (ver huffman_gen.c) o histograma não é conhecido; out deve então ter
+ * huffmanEncodedBound(size) bytes.
+ *
+ * @param table Códigos a usar.
+ * @param in Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @param out Buffer de saída.
+ * @return Bits escritos em out; o último dos (bits + 7) / 8 bytes é
+ *         completado com zeros (preenchimento de (8 - bits % 8) % 8 bits).
+ */
+unsigned long long huffmanEncodeBuffer(const struct HuffmanCodeTable *table,
+                                       const char in[], unsigned long size,
+                                       unsigned char out[]);
+
+/**
+ * Completa o último byte com zeros à direita e entrega o bloco parcial.
+ *
+ * @param encoder Estado do codificador.
+ * @return 0 em caso de sucesso, -1 se faltaram símbolos anunciados no cabeçalho.
+ */
+int huffmanEncoderFinish(struct HuffmanEncoder *encoder);
+
+/**
+ * Constrói a árvore de decodificação a partir de uma tabela canônica.
+ *
+ * @param codes Tabela de códigos (ver assignCanonicalCodes).
+ * @param table Árvore de decodificação gerada.
+ * @return 0 em caso de sucesso, -1 se os códigos não formarem um prefixo válido.
+ */
+int buildDecodeTable(const struct HuffmanCodeTable *codes,
+                     struct HuffmanDecodeTable *table);
+
+/**
+ * Inicializa um decodificador em fluxo.
+ *
+ * @param decoder Estado do decodificador.
+ * @param table Árvore de decodificação; deve permanecer válida até o fim.
+ */
+void huffmanDecoderInit(struct HuffmanDecoder *decoder,
+                        const struct HuffmanDecodeTable *table);
+
+/**
+ * Inicializa um decodificador para um fluxo sem cabeçalho, cujo tamanho
+ * original e preenchimento são conhecidos por outro meio.
+ *
+ * @param decoder Estado do decodificador.
+ * @param table Árvore de decodificação; deve permanecer válida até o fim.
+ * @param rawSize Quantidade de símbolos a decodificar.
+ * @param padding Bits de preenchimento esperados no último byte.
+ */
+void huffmanDecoderInitRaw(struct HuffmanDecoder *decoder,
+                           const struct HuffmanDecodeTable *table,
+                           unsigned long rawSize, int padding);
+
+/**
+ * Decodifica um buffer inteiro de uma vez, sem cabeçalho: exatamente count
+ * símbolos a partir do primeiro bit de in. Sem o estado de
+ * huffmanDecodeUpdate, serve a quem já tem todo o fluxo na memória.
+ *
+ * @param table Árvore de decodificação.
+ * @param in Dados comprimidos.
+ * @param inSize Tamanho de in.
+ * @param out Buffer de saída, com ao menos count bytes.
+ * @param count Quantidade de símbolos.
+ * @return Bits consumidos, ou -1 se a entrada acabar ou tiver código inválido.
+ */
+long long huffmanDecodeBuffer(const struct HuffmanDecodeTable *table,
+                              const unsigned char *in, unsigned long inSize,
+                              char *out, unsigned long count);
+
+/**
+ * Decodifica count símbolos intercalados em streamCount fluxos
+ * independentes, sem cabeçalho: o símbolo i sai do fluxo i % streamCount e
+ * vai para out[i]. Percorre a árvore em cada fluxo, um de cada vez.
+ *
+ * @param table Árvore de decodificação.
+ * @param streams Início de cada fluxo.
+ * @param sizes Tamanho de cada fluxo.
+ * @param streamCount Quantidade de fluxos.
+ * @param out Buffer de saída, com ao menos count bytes.
+ * @param count Quantidade total de símbolos.
+ * @param consumed Recebe os bits consumidos de cada fluxo.
+ * @return 0 em caso de sucesso, -1 se algum fluxo acabar ou for inválido.
+ */
+int huffmanDecodeStreamsBuffer(const struct HuffmanDecodeTable *table,
+                               const unsigned char *const streams[],
+                               const unsigned long sizes[], int streamCount,
+                               char *out, unsigned long count,
+                               unsigned long long consumed[]);
+
+/**
+ * Prepara a decodificação canônica só com os comprimentos dos códigos.
+ *
+ * @param len Comprimento de cada símbolo (HUFF_ALPHABET_SIZE posições, 0 se
+ *            ausente), como em HuffmanCodeTable.
+ * @param table Tabela gerada.
+ * @return 0 em caso de sucesso, -1 se os comprimentos não formarem um prefixo
+ *         válido.
+ */
+int buildCanonicalTable(const unsigned char len[],
+                        struct HuffmanCanonicalTable *table);
+
+/**
+ * Como huffmanDecodeBuffer, mas com a tabela canônica: cada bit lido é
+ * comparado com o intervalo de códigos do comprimento atual, em no máximo
+ * HUFF_MAX_CODE_LEN passos por símbolo.
+ *
+ * @param table Tabela canônica.
+ * @param in Dados comprimidos.
+ * @param inSize Tamanho de in.
+ * @param out Buffer de saída, com ao menos count bytes.
+ * @param count Quantidade de símbolos.
+ * @return Bits consumidos, ou -1 se a entrada acabar ou tiver código inválido.
+ */
+long long huffmanDecodeCanonical(const struct HuffmanCanonicalTable *table,
+                                 const unsigned char *in, unsigned long inSize,
+                                 char *out, unsigned long count);
+
+/**
+ * Faz o decodificador começar no meio de um byte, para retomar o fluxo a
+ * partir de um ponto de acesso aleatório. Deve ser chamada logo após
+ * huffmanDecoderInitRaw; a entrada seguinte começa no byte após first.
+ *
+ * @param decoder Estado do decodificador.
+ * @param first Byte que contém o primeiro bit a decodificar.
+ * @param skip Bits de first a ignorar (1 a 7), o mais significativo primeiro.
+ */
+void huffmanDecoderStartAt(struct HuffmanDecoder *decoder, unsigned char first,
+                           int skip);
+
+/**
+ * Decodifica mais um fragmento da entrada, de qualquer tamanho. Os bits de um
+ * código dividido entre fragmentos ficam guardados no estado do decodificador.
+ *
+ * @param decoder Estado do decodificador.
+ * @param in Fragmento comprimido.
+ * @param inSize Tamanho do fragmento.
+ * @param consumed Recebe quantos bytes de in foram consumidos.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @param produced Recebe quantos bytes foram escritos em out.
+ * @return Um dos valores HUFF_DECODE_*.
+ */
+int huffmanDecodeUpdate(struct HuffmanDecoder *decoder, const unsigned char *in,
+                        int inSize, int *consumed, char *out, int outSize,
+                        int *produced);
+
+/**
+ * Gera os códigos de Huffman e realiza a compressão, imprimindo o resultado.
+ *
+ * @param data Dados de entrada (texto).
+ * @param size Tamanho dos dados de entrada.
+ * @return 0 em caso de sucesso, -1 se a entrada não couber no perfil.
+ */
+int HuffmanCodes(const char data[], int size);
+
+#ifdef HUFF_FOOTPRINT_REPORT
+// Uma linha do relatório de footprint (ver huffman_footprint.c)
+struct HuffmanFootprint
+{
+  const char *name;   // Nome do objeto
+  unsigned long size; // Tamanho em bytes
+  int onStack;        // 1 se alocado na pilha, 0 se estático
+};
+
+// Objetos de huffman.c, terminado por uma entrada com name == NULL
+extern const struct HuffmanFootprint huffmanFootprint[];
+#endif
+
+#endif
@@ -0,0 +1,630 @@
+/*
+ * Algoritmo de Codificação de Huffman - Biblioteca C++17 header-only
+ *
+ * Descrição:
+ * Versão em templates do núcleo em C, parametrizada pelo tamanho do alfabeto
+ * e pelo comprimento máximo de código em vez das macros de huffman_config.h.
+ * As tabelas são std::array dimensionados em tempo de compilação, e toda a
+ * geração de códigos é constexpr: com o histograma conhecido na compilação,
+ * a tabela canônica inteira é calculada pelo compilador.
+ *
+ * O fluxo de bits é idêntico ao de huffmanEncodeBuffer para o mesmo
+ * histograma, alfabeto e comprimento máximo: mesma ordem de desempate da
+ * árvore, mesma limitação de comprimento e os mesmos códigos canônicos.
+ *
+ * Uso:
+ *   constexpr auto freq = huffman::makeHistogram<128>("texto conhecido");
+ *   constexpr auto codes = huffman::makeCodeTable<128, 12>(freq);
+ *   huffman::Encoder<128, 12> encoder(codes);
+ *   huffman::Decoder<128, 12> decoder(codes);
+ *
+ * Para protocolos com estatística fixa, makeTables (ou compileTables, em
+ * C++20) gera também a árvore de decodificação, e verifyTables permite
+ * conferir o resultado com static_assert (ver huffman_constexpr.cpp).
+ */
+#ifndef HUFFMAN_HPP
+#define HUFFMAN_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace huffman
+{
+
+template <std::size_t AlphabetSize>
+using Histogram = std::array<std::uint32_t, AlphabetSize>;
+
+// Códigos canônicos: bits[s] guarda os len[s] bits menos significativos
+template <std::size_t AlphabetSize, unsigned MaxBits>
+struct CodeTable
+{
+  static_assert(AlphabetSize >= 2 && AlphabetSize <= 256,
+                "O alfabeto deve caber em um byte");
+  static_assert(MaxBits >= 1 && MaxBits <= 16,
+                "MaxBits deve caber em std::uint16_t");
+  static_assert((std::size_t{1} << MaxBits) >= AlphabetSize,
+                "MaxBits pequeno demais para o alfabeto");
+
+  std::array<std::uint16_t, AlphabetSize> bits{};
+  std::array<std::uint8_t, AlphabetSize> len{};
+};
+
+// Árvore de decodificação, no mesmo formato de struct HuffmanDecodeTable
+template <std::size_t AlphabetSize>
+struct DecodeTable
+{
+  static constexpr std::uint16_t noNode = 0xFFFF;
+  static constexpr std::uint16_t leaf = 0x8000;
+
+  std::array<std::array<std::uint16_t, 2>, AlphabetSize> child{};
+};
+
+namespace detail
+{
+
+// Nós da árvore de Huffman, ligados por índices. Arrays simples em vez de
+// std::array custam menos operações na avaliação constexpr.
+template <std::size_t AlphabetSize>
+struct Tree
+{
+  std::uint32_t freq[2 * AlphabetSize]{};
+  std::uint16_t parent[2 * AlphabetSize]{};
+  std::uint8_t data[2 * AlphabetSize]{};
+  std::uint8_t depth[2 * AlphabetSize]{};
+};
+
+// Mesma ordem total de nodeLess em huffman.c: frequência, símbolo, altura
+template <std::size_t AlphabetSize>
+constexpr bool nodeLess(const Tree<AlphabetSize> &tree, std::size_t a,
+                        std::size_t b)
+{
+  if (tree.freq[a] != tree.freq[b])
+    return tree.freq[a] < tree.freq[b];
+  if (tree.data[a] != tree.data[b])
+    return tree.data[a] < tree.data[b];
+  return tree.depth[a] < tree.depth[b];
+}
+
+// Desce o nó da posição i até restaurar a propriedade do heap
+template <std::size_t AlphabetSize>
+constexpr void siftDown(const Tree<AlphabetSize> &tree,
+                        std::uint16_t (&heap)[AlphabetSize],
+                        std::size_t size, std::size_t i)
+{
+  for (;;)
+  {
+    std::size_t smallest = i;
+    std::size_t left = 2 * i + 1;
+    std::size_t right = 2 * i + 2;
+
+    if (left < size && nodeLess(tree, heap[left], heap[smallest]))
+      smallest = left;
+    if (right < size && nodeLess(tree, heap[right], heap[smallest]))
+      smallest = right;
+    if (smallest == i)
+      return;
+
+    std::uint16_t t = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = t;
+    i = smallest;
+  }
+}
+
+// Remove e retorna o menor nó do heap
+template <std::size_t AlphabetSize>
+constexpr std::uint16_t extractMin(const Tree<AlphabetSize> &tree,
+                                   std::uint16_t (&heap)[AlphabetSize],
+                                   std::size_t &size)
+{
+  std::uint16_t node = heap[0];
+  heap[0] = heap[--size];
+  siftDown(tree, heap, size, 0);
+  return node;
+}
+
+// Insere um nó no heap
+template <std::size_t AlphabetSize>
+constexpr void insertMin(const Tree<AlphabetSize> &tree,
+                         std::uint16_t (&heap)[AlphabetSize],
+                         std::size_t &size, std::uint16_t node)
+{
+  std::size_t i = size++;
+
+  while (i > 0 && nodeLess(tree, node, heap[(i - 1) / 2]))
+  {
+    heap[i] = heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap[i] = node;
+}
+
+/**
+ * Constrói a árvore com os pesos deslocados por shift (nunca menores que 1)
+ * e grava o comprimento de código de cada símbolo.
+ *
+ * Como a ordem é total, a árvore depende só do histograma e é a mesma de
+ * buildHuffmanTree.
+ *
+ * @param freq Histograma.
+ * @param shift Deslocamento aplicado aos pesos.
+ * @param len Recebe os comprimentos (0 para símbolos ausentes).
+ * @return Altura da árvore.
+ */
+template <std::size_t AlphabetSize>
+constexpr unsigned buildLengths(const Histogram<AlphabetSize> &freq,
+                                unsigned shift,
+                                std::array<std::uint8_t, AlphabetSize> &len)
+{
+  Tree<AlphabetSize> tree{};
+  std::uint16_t heap[AlphabetSize]{};
+  std::uint16_t leafOf[AlphabetSize]{};
+  std::size_t heapSize = 0;
+  std::size_t nodeCount = 0;
+
+  for (std::size_t i = 0; i < AlphabetSize; ++i)
+  {
+    len[i] = 0;
+    if (freq[i] > 0)
+    {
+      std::uint32_t weight = freq[i] >> shift;
+      tree.freq[nodeCount] = weight ? weight : 1;
+      tree.data[nodeCount] = static_cast<std::uint8_t>(i);
+      leafOf[i] = static_cast<std::uint16_t>(nodeCount);
+      heap[heapSize++] = static_cast<std::uint16_t>(nodeCount++);
+    }
+  }
+
+  if (heapSize == 0)
+    return 0;
+  if (heapSize == 1)
+  {
+    // Um único símbolo ainda precisa de um bit por ocorrência
+    len[tree.data[0]] = 1;
+    return 1;
+  }
+
+  for (std::size_t i = (heapSize - 2) / 2 + 1; i-- > 0;)
+    siftDown(tree, heap, heapSize, i);
+
+  while (heapSize > 1)
+  {
+    std::uint16_t left = extractMin(tree, heap, heapSize);
+    std::uint16_t right = extractMin(tree, heap, heapSize);
+    std::size_t top = nodeCount++;
+
+    // O nó interno herda o menor símbolo e a maior altura dos filhos
+    tree.freq[top] = tree.freq[left] + tree.freq[right];
+    tree.data[top] =
+        tree.data[right] < tree.data[left] ? tree.data[right] : tree.data[left];
+    tree.depth[top] = static_cast<std::uint8_t>(
+        (tree.depth[left] > tree.depth[right] ? tree.depth[left]
+                                              : tree.depth[right]) +
+        1);
+    tree.parent[left] = tree.parent[right] = static_cast<std::uint16_t>(top);
+    insertMin(tree, heap, heapSize, static_cast<std::uint16_t>(top));
+  }
+
+  std::size_t root = heap[0];
+  for (std::size_t i = 0; i < AlphabetSize; ++i)
+  {
+    if (freq[i] == 0)
+      continue;
+    unsigned depth = 0;
+    for (std::size_t node = leafOf[i]; node != root; node = tree.parent[node])
+      depth++;
+    len[i] = static_cast<std::uint8_t>(depth);
+  }
+  return tree.depth[root];
+}
+
+} // namespace detail
+
+/**
+ * Monta o histograma de um texto conhecido (ex: em tempo de compilação).
+ * Símbolos fora do alfabeto são ignorados; use fitsAlphabet para recusá-los.
+ *
+ * @param data Texto.
+ * @return Frequência de cada símbolo.
+ */
+template <std::size_t AlphabetSize>
+constexpr Histogram<AlphabetSize> makeHistogram(std::string_view data)
+{
+  Histogram<AlphabetSize> freq{};
+
+  for (char c : data)
+  {
+    unsigned char symbol = static_cast<unsigned char>(c);
+    if (symbol < AlphabetSize)
+      freq[symbol]++;
+  }
+  return freq;
+}
+
+/**
+ * @param data Texto.
+ * @return true se todos os símbolos de data cabem no alfabeto.
+ */
+template <std::size_t AlphabetSize>
+constexpr bool fitsAlphabet(std::string_view data)
+{
+  for (char c : data)
+  {
+    if (static_cast<unsigned char>(c) >= AlphabetSize)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Atribui códigos canônicos a partir dos comprimentos, como
+ * assignCanonicalCodes em huffman.c.
+ *
+ * @param table Tabela com len preenchido; bits é sobrescrito.
+ * @return false se os comprimentos violarem a desigualdade de Kraft.
+ */
+template <std::size_t AlphabetSize, unsigned MaxBits>
+constexpr bool assignCanonicalCodes(CodeTable<AlphabetSize, MaxBits> &table)
+{
+  std::array<std::uint16_t, MaxBits + 1> count{};
+  std::array<std::uint16_t, MaxBits + 1> nextCode{};
+  long left = 1;
+
+  for (std::size_t i = 0; i < AlphabetSize; ++i)
+  {
+    if (table.len[i] > MaxBits)
+      return false;
+    count[table.len[i]]++;
+  }
+  count[0] = 0;
+
+  for (unsigned len = 1; len <= MaxBits; ++len)
+  {
+    left = (left << 1) - count[len];
+    if (left < 0)
+      return false;
+  }
+
+  std::uint16_t code = 0;
+  for (unsigned len = 1; len <= MaxBits; ++len)
+  {
+    code = static_cast<std::uint16_t>((code + count[len - 1]) << 1);
+    nextCode[len] = code;
+  }
+
+  for (std::size_t i = 0; i < AlphabetSize; ++i)
+  {
+    if (table.len[i] != 0)
+      table.bits[i] = nextCode[table.len[i]]++;
+  }
+  return true;
+}
+
+/**
+ * Gera a tabela canônica com comprimento limitado a MaxBits, reduzindo a
+ * precisão dos pesos até a árvore caber (mesmo critério de buildCodeTable).
+ *
+ * @param freq Histograma.
+ * @return Códigos de cada símbolo (len 0 para os ausentes).
+ */
+template <std::size_t AlphabetSize, unsigned MaxBits>
+constexpr CodeTable<AlphabetSize, MaxBits>
+makeCodeTable(const Histogram<AlphabetSize> &freq)
+{
+  CodeTable<AlphabetSize, MaxBits> table{};
+  unsigned shift = 0;
+
+  while (detail::buildLengths(freq, shift, table.len) > MaxBits)
+    shift++;
+  assignCanonicalCodes(table);
+  return table;
+}
+
+/**
+ * Monta a árvore de decodificação, como buildDecodeTable em huffman_decode.c.
+ *
+ * @param codes Códigos canônicos.
+ * @param table Árvore preenchida.
+ * @return false se os códigos não formarem um código de prefixo.
+ */
+template <std::size_t AlphabetSize, unsigned MaxBits>
+constexpr bool buildDecodeTable(const CodeTable<AlphabetSize, MaxBits> &codes,
+                                DecodeTable<AlphabetSize> &table)
+{
+  using Table = DecodeTable<AlphabetSize>;
+  std::size_t nodeCount = 1; // A raiz já existe
+
+  for (auto &node : table.child)
+    node = {Table::noNode, Table::noNode};
+
+  for (std::size_t i = 0; i < AlphabetSize; ++i)
+  {
+    unsigned len = codes.len[i];
+    std::size_t node = 0;
+
+    if (len == 0)
+      continue;
+
+    for (unsigned j = len - 1; j > 0; --j)
+    {
+      std::uint16_t &next = table.child[node][(codes.bits[i] >> j) & 1];
+      if (next == Table::noNode)
+      {
+        if (nodeCount == AlphabetSize)
+          return false;
+        next = static_cast<std::uint16_t>(nodeCount++);
+      }
+      else if (next & Table::leaf)
+      {
+        return false; // Um código mais curto é prefixo deste
+      }
+      node = next;
+    }
+
+    std::uint16_t &leaf = table.child[node][codes.bits[i] & 1];
+    if (leaf != Table::noNode)
+      return false;
+    leaf = static_cast<std::uint16_t>(Table::leaf | i);
+  }
+  return true;
+}
+
+// Tabelas completas para um protocolo com estatística fixa
+template <std::size_t AlphabetSize, unsigned MaxBits>
+struct Tables
+{
+  CodeTable<AlphabetSize, MaxBits> codes{};
+  DecodeTable<AlphabetSize> decode{};
+  bool valid = false; // false se buildDecodeTable recusou os códigos
+};
+
+/**
+ * Executa o pipeline inteiro: histograma -> comprimentos -> códigos
+ * canônicos -> árvore de decodificação.
+ *
+ * @param freq Histograma.
+ * @return Tabelas de codificação e decodificação.
+ */
+template <std::size_t AlphabetSize, unsigned MaxBits>
+constexpr Tables<AlphabetSize, MaxBits>
+makeTables(const Histogram<AlphabetSize> &freq)
+{
+  Tables<AlphabetSize, MaxBits> tables{};
+
+  tables.codes = makeCodeTable<AlphabetSize, MaxBits>(freq);
+  tables.valid = buildDecodeTable(tables.codes, tables.decode);
+  return tables;
+}
+
+#if __cplusplus >= 202002L
+/**
+ * Igual a makeTables, mas obrigatoriamente avaliada na compilação: as
+ * tabelas vão para .rodata e nenhuma árvore é construída em execução.
+ */
+template <std::size_t AlphabetSize, unsigned MaxBits>
+consteval Tables<AlphabetSize, MaxBits>
+compileTables(const Histogram<AlphabetSize> &freq)
+{
+  return makeTables<AlphabetSize, MaxBits>(freq);
+}
+#endif
+
+/**
+ * Confere as tabelas contra o histograma, para uso em static_assert:
+ * - todo símbolo presente tem código de 1 a MaxBits bits, e só eles;
+ * - os comprimentos satisfazem a desigualdade de Kraft com igualdade
+ *   (código completo) quando há dois ou mais símbolos;
+ * - cada código, percorrido na árvore, leva de volta ao próprio símbolo.
+ *
+ * @param tables Tabelas geradas por makeTables.
+ * @param freq Histograma usado para gerá-las.
+ * @return true se tudo confere.
+ */
+template <std::size_t AlphabetSize, unsigned MaxBits>
+constexpr bool verifyTables(const Tables<AlphabetSize, MaxBits> &tables,
+                            const Histogram<AlphabetSize> &freq)
+{
+  using Table = DecodeTable<AlphabetSize>;
+  std::uint64_t kraft = 0;
+  std::size_t symbols = 0;
+
+  if (!tables.valid)
+    return false;
+
+  for (std::size_t i = 0; i < AlphabetSize; ++i)
+  {
+    unsigned len = tables.codes.len[i];
+
+    if ((freq[i] == 0) != (len == 0) || len > MaxBits)
+      return false;
+    if (len == 0)
+      continue;
+    symbols++;
+    kraft += std::uint64_t{1} << (MaxBits - len);
+
+    std::uint16_t node = 0;
+    for (unsigned j = len; j-- > 0;)
+    {
+      unsigned bit = (tables.codes.bits[i] >> j) & 1;
+      std::uint16_t next = tables.decode.child[node][bit];
+      if (next == Table::noNode || ((next & Table::leaf) != 0) != (j == 0))
+        return false;
+      node = next;
+    }
+    if (node != (Table::leaf | i))
+      return false;
+  }
+
+  return symbols < 2 || kraft == (std::uint64_t{1} << MaxBits);
+}
+
+// Codificador com alfabeto e comprimento máximo fixados na compilação
+template <std::size_t AlphabetSize, unsigned MaxBits>
+class Encoder
+{
+public:
+  using Table = CodeTable<AlphabetSize, MaxBits>;
+
+  constexpr explicit Encoder(const Table &table) : codes(table) {}
+
+  constexpr explicit Encoder(const Tables<AlphabetSize, MaxBits> &tables)
+      : codes(tables.codes)
+  {
+  }
+
+  /**
+   * @param size Tamanho da entrada.
+   * @return Bytes suficientes para codificar qualquer entrada de size bytes.
+   */
+  static constexpr std::size_t bound(std::size_t size)
+  {
+    return (size * MaxBits + 7) / 8;
+  }
+
+  /**
+   * @param freq Histograma da entrada.
+   * @return Tamanho exato da saída de encode, em bits.
+   */
+  constexpr std::uint64_t encodedBits(const Histogram<AlphabetSize> &freq) const
+  {
+    std::uint64_t bits = 0;
+
+    for (std::size_t i = 0; i < AlphabetSize; ++i)
+      bits += std::uint64_t{freq[i]} * codes.len[i];
+    return bits;
+  }
+
+  /**
+   * Codifica um buffer inteiro, o mais significativo primeiro, sem
+   * verificar limites a cada símbolo.
+   *
+   * Pré-condições: todo símbolo de in é menor que AlphabetSize e tem código,
+   * e out tem ao menos bound(size) bytes.
+   *
+   * @param in Dados de entrada.
+   * @param size Tamanho da entrada.
+   * @param out Buffer de saída.
+   * @return Bits escritos; o último byte é completado com zeros.
+   */
+  std::uint64_t encode(const unsigned char *in, std::size_t size,
+                       unsigned char *out) const
+  {
+    // Símbolos que sempre cabem no acumulador com até 7 bits pendentes
+    constexpr std::size_t perFlush = (64 - 7) / MaxBits;
+    std::uint64_t buffer = 0;
+    unsigned count = 0;
+    unsigned char *p = out;
+    std::size_t i = 0;
+
+    for (; i + perFlush <= size; i += perFlush)
+    {
+      for (std::size_t k = 0; k < perFlush; ++k)
+      {
+        unsigned char c = in[i + k];
+        buffer = (buffer << codes.len[c]) | codes.bits[c];
+        count += codes.len[c];
+      }
+      while (count >= 8)
+      {
+        count -= 8;
+        *p++ = static_cast<unsigned char>(buffer >> count);
+      }
+    }
+
+    for (; i < size; ++i)
+    {
+      unsigned char c = in[i];
+      buffer = (buffer << codes.len[c]) | codes.bits[c];
+      count += codes.len[c];
+      while (count >= 8)
+      {
+        count -= 8;
+        *p++ = static_cast<unsigned char>(buffer >> count);
+      }
+    }
+
+    if (count > 0)
+      *p++ = static_cast<unsigned char>(buffer << (8 - count));
+    return 8 * static_cast<std::uint64_t>(p - out) - (8 - count) % 8;
+  }
+
+private:
+  Table codes;
+};
+
+// Decodificador com alfabeto e comprimento máximo fixados na compilação
+template <std::size_t AlphabetSize, unsigned MaxBits>
+class Decoder
+{
+public:
+  using Table = DecodeTable<AlphabetSize>;
+
+  constexpr explicit Decoder(const CodeTable<AlphabetSize, MaxBits> &codes)
+      : ok(buildDecodeTable(codes, tree))
+  {
+  }
+
+  // Usa a árvore já pronta (ex: de compileTables), sem construí-la de novo
+  constexpr explicit Decoder(const Tables<AlphabetSize, MaxBits> &tables)
+      : tree(tables.decode), ok(tables.valid)
+  {
+  }
+
+  // false se os códigos usados na construção eram inválidos
+  constexpr bool valid() const { return ok; }
+
+  /**
+   * Decodifica exatamente count símbolos. Bits após o último símbolo
+   * (preenchimento) são ignorados.
+   *
+   * @param in Dados comprimidos.
+   * @param inSize Tamanho de in.
+   * @param out Buffer de saída, com ao menos count bytes.
+   * @param count Quantidade de símbolos.
+   * @return false se a entrada acabar antes ou tiver um código inválido.
+   */
+  bool decode(const unsigned char *in, std::size_t inSize, unsigned char *out,
+              std::size_t count) const
+  {
+    const std::uint64_t totalBits = std::uint64_t{inSize} * 8;
+    std::uint64_t bitPos = 0;
+
+    if (!ok)
+      return false;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      std::uint16_t node = 0;
+      std::uint16_t next = Table::noNode;
+
+      // Nenhum código passa de MaxBits níveis
+      for (unsigned level = 0; level < MaxBits; ++level)
+      {
+        if (bitPos == totalBits)
+          return false;
+        unsigned bit = (in[bitPos >> 3] >> (7 - (bitPos & 7))) & 1;
+        bitPos++;
+
+        next = tree.child[node][bit];
+        if (next == Table::noNode || (next & Table::leaf))
+          break;
+        node = next;
+      }
+
+      if (next == Table::noNode || !(next & Table::leaf))
+        return false;
+      out[i] = static_cast<unsigned char>(next & 0xFF);
+    }
+    return true;
+  }
+
+private:
+  Table tree{};
+  bool ok;
+};
+
+} // namespace huffman
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Algoritmo de Codificação de Huffman - Recursos constantes comprimidos
+ *
+ * Descrição:
+ * Descompressão na placa dos recursos gerados por huffman_pack.c. O corpo
+ * HUFFMAN é decodificado com a tabela canônica (HuffmanCanonicalTable), sem
+ * árvore nem tabela de consulta: além do buffer de saída, a RAM usada é a
+ * da tabela e de um byte por símbolo na pilha durante a montagem.
+ */
+#include <string.h>
+#include "huffman_asset.h"
+#include "huffman_frame.h"
+
+static struct HuffmanCanonicalTable canonical;
+
+/**
+ * Decodifica o corpo de um bloco HUFF_BLOCK_HUFFMAN.
+ *
+ * @param body Início do corpo (tabela de comprimentos).
+ * @param info Campos do cabeçalho.
+ * @param out Buffer de saída, com ao menos info->rawSize bytes.
+ * @return 0 em caso de sucesso, -1 se o corpo for inválido.
+ */
+static int unpackHuffman(const unsigned char *body,
+                         const struct HuffmanBlockInfo *info, char *out)
+{
+  unsigned char len[HUFF_ALPHABET_SIZE] = {0};
+  unsigned long tableSize;
+  unsigned long dataSize;
+  long long bits;
+  int symbols;
+
+  if (info->compressedSize == 0)
+    return -1;
+  symbols = body[0] ? body[0] : 256;
+  tableSize = 1 + (symbols + 1) / 2;
+  if (symbols > HUFF_ALPHABET_SIZE || tableSize > info->compressedSize)
+    return -1;
+
+  for (int i = 0; i < symbols; ++i)
+    len[i] = (body[1 + i / 2] >> (i % 2 ? 0 : 4)) & 0x0F;
+  if (buildCanonicalTable(len, &canonical) != 0)
+    return -1;
+
+  dataSize = info->compressedSize - tableSize;
+  bits = huffmanDecodeCanonical(&canonical, body + tableSize, dataSize, out,
+                                info->rawSize);
+
+  // Só podem sobrar os bits de preenchimento anunciados no cabeçalho
+  if (bits < 0 || (unsigned long long)bits +
+                          (info->flags & HUFF_BLOCK_PADDING_MASK) !=
+                      8ull * dataSize)
+    return -1;
+  return 0;
+}
+
+long huffmanAssetUnpack(const struct HuffmanAsset *asset, char *out,
+                        unsigned long outSize)
+{
+  const unsigned char *body = asset->data + HUFF_BLOCK_HEADER_SIZE;
+  struct HuffmanBlockInfo info;
+
+  // O tamanho declarado no .c gerado deve bater com o do bloco
+  if (huffmanBlockParse(asset->data, asset->size, &info) != 0 ||
+      huffmanBlockVerify(asset->data, &info) != 0 ||
+      info.rawSize != asset->rawSize || info.rawSize > outSize)
+    return -1;
+
+  // huffman_pack.c só gera estes tipos
+  switch (info.type)
+  {
+  case HUFF_BLOCK_HUFFMAN:
+    if (unpackHuffman(body, &info, out) != 0)
+      return -1;
+    break;
+  case HUFF_BLOCK_STORED:
+    if (info.compressedSize != info.rawSize)
+      return -1;
+    memcpy(out, body, info.rawSize);
+    break;
+  case HUFF_BLOCK_RLE:
+    if (info.compressedSize != 1)
+      return -1;
+    memset(out, body[0], info.rawSize);
+    break;
+  default:
+    return -1;
+  }
+  return (long)info.rawSize;
+}
@@ -0,0 +1,36 @@
+/*
+ * Algoritmo de Codificação de Huffman - Recursos constantes comprimidos
+ *
+ * Descrição:
+ * Strings e tabelas constantes são comprimidas no host por huffman_pack.c,
+ * que gera um arquivo .c com um bloco (ver huffman_frame.h) e a descrição
+ * do recurso. No microcontrolador o recurso fica na flash comprimido e é
+ * descomprimido para a RAM só quando for usado.
+ *
+ * O gerador deve ser compilado com o mesmo perfil do firmware
+ * (-DHUFF_PROFILE=...), para que alfabeto e comprimento máximo de código
+ * sejam compatíveis com o decodificador da placa.
+ */
+#ifndef HUFFMAN_ASSET_H
+#define HUFFMAN_ASSET_H
+
+// Recurso comprimido gerado por huffman_pack.c
+struct HuffmanAsset
+{
+  const unsigned char *data; // Bloco comprimido (na flash)
+  unsigned long size;        // Tamanho do bloco
+  unsigned long rawSize;     // Tamanho descomprimido
+};
+
+/**
+ * Descomprime um recurso inteiro.
+ *
+ * @param asset Recurso gerado por huffman_pack.c.
+ * @param out Buffer de saída, com ao menos asset->rawSize bytes.
+ * @param outSize Capacidade do buffer de saída.
+ * @return Tamanho descomprimido, ou -1 se o recurso for inválido ou não couber.
+ */
+long huffmanAssetUnpack(const struct HuffmanAsset *asset, char *out,
+                        unsigned long outSize);
+
+#endif
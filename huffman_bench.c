@@ -0,0 +1,612 @@
+/*
+ * Algoritmo de Codificação de Huffman - Benchmark de decodificação
+ *
+ * Descrição:
+ * Ferramenta de host que mede a vazão de huffmanBlockDecode em cada caminho
+ * de huffman_cpu.c (portable, x86-64, bmi2, avx2), para um bloco HUFFMAN
+ * (um fluxo) e um bloco STREAMS (8 fluxos intercalados) com o mesmo
+ * conteúdo. Sem arquivo, usa um corpus sintético de telemetria (linhas
+ * "T=..,H=..,P=..,V=..").
+ *
+ * Em x86-64, compara ainda a tabela de um símbolo por consulta com a de
+ * vários símbolos, em histogramas concentrado, plano e no do corpus, e
+ * varia a largura da tabela primária de 8 a 12 bits (mais a automática e a
+ * de um nível só) para mostrar o custo de sair do cache L1.
+ *
+ * Compara também o modelo de ordem 0 com os blocos de várias tabelas de
+ * huffman_context.c (ordem 1 e tabelas por segmento) e com a divisão
+ * automática de huffmanSplitEncode, com o LZ77 de huffman_lz.c nos três
+ * níveis e com a BWT de huffman_bwt.c, em razão de compressão e vazão, com
+ * blocos de 4 KB, 64 KB e da entrada inteira (até HUFF_BWT_MAX_BLOCK), no
+ * corpus e num arquivo misto (trechos do corpus
+ * alternados com trechos binários).
+ *
+ * Uso:
+ * gcc -O2 huffman_bench.c huffman.c huffman_encode.c huffman_decode.c huffman_frame.c huffman_frame_decode.c huffman_cpu.c huffman_bitio.c huffman_coder.c huffman_context.c huffman_lz.c huffman_bwt.c huffman_blocks.c -o huffman_bench
+ * ./huffman_bench [corpus.txt]
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "huffman_blocks.h"
+#include "huffman_cpu.h"
+
+#define MAX_INPUT (1024 * 1024)
+#define MIN_SECONDS 0.5
+
+static char input[MAX_INPUT];
+static char output[MAX_INPUT];
+static unsigned char single[HUFF_BLOCK_HEADER_SIZE + MAX_INPUT + HUFF_BLOCK_CRC_SIZE];
+static unsigned char streams[HUFF_BLOCK_HEADER_SIZE + MAX_INPUT + HUFF_BLOCK_CRC_SIZE];
+static char synthetic[MAX_INPUT];
+static unsigned char coded[MAX_INPUT * 2];
+static unsigned freq[HUFF_ALPHABET_SIZE];
+static struct HuffmanCodeTable codes;
+static struct HuffmanAnyWork work;
+static struct HuffmanSplitWork splitWork;
+static struct HuffmanTreeWork treeWork;
+static struct HuffmanKernelWork kernelWork;
+
+// Conjuntos de recursos medidos, do mais simples ao mais completo
+static const struct
+{
+  const char *name;
+  unsigned mask;
+} paths[] = {
+    {"portable", 0},
+    {"x86-64", HUFF_CPU_X86_64},
+    {"bmi2", HUFF_CPU_X86_64 | HUFF_CPU_BMI2},
+    {"avx2", HUFF_CPU_X86_64 | HUFF_CPU_BMI2 | HUFF_CPU_AVX2},
+};
+
+// Gerador congruente linear: o corpus sintético é sempre o mesmo
+static unsigned long nextRandom(unsigned long *state)
+{
+  *state = (*state * 1103515245ul + 12345ul) & 0x7FFFFFFF;
+  return *state >> 8;
+}
+
+/**
+ * Preenche input com leituras de sensores em texto, variando devagar como
+ * uma telemetria real.
+ *
+ * @return Tamanho gerado.
+ */
+static unsigned long makeTelemetry(void)
+{
+  unsigned long state = 1;
+  unsigned long size = 0;
+  long temperature = 2350, humidity = 550, pressure = 10132, voltage = 330;
+  char line[64];
+
+  for (;;)
+  {
+    temperature += (long)(nextRandom(&state) % 21) - 10;
+    humidity += (long)(nextRandom(&state) % 7) - 3;
+    pressure += (long)(nextRandom(&state) % 5) - 2;
+    voltage += (long)(nextRandom(&state) % 3) - 1;
+
+    int length = snprintf(line, sizeof(line), "T=%ld.%02ld,H=%ld.%ld,P=%ld.%ld,V=%ld.%02ld\n",
+                          temperature / 100, temperature % 100, humidity / 10,
+                          humidity % 10, pressure / 10, pressure % 10,
+                          voltage / 100, voltage % 100);
+    if (size + (unsigned long)length > MAX_INPUT)
+      return size;
+    memcpy(input + size, line, (size_t)length);
+    size += (unsigned long)length;
+  }
+}
+
+/**
+ * Decodifica o bloco repetidas vezes por ao menos MIN_SECONDS.
+ *
+ * @return Vazão em MB/s (dados originais), ou -1 se a saída não conferir.
+ */
+static double measure(const unsigned char *block, long blockSize,
+                      unsigned long size)
+{
+  unsigned long runs = 0;
+  clock_t start = clock();
+  clock_t elapsed;
+
+  do
+  {
+    if (huffmanBlockDecode(&work.bwt.context.decode, block,
+                           (unsigned long)blockSize, output,
+                           sizeof(output)) != (long)size)
+      return -1;
+    runs++;
+    elapsed = clock() - start;
+  } while (elapsed < MIN_SECONDS * CLOCKS_PER_SEC);
+
+  if (memcmp(input, output, size) != 0)
+    return -1;
+  return (double)size * runs / (1024.0 * 1024.0) /
+         ((double)elapsed / CLOCKS_PER_SEC);
+}
+
+/**
+ * Alterna trechos de 1 a 6 KB do corpus com trechos binários, de bytes
+ * concentrados nos valores baixos, como um arquivo de conteúdo misto.
+ *
+ * @return Tamanho gerado.
+ */
+static unsigned long makeMixed(unsigned long corpusSize)
+{
+  unsigned long state = 13;
+  unsigned long size = 0;
+  unsigned long from = 0;
+  int binary = 0;
+
+  while (size < MAX_INPUT)
+  {
+    unsigned long length = 1024 + nextRandom(&state) % 5120;
+    if (length > MAX_INPUT - size)
+      length = MAX_INPUT - size;
+
+    for (unsigned long i = 0; i < length; ++i)
+    {
+      if (binary)
+        synthetic[size + i] = (char)((nextRandom(&state) % 16) *
+                                     (nextRandom(&state) % 16) %
+                                     HUFF_ALPHABET_SIZE);
+      else
+        synthetic[size + i] = input[from++ % corpusSize];
+    }
+    size += length;
+    binary = !binary;
+  }
+  return size;
+}
+
+// Assinatura comum dos codificadores comparados, sem a memória de trabalho
+typedef long (*BlockEncoder)(const char *in, unsigned long size,
+                             unsigned char *out, unsigned long outSize,
+                             int flags);
+
+// Codificadores de cada modelo com a memória de trabalho do benchmark
+static long order0(const char *in, unsigned long size, unsigned char *out,
+                   unsigned long outSize, int flags)
+{
+  return huffmanBlockEncode(&work.bwt.context.block, in, size, out, outSize,
+                            flags);
+}
+
+static long order1(const char *in, unsigned long size, unsigned char *out,
+                   unsigned long outSize, int flags)
+{
+  return huffmanContextEncode(&work.bwt.context, in, size, out, outSize,
+                              flags);
+}
+
+static long segments(const char *in, unsigned long size, unsigned char *out,
+                     unsigned long outSize, int flags)
+{
+  return huffmanSegmentsEncode(&work.bwt.context, in, size, out, outSize,
+                               flags);
+}
+
+static long split(const char *in, unsigned long size, unsigned char *out,
+                  unsigned long outSize, int flags)
+{
+  return huffmanSplitEncode(&splitWork, in, size, out, outSize, flags);
+}
+
+static long lzFast(const char *in, unsigned long size, unsigned char *out,
+                   unsigned long outSize, int flags)
+{
+  return huffmanLzEncode(&work.lz, in, size, out, outSize, flags,
+                         HUFF_LZ_FAST);
+}
+
+static long lzDefault(const char *in, unsigned long size, unsigned char *out,
+                      unsigned long outSize, int flags)
+{
+  return huffmanLzEncode(&work.lz, in, size, out, outSize, flags,
+                         HUFF_LZ_DEFAULT);
+}
+
+static long lzBest(const char *in, unsigned long size, unsigned char *out,
+                   unsigned long outSize, int flags)
+{
+  return huffmanLzEncode(&work.lz, in, size, out, outSize, flags,
+                         HUFF_LZ_BEST);
+}
+
+static long bwt(const char *in, unsigned long size, unsigned char *out,
+                unsigned long outSize, int flags)
+{
+  return huffmanBwtEncode(&work.bwt, in, size, out, outSize, flags);
+}
+
+/**
+ * Comprime data em coded, em blocos de até blockSize bytes.
+ *
+ * @return Tamanho do arquivo gerado, ou 0 se algum bloco falhar.
+ */
+static unsigned long encodeArchive(BlockEncoder encoder, const char *data,
+                                   unsigned long size, unsigned long blockSize)
+{
+  unsigned long total = 0;
+
+  for (unsigned long pos = 0; pos < size; pos += blockSize)
+  {
+    unsigned long length = size - pos < blockSize ? size - pos : blockSize;
+    long written = encoder(data + pos, length, coded + total,
+                           sizeof(coded) - total, 0);
+    if (written < 0)
+      return 0;
+    total += (unsigned long)written;
+  }
+  return total;
+}
+
+/**
+ * Decodifica o arquivo em coded, bloco a bloco, com huffmanDecodeAnyBlock.
+ *
+ * @return Tamanho descomprimido, ou 0 se algum bloco for inválido.
+ */
+static unsigned long decodeArchive(unsigned long archiveSize)
+{
+  unsigned long total = 0;
+  struct HuffmanBlockInfo info;
+
+  for (unsigned long pos = 0; pos < archiveSize; pos += info.blockSize)
+  {
+    if (huffmanBlockParse(coded + pos, archiveSize - pos, &info) != 0)
+      return 0;
+    long length = huffmanDecodeAnyBlock(&work, coded + pos, info.blockSize,
+                                        output + total, sizeof(output) - total);
+    if (length < 0)
+      return 0;
+    total += (unsigned long)length;
+  }
+  return total;
+}
+
+/**
+ * Compara o modelo de ordem 0 (uma tabela por bloco) com o de ordem 1
+ * (tabelas por grupo de contextos), com as tabelas por segmento, com a
+ * divisão automática em blocos, com o LZ77 e com a BWT, em tamanho e vazão,
+ * para alguns tamanhos de bloco: as tabelas extras, a janela do LZ77 e os
+ * contextos da BWT só compensam em blocos maiores.
+ *
+ * @return 0 em caso de sucesso, -1 se alguma saída não conferir.
+ */
+static int compareModels(const char *name, const char *data,
+                         unsigned long size)
+{
+  static const struct
+  {
+    const char *name;
+    BlockEncoder encoder;
+  } models[] = {
+      {"ordem 0", order0},
+      {"ordem 1", order1},
+      {"segmentos", segments},
+      {"divisao", split},
+      {"lz rapido", lzFast},
+      {"lz padrao", lzDefault},
+      {"lz melhor", lzBest},
+      {"bwt", bwt},
+  };
+  const unsigned long blockSizes[] = {
+      4096, 65536, size < HUFF_BWT_MAX_BLOCK ? size : HUFF_BWT_MAX_BLOCK};
+
+  for (unsigned b = 0; b < sizeof(blockSizes) / sizeof(blockSizes[0]); ++b)
+  {
+    for (unsigned m = 0; m < sizeof(models) / sizeof(models[0]); ++m)
+    {
+      unsigned long archiveSize = 0;
+      unsigned long runs = 0;
+      clock_t start = clock();
+      clock_t encodeTime, decodeTime;
+
+      do
+      {
+        archiveSize = encodeArchive(models[m].encoder, data, size,
+                                    blockSizes[b]);
+        if (archiveSize == 0)
+          return -1;
+        runs++;
+        encodeTime = clock() - start;
+      } while (encodeTime < MIN_SECONDS * CLOCKS_PER_SEC);
+      double encodeRate = (double)size * runs / (1024.0 * 1024.0) /
+                          ((double)encodeTime / CLOCKS_PER_SEC);
+
+      runs = 0;
+      start = clock();
+      do
+      {
+        if (decodeArchive(archiveSize) != size)
+          return -1;
+        runs++;
+        decodeTime = clock() - start;
+      } while (decodeTime < MIN_SECONDS * CLOCKS_PER_SEC);
+      if (memcmp(data, output, size) != 0)
+        return -1;
+      double decodeRate = (double)size * runs / (1024.0 * 1024.0) /
+                          ((double)decodeTime / CLOCKS_PER_SEC);
+
+      printf("%-8s %-8lu %-10s %10lu %6.3f %12.1f %12.1f\n", name,
+             blockSizes[b], models[m].name, archiveSize,
+             (double)archiveSize / size, encodeRate, decodeRate);
+    }
+  }
+  return 0;
+}
+
+#ifdef HUFF_X86_64
+/**
+ * Decodifica o fluxo com o kernel dado repetidas vezes por MIN_SECONDS.
+ *
+ * @return Vazão em MB/s, ou -1 se a saída não conferir.
+ */
+static double measureKernel(HuffmanDecodeKernel kernel, const char *data,
+                            unsigned long size, unsigned long long bits)
+{
+  unsigned long runs = 0;
+  clock_t start = clock();
+  clock_t elapsed;
+
+  do
+  {
+    if (kernel(&kernelWork, &codes, 0, coded, (unsigned long)((bits + 7) / 8),
+               output, size) != (long long)bits)
+      return -1;
+    runs++;
+    elapsed = clock() - start;
+  } while (elapsed < MIN_SECONDS * CLOCKS_PER_SEC);
+
+  if (memcmp(data, output, size) != 0)
+    return -1;
+  return (double)size * runs / (1024.0 * 1024.0) /
+         ((double)elapsed / CLOCKS_PER_SEC);
+}
+
+/**
+ * Compara a decodificação com um e com vários símbolos por consulta.
+ *
+ * @return 0 em caso de sucesso, -1 se alguma saída não conferir.
+ */
+static int compareTables(const char *name, const char *data, unsigned long size)
+{
+  static const struct
+  {
+    const char *name;
+    HuffmanDecodeKernel single;
+    HuffmanDecodeKernel multi;
+    unsigned required;
+  } kernels[] = {
+      {"x86-64", huffmanDecode64, huffmanDecodeMulti64, HUFF_CPU_X86_64},
+      {"bmi2", huffmanDecodeBmi2, huffmanDecodeMultiBmi2,
+       HUFF_CPU_X86_64 | HUFF_CPU_BMI2},
+  };
+  unsigned long long bits;
+  double average = 0;
+
+  memset(freq, 0, sizeof(freq));
+  if (calculateFrequencyInChunks(data, freq, (int)size, 1000) != 0)
+    return -1;
+  buildCodeTable(&treeWork, freq, &codes);
+  bits = huffmanEncodeBuffer(&codes, data, size, coded);
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    average += (double)freq[i] * codes.len[i] / size;
+
+  for (unsigned i = 0; i < sizeof(kernels) / sizeof(kernels[0]); ++i)
+  {
+    if ((huffmanCpuFeatures() & kernels[i].required) != kernels[i].required)
+      continue;
+
+    double single = measureKernel(kernels[i].single, data, size, bits);
+    double multi = measureKernel(kernels[i].multi, data, size, bits);
+    if (single < 0 || multi < 0)
+      return -1;
+    printf("%-10s %5.2f %-10s %12.1f %12.1f %7.2fx\n", name, average,
+           kernels[i].name, single, multi, multi / single);
+  }
+  return 0;
+}
+
+// Histograma concentrado: cada símbolo tem metade da chance do anterior
+static void makeSkewed(unsigned long size)
+{
+  unsigned long state = 7;
+
+  for (unsigned long i = 0; i < size; ++i)
+  {
+    unsigned long r = nextRandom(&state);
+    int symbol = 'a';
+    while ((r & 1) && symbol < 'a' + 20)
+    {
+      r >>= 1;
+      symbol++;
+    }
+    synthetic[i] = (char)symbol;
+  }
+}
+
+// Histograma de Zipf: o símbolo k tem chance proporcional a 1 / (k + 1)^2,
+// o que gera códigos de até HUFF_MAX_CODE_LEN bits
+static void makeZipf(unsigned long size)
+{
+  static unsigned long cumulative[HUFF_ALPHABET_SIZE];
+  unsigned long state = 13;
+  unsigned long total = 0;
+
+  for (int k = 0; k < HUFF_ALPHABET_SIZE; ++k)
+  {
+    total += 1000000000ul / ((unsigned long)(k + 1) * (unsigned long)(k + 1));
+    cumulative[k] = total;
+  }
+
+  for (unsigned long i = 0; i < size; ++i)
+  {
+    unsigned long r = ((nextRandom(&state) << 23) | nextRandom(&state)) % total;
+    int k = 0;
+    while (cumulative[k] <= r)
+      k++;
+    synthetic[i] = (char)k;
+  }
+}
+
+/**
+ * Mede o kernel de um símbolo por consulta com cada largura de tabela
+ * primária.
+ *
+ * @return 0 em caso de sucesso, -1 se alguma saída não conferir.
+ */
+static int sweepWidths(const char *name, const char *data, unsigned long size)
+{
+  HuffmanDecodeKernel kernel =
+      (huffmanCpuFeatures() & HUFF_CPU_BMI2) ? huffmanDecodeBmi2 : huffmanDecode64;
+  unsigned long long bits;
+  int longest = 0;
+
+  memset(freq, 0, sizeof(freq));
+  if (calculateFrequencyInChunks(data, freq, (int)size, 1000) != 0)
+    return -1;
+  buildCodeTable(&treeWork, freq, &codes);
+  bits = huffmanEncodeBuffer(&codes, data, size, coded);
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (codes.len[i] > longest)
+      longest = codes.len[i];
+  }
+
+  printf("%s (maior codigo: %d bits)\n", name, longest);
+  for (int width = 7; width <= 13; ++width)
+  {
+    // 7 = automática, 13 = um nível só (largura do maior código)
+    int forced = width == 7 ? 0 : width == 13 ? longest : width;
+    char label[16];
+    double rate;
+
+    // Larguras a partir do maior código já são a tabela de um nível
+    if (width != 13 && forced >= longest)
+      continue;
+
+    huffmanSetLookupBits(&kernelWork, (unsigned)forced);
+    rate = measureKernel(kernel, data, size, bits);
+    if (rate < 0)
+      return -1;
+    if (forced == 0)
+    {
+      printf("  %-14s %9s %12.1f\n", "automatica", "-", rate);
+      continue;
+    }
+    if (width == 13)
+      snprintf(label, sizeof(label), "um nivel %d", forced);
+    else
+      snprintf(label, sizeof(label), "%d", forced);
+    printf("  %-14s %6.1f KB %12.1f\n", label, (4 << forced) / 1024.0, rate);
+  }
+  huffmanSetLookupBits(&kernelWork, 0);
+  return 0;
+}
+
+// Histograma plano: todos os símbolos do alfabeto com a mesma chance
+static void makeFlat(unsigned long size)
+{
+  unsigned long state = 11;
+
+  for (unsigned long i = 0; i < size; ++i)
+    synthetic[i] = (char)(nextRandom(&state) % HUFF_ALPHABET_SIZE);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+  unsigned long size;
+  long singleSize, streamsSize;
+
+  if (argc > 2)
+  {
+    fprintf(stderr, "Uso: %s [corpus]\n", argv[0]);
+    return 1;
+  }
+
+  if (argc == 2)
+  {
+    FILE *file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+      fprintf(stderr, "Nao foi possivel abrir %s\n", argv[1]);
+      return 1;
+    }
+    size = (unsigned long)fread(input, 1, MAX_INPUT, file);
+    fclose(file);
+  }
+  else
+  {
+    size = makeTelemetry();
+  }
+
+  singleSize = order0(input, size, single, sizeof(single), 0);
+  streamsSize = order0(input, size, streams, sizeof(streams),
+                       HUFF_BLOCK_FLAG_STREAMS);
+  if (singleSize < 0 || streamsSize < 0 || single[3] != HUFF_BLOCK_HUFFMAN ||
+      streams[3] != HUFF_BLOCK_STREAMS)
+  {
+    fprintf(stderr, "A entrada nao gerou blocos HUFFMAN\n");
+    return 1;
+  }
+
+  printf("Entrada: %lu bytes, HUFFMAN: %ld bytes, STREAMS: %ld bytes\n", size,
+         singleSize, streamsSize);
+  printf("%-10s %-10s %12s %-10s %12s\n", "Caminho", "decode", "MB/s",
+         "streams", "MB/s");
+
+  for (unsigned i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i)
+  {
+    const struct HuffmanKernels *kernels;
+
+    huffmanSetCpuFeatures(paths[i].mask);
+    kernels = huffmanKernels();
+
+    // Caminhos que a CPU não tem cairiam no anterior: não repete a medida
+    if (kernels->features != paths[i].mask)
+      continue;
+
+    double singleRate = measure(single, singleSize, size);
+    double streamsRate = measure(streams, streamsSize, size);
+    if (singleRate < 0 || streamsRate < 0)
+    {
+      fprintf(stderr, "%s: saida nao confere\n", paths[i].name);
+      return 1;
+    }
+    printf("%-10s %-10s %12.1f %-10s %12.1f\n", paths[i].name,
+           kernels->decodeName, singleRate, kernels->decodeStreamsName,
+           streamsRate);
+  }
+
+  huffmanSetCpuFeatures(~0u);
+  printf("\n%-8s %-8s %-10s %10s %6s %12s %12s\n", "Entrada", "Bloco",
+         "Modelo", "Tamanho", "Razao", "Cod. MB/s", "Dec. MB/s");
+  if (compareModels("corpus", input, size) != 0 ||
+      compareModels("misto", synthetic, makeMixed(size)) != 0)
+  {
+    fprintf(stderr, "Varias tabelas: saida nao confere\n");
+    return 1;
+  }
+
+#ifdef HUFF_X86_64
+  printf("\n%-10s %5s %-10s %12s %12s %8s\n", "Histograma", "bits",
+         "Kernel", "1 simb MB/s", "N simb MB/s", "Ganho");
+  makeSkewed(MAX_INPUT);
+  if (compareTables("concentr.", synthetic, MAX_INPUT) != 0)
+    return 1;
+  makeFlat(MAX_INPUT);
+  if (compareTables("plano", synthetic, MAX_INPUT) != 0)
+    return 1;
+  if (compareTables("corpus", input, size) != 0)
+    return 1;
+
+  printf("\n%-16s %9s %12s\n", "Tabela primaria", "Tamanho", "MB/s");
+  makeZipf(MAX_INPUT);
+  if (sweepWidths("zipf", synthetic, MAX_INPUT) != 0 ||
+      sweepWidths("corpus", input, size) != 0)
+    return 1;
+#endif
+  return 0;
+}
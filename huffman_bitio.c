@@ -0,0 +1,657 @@
+/*
+ * Algoritmo de Codificação de Huffman - E/S de bits em 64 bits (x86-64)
+ *
+ * Descrição:
+ * Kernels de codificação e decodificação para hosts x86-64, escolhidos por
+ * huffman_cpu.c. Os bits ficam em um contêiner de 64 bits, gravado e
+ * recarregado com acessos não alinhados de 8 bytes, em vez de um byte por
+ * vez. A decodificação consulta uma tabela (símbolo e comprimento) com os
+ * próximos bits, em vez de descer a árvore bit a bit.
+ *
+ * A tabela tem dois níveis: uma primária de 2^p entradas, com p entre 8 e
+ * 12, resolve os códigos de até p bits, e os prefixos dos códigos mais
+ * longos apontam para tabelas secundárias com os bits restantes. Uma tabela
+ * única de 2^15 entradas ocuparia 128 KB, muito além do cache L1; p é o
+ * menor valor em que os códigos longos somam menos de 1/64 da probabilidade
+ * implícita nos comprimentos, de modo que o segundo nível quase nunca é
+ * consultado.
+ *
+ * Quando os códigos são curtos (histograma concentrado), uma segunda tabela
+ * de até 2^12 entradas guarda até 3 símbolos por entrada, com o total de
+ * bits, e resolve vários códigos por consulta. É o kernel usado pelo
+ * dispatcher; com códigos longos demais ele volta à tabela de um símbolo.
+ *
+ * Cada kernel é compilado duas vezes: uma para o x86-64 básico e outra com
+ * target("bmi2"), em que os deslocamentos variáveis viram shlx/shrx (sem
+ * dependência de flags nem do registrador cl).
+ *
+ * Para blocos em HUFF_STREAMS fluxos há ainda um kernel AVX2: cada pista de
+ * 32 bits acompanha um fluxo, lê a sua janela de bits com vpgatherdd e
+ * consulta as mesmas tabelas com outros gathers, decodificando 8 símbolos
+ * por iteração. O final de cada fluxo (onde a janela de 4 bytes passaria do
+ * limite) é terminado pelo kernel escalar.
+ *
+ * Em outras arquiteturas (ex: STM32F030) este arquivo fica vazio: a tabela
+ * de decodificação não caberia na RAM.
+ */
+#include <string.h>
+#include "huffman_cpu.h"
+
+#ifdef HUFF_X86_64
+
+#include <immintrin.h>
+
+#define HUFF_INLINE static inline __attribute__((always_inline))
+#define HUFF_AVX2_INLINE                                                       \
+  static inline __attribute__((always_inline, target("avx2")))
+
+// Símbolos que cabem no contêiner com até 7 bits pendentes
+#define HUFF_SYMBOLS_PER_FLUSH ((64 - 7) / HUFF_MAX_CODE_LEN)
+
+// Tabela de vários símbolos por consulta: largura mínima em bits (a máxima,
+// HUFF_MULTI_MAX_BITS, fica em huffman_cpu.h: 4096 entradas de 4 bytes
+// ainda cabem no cache L1) e símbolos por entrada
+#define HUFF_MULTI_MIN_BITS 11
+#define HUFF_MULTI_SYMBOLS 3
+
+// Faixa da largura automática da tabela primária
+#define HUFF_PRIMARY_MIN_BITS 8
+#define HUFF_PRIMARY_MAX_BITS 12
+
+// Entrada primária que aponta para uma tabela secundária: largura dela nos
+// bits 16-19 e posição em secondary nos bits 0-15
+#define HUFF_LOOKUP_LINK 0x80000000u
+
+HUFF_INLINE void storeBE64(unsigned char *p, unsigned long long value)
+{
+  value = __builtin_bswap64(value);
+  memcpy(p, &value, 8);
+}
+
+HUFF_INLINE unsigned long long loadBE64(const unsigned char *p)
+{
+  unsigned long long value;
+  memcpy(&value, p, 8);
+  return __builtin_bswap64(value);
+}
+
+HUFF_INLINE unsigned long long encode64(const struct HuffmanCodeTable *table,
+                                        const char in[], unsigned long size,
+                                        unsigned char out[])
+{
+  unsigned long long acc = 0;
+  unsigned count = 0;
+  unsigned char *p = out;
+  unsigned long i = 0;
+
+  // Cada símbolo gera ao menos 1 bit: com 64 símbolos ainda por vir, os 8
+  // bytes gravados de uma vez cabem na saída, mesmo que só parte seja válida
+  while (size - i >= HUFF_SYMBOLS_PER_FLUSH + 64)
+  {
+    for (int k = 0; k < HUFF_SYMBOLS_PER_FLUSH; ++k)
+    {
+      unsigned char c = (unsigned char)in[i + k];
+      acc = (acc << table->len[c]) | table->bits[c];
+      count += table->len[c];
+    }
+    i += HUFF_SYMBOLS_PER_FLUSH;
+
+    storeBE64(p, acc << (64 - count));
+    p += count >> 3;
+    count &= 7;
+  }
+
+  for (; i < size; ++i)
+  {
+    unsigned char c = (unsigned char)in[i];
+    acc = (acc << table->len[c]) | table->bits[c];
+    count += table->len[c];
+    while (count >= 8)
+    {
+      count -= 8;
+      *p++ = (unsigned char)(acc >> count);
+    }
+  }
+
+  if (count > 0)
+    *p++ = (unsigned char)(acc << (8 - count));
+  return 8ull * (unsigned long long)(p - out) - (8 - count) % 8;
+}
+
+/**
+ * Escolhe a largura da tabela primária: a menor em que os códigos mais
+ * longos que ela têm probabilidade (2^-len) abaixo de 1/64.
+ *
+ * @param codes Comprimentos do bloco.
+ * @param longest Maior comprimento do bloco.
+ * @return Largura, no máximo longest (tabela de um nível).
+ */
+static unsigned choosePrimaryBits(const struct HuffmanCodeTable *codes,
+                                  unsigned longest)
+{
+  unsigned bits;
+
+  for (bits = HUFF_PRIMARY_MIN_BITS; bits < HUFF_PRIMARY_MAX_BITS; ++bits)
+  {
+    unsigned long miss = 0;
+
+    for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    {
+      if (codes->len[i] > bits)
+        miss += 1ul << (HUFF_MAX_CODE_LEN - codes->len[i]);
+    }
+    if (miss * 64 < 1ul << HUFF_MAX_CODE_LEN)
+      break;
+  }
+  return bits < longest ? bits : longest;
+}
+
+// Refaz as tabelas de consulta se os comprimentos mudaram desde a última vez
+static void prepareLookup(struct HuffmanKernelWork *work,
+                          const struct HuffmanCodeTable *codes)
+{
+  unsigned bits = 1;
+  unsigned next = 0;
+  unsigned p;
+
+  if (work->lookupBits != 0 &&
+      memcmp(work->lookupLen, codes->len, sizeof(work->lookupLen)) == 0)
+    return;
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (codes->len[i] > bits)
+      bits = codes->len[i];
+  }
+  p = work->forcedBits == 0 ? choosePrimaryBits(codes, bits)
+      : work->forcedBits < bits ? work->forcedBits
+                          : bits;
+
+  // Largura de cada tabela secundária: o maior resto entre os códigos que
+  // começam com o prefixo
+  memset(work->prefixBits, 0, 1u << p);
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    unsigned len = codes->len[i];
+    if (len > p)
+    {
+      unsigned prefix = (unsigned)codes->bits[i] >> (len - p);
+      if (len - p > work->prefixBits[prefix])
+        work->prefixBits[prefix] = (unsigned char)(len - p);
+    }
+  }
+
+  memset(work->primary, 0, sizeof(work->primary[0]) << p);
+  for (unsigned prefix = 0; prefix < 1u << p; ++prefix)
+  {
+    if (work->prefixBits[prefix] == 0)
+      continue;
+    work->primary[prefix] =
+        HUFF_LOOKUP_LINK | ((unsigned)work->prefixBits[prefix] << 16) | next;
+    memset(work->secondary + next, 0,
+           sizeof(work->secondary[0]) << work->prefixBits[prefix]);
+    next += 1u << work->prefixBits[prefix];
+  }
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    unsigned len = codes->len[i];
+    unsigned entry = (len << 8) | (unsigned)i;
+    if (len == 0)
+      continue;
+
+    // Todas as entradas que começam com o código de i
+    if (len <= p)
+    {
+      unsigned first = (unsigned)codes->bits[i] << (p - len);
+      for (unsigned j = 0; j < 1u << (p - len); ++j)
+        work->primary[first + j] = entry;
+    }
+    else
+    {
+      unsigned prefix = (unsigned)codes->bits[i] >> (len - p);
+      unsigned width = work->prefixBits[prefix];
+      unsigned rest = (unsigned)codes->bits[i] & ((1u << (len - p)) - 1);
+      unsigned first =
+          (work->primary[prefix] & 0xFFFF) + (rest << (width - (len - p)));
+      for (unsigned j = 0; j < 1u << (width - (len - p)); ++j)
+        work->secondary[first + j] = (unsigned short)entry;
+    }
+  }
+  memcpy(work->lookupLen, codes->len, sizeof(work->lookupLen));
+  work->lookupBits = bits;
+  work->primaryBits = p;
+  work->multiReady = 0;
+}
+
+// Entrada (comprimento e símbolo) do código no topo de bitBuffer
+HUFF_INLINE unsigned lookupEntry(const struct HuffmanKernelWork *work,
+                                 unsigned long long bitBuffer)
+{
+  unsigned entry = work->primary[bitBuffer >> (64 - work->primaryBits)];
+
+  if (entry & HUFF_LOOKUP_LINK)
+    entry = work->secondary[(entry & 0xFFFF) +
+                            (unsigned)((bitBuffer << work->primaryBits) >>
+                                       (64 - ((entry >> 16) & 0x0F)))];
+  return entry;
+}
+
+/**
+ * Prepara a tabela de um símbolo e, a partir dela, a de vários símbolos:
+ * cada entrada resolve em sequência os códigos que cabem inteiros nos seus
+ * bits. Códigos mais longos que a tabela ficam com entrada vazia e são
+ * resolvidos pela tabela de um símbolo.
+ *
+ * @return Largura da tabela, ou 0 se os códigos forem longos demais para
+ *         caber mais de um por consulta (ex: histograma quase plano).
+ */
+static unsigned prepareMulti(struct HuffmanKernelWork *work,
+                             const struct HuffmanCodeTable *codes)
+{
+  unsigned long expected = 0;
+  unsigned width;
+
+  prepareLookup(work, codes);
+  if (work->multiReady)
+    return work->multiBits;
+  work->multiReady = 1;
+  work->multiBits = 0;
+
+  width = work->lookupBits < HUFF_MULTI_MIN_BITS   ? HUFF_MULTI_MIN_BITS
+          : work->lookupBits > HUFF_MULTI_MAX_BITS ? HUFF_MULTI_MAX_BITS
+                                                   : work->lookupBits;
+
+  // Comprimento médio, supondo a probabilidade 2^-len implícita no código
+  // canônico (em unidades de 2^-HUFF_MAX_CODE_LEN): sem espaço para dois
+  // códigos médios, a tabela maior só custaria cache
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (codes->len[i] != 0)
+      expected += (unsigned long)codes->len[i]
+                  << (HUFF_MAX_CODE_LEN - codes->len[i]);
+  }
+  if (2 * expected > (unsigned long)width << HUFF_MAX_CODE_LEN)
+    return 0;
+
+  for (unsigned x = 0; x < 1u << width; ++x)
+  {
+    unsigned used = 0;
+    unsigned n = 0;
+    unsigned entry = 0;
+
+    while (n < HUFF_MULTI_SYMBOLS)
+    {
+      // Bits restantes de x, completados com zeros à direita
+      unsigned rest = (x << used) & ((1u << width) - 1);
+      unsigned single =
+          lookupEntry(work, (unsigned long long)rest << (64 - width));
+      unsigned len = single >> 8;
+
+      if (len == 0 || len > width - used)
+        break;
+      entry |= (unsigned)(single & 0xFF) << (8 * n);
+      used += len;
+      n++;
+    }
+    work->multi[x] = entry | (used << 24) | (n << 28);
+  }
+  work->multiBits = width;
+  return width;
+}
+
+// Completa o contêiner: 56-63 bits com uma leitura só, ou byte a byte no fim
+HUFF_INLINE void refill(const unsigned char **p, const unsigned char *end,
+                        unsigned long long *bitBuffer, unsigned *bitCount)
+{
+  if (end - *p >= 8)
+  {
+    *bitBuffer |= loadBE64(*p) >> *bitCount;
+    *p += (63 - *bitCount) >> 3;
+    *bitCount |= 56;
+  }
+  else
+  {
+    while (*bitCount <= 56 && *p < end)
+    {
+      *bitBuffer |= (unsigned long long)*(*p)++ << (56 - *bitCount);
+      *bitCount += 8;
+    }
+  }
+}
+
+/**
+ * Decodifica count símbolos a partir do bit start de in, gravando-os em
+ * out[0], out[stride], out[2 * stride], ...
+ *
+ * @return Posição do bit seguinte ao último código, ou -1 se inválido.
+ */
+HUFF_INLINE long long decode64(const struct HuffmanKernelWork *work,
+                               const unsigned char *in, unsigned long inSize,
+                               unsigned long long start, char *out,
+                               unsigned long stride, unsigned long count)
+{
+  const unsigned char *p = in + (start >> 3);
+  const unsigned char *end = in + inSize;
+  unsigned long long bitBuffer = 0; // Alinhado à esquerda
+  unsigned bitCount = 0;
+  unsigned long long consumed = start;
+  const unsigned bits = work->lookupBits;
+
+  // Começo no meio de um byte: descarta os bits já consumidos
+  if ((start & 7) != 0)
+  {
+    bitBuffer = ((unsigned long long)*p++ << 56) << (start & 7);
+    bitCount = 8 - (unsigned)(start & 7);
+  }
+
+  for (unsigned long i = 0; i < count; ++i)
+  {
+    if (bitCount < bits)
+      refill(&p, end, &bitBuffer, &bitCount);
+
+    unsigned entry = lookupEntry(work, bitBuffer);
+    unsigned len = entry >> 8;
+
+    // Código inválido, ou os bits acabaram no meio de um código
+    if (len == 0 || len > bitCount)
+      return -1;
+
+    out[i * stride] = (char)(entry & 0xFF);
+    bitBuffer <<= len;
+    bitCount -= len;
+    consumed += len;
+  }
+  return (long long)consumed;
+}
+
+/**
+ * Como decode64 (do bit 0, sem intercalação), mas com a tabela de vários
+ * símbolos de largura width.
+ */
+HUFF_INLINE long long decodeMulti(const struct HuffmanKernelWork *work,
+                                  const unsigned char *in, unsigned long inSize,
+                                  unsigned width, char *out,
+                                  unsigned long count)
+{
+  const unsigned char *p = in;
+  const unsigned char *end = in + inSize;
+  unsigned long long bitBuffer = 0; // Alinhado à esquerda
+  unsigned bitCount = 0;
+  unsigned long long consumed = 0;
+  const unsigned bits = work->lookupBits;
+  const unsigned need = width > bits ? width : bits; // Para as duas tabelas
+  unsigned long i = 0;
+
+  while (i < count)
+  {
+    if (bitCount < need)
+      refill(&p, end, &bitBuffer, &bitCount);
+
+    unsigned entry = work->multi[bitBuffer >> (64 - width)];
+    unsigned len = (entry >> 24) & 0x0F;
+
+    if (len != 0 && len <= bitCount && count - i > HUFF_MULTI_SYMBOLS)
+    {
+      // Grava os 4 bytes da entrada: o que passar de n é sobrescrito depois
+      memcpy(out + i, &entry, 4);
+      i += entry >> 28;
+    }
+    else
+    {
+      // Fim da entrada ou do fluxo: um símbolo por vez, como decode64
+      unsigned single = lookupEntry(work, bitBuffer);
+      len = single >> 8;
+      if (len == 0 || len > bitCount)
+        return -1;
+      out[i++] = (char)(single & 0xFF);
+    }
+    bitBuffer <<= len;
+    bitCount -= len;
+    consumed += len;
+  }
+  return (long long)consumed;
+}
+
+unsigned long long huffmanEncode64(const struct HuffmanCodeTable *table,
+                                   const char in[], unsigned long size,
+                                   unsigned char out[])
+{
+  return encode64(table, in, size, out);
+}
+
+__attribute__((target("bmi2"))) unsigned long long
+huffmanEncodeBmi2(const struct HuffmanCodeTable *table, const char in[],
+                  unsigned long size, unsigned char out[])
+{
+  return encode64(table, in, size, out);
+}
+
+long long huffmanDecode64(struct HuffmanKernelWork *work,
+                          const struct HuffmanCodeTable *codes,
+                          const struct HuffmanDecodeTable *tree,
+                          const unsigned char *in, unsigned long inSize,
+                          char *out, unsigned long count)
+{
+  (void)tree;
+  prepareLookup(work, codes);
+  return decode64(work, in, inSize, 0, out, 1, count);
+}
+
+__attribute__((target("bmi2"))) long long
+huffmanDecodeBmi2(struct HuffmanKernelWork *work,
+                  const struct HuffmanCodeTable *codes,
+                  const struct HuffmanDecodeTable *tree, const unsigned char *in,
+                  unsigned long inSize, char *out, unsigned long count)
+{
+  (void)tree;
+  prepareLookup(work, codes);
+  return decode64(work, in, inSize, 0, out, 1, count);
+}
+
+void huffmanSetLookupBits(struct HuffmanKernelWork *work, unsigned bits)
+{
+  work->forcedBits = bits > HUFF_MAX_CODE_LEN ? HUFF_MAX_CODE_LEN : bits;
+  work->lookupBits = 0; // Refaz as tabelas na próxima decodificação
+}
+
+long long huffmanDecodeMulti64(struct HuffmanKernelWork *work,
+                               const struct HuffmanCodeTable *codes,
+                               const struct HuffmanDecodeTable *tree,
+                               const unsigned char *in, unsigned long inSize,
+                               char *out, unsigned long count)
+{
+  unsigned width = prepareMulti(work, codes);
+
+  (void)tree;
+  if (width == 0)
+    return decode64(work, in, inSize, 0, out, 1, count);
+  return decodeMulti(work, in, inSize, width, out, count);
+}
+
+__attribute__((target("bmi2"))) long long
+huffmanDecodeMultiBmi2(struct HuffmanKernelWork *work,
+                       const struct HuffmanCodeTable *codes,
+                       const struct HuffmanDecodeTable *tree,
+                       const unsigned char *in, unsigned long inSize, char *out,
+                       unsigned long count)
+{
+  unsigned width = prepareMulti(work, codes);
+
+  (void)tree;
+  if (width == 0)
+    return decode64(work, in, inSize, 0, out, 1, count);
+  return decodeMulti(work, in, inSize, width, out, count);
+}
+
+// Símbolos do fluxo s quando a partir do símbolo first restam count
+static unsigned long laneCount(unsigned long first, unsigned long count, int s)
+{
+  return first + (unsigned long)s < count
+             ? (count - first - (unsigned long)s + HUFF_STREAMS - 1) / HUFF_STREAMS
+             : 0;
+}
+
+int huffmanDecodeStreams64(struct HuffmanKernelWork *work,
+                           const struct HuffmanCodeTable *codes,
+                           const struct HuffmanDecodeTable *tree,
+                           const unsigned char *const streams[HUFF_STREAMS],
+                           const unsigned long sizes[HUFF_STREAMS], char *out,
+                           unsigned long count,
+                           unsigned long long consumed[HUFF_STREAMS])
+{
+  (void)tree;
+  prepareLookup(work, codes);
+
+  for (int s = 0; s < HUFF_STREAMS; ++s)
+  {
+    long long end = decode64(work, streams[s], sizes[s], 0, out + s,
+                             HUFF_STREAMS, laneCount(0, count, s));
+    if (end < 0)
+      return -1;
+    consumed[s] = (unsigned long long)end;
+  }
+  return 0;
+}
+
+/**
+ * Consulta as tabelas para as 8 janelas (alinhadas à esquerda). Só as
+ * pistas com códigos mais longos que a tabela primária fazem o segundo
+ * gather.
+ *
+ * @return Entradas (comprimento e símbolo) de cada pista.
+ */
+HUFF_AVX2_INLINE __m256i lookupLanes(const struct HuffmanKernelWork *work,
+                                     __m256i window, __m128i primaryShift,
+                                     __m128i indexShift)
+{
+  __m256i entry = _mm256_i32gather_epi32(
+      (const int *)work->primary, _mm256_srl_epi32(window, indexShift), 4);
+  __m256i link = _mm256_srai_epi32(entry, 31);
+
+  if (!_mm256_testz_si256(link, link))
+  {
+    __m256i width = _mm256_and_si256(_mm256_srli_epi32(entry, 16),
+                                      _mm256_set1_epi32(0x0F));
+    __m256i rest = _mm256_srlv_epi32(_mm256_sll_epi32(window, primaryShift),
+                                     _mm256_sub_epi32(_mm256_set1_epi32(32), width));
+    __m256i index = _mm256_add_epi32(
+        _mm256_and_si256(entry, _mm256_set1_epi32(0xFFFF)), rest);
+    entry = _mm256_mask_i32gather_epi32(entry, (const int *)work->secondary,
+                                        index, link, 2);
+  }
+  return _mm256_and_si256(entry, _mm256_set1_epi32(0xFFFF));
+}
+
+__attribute__((target("avx2"))) int
+huffmanDecodeStreamsAvx2(struct HuffmanKernelWork *work,
+                         const struct HuffmanCodeTable *codes,
+                         const struct HuffmanDecodeTable *tree,
+                         const unsigned char *const streams[HUFF_STREAMS],
+                         const unsigned long sizes[HUFF_STREAMS], char *out,
+                         unsigned long count,
+                         unsigned long long consumed[HUFF_STREAMS])
+{
+  const unsigned char *base = streams[0];
+  int offsets[HUFF_STREAMS];
+  int ends[HUFF_STREAMS];
+  unsigned positions[HUFF_STREAMS];
+  unsigned long rows = count / HUFF_STREAMS;
+  unsigned long row = 0;
+
+  prepareLookup(work, codes);
+
+  // As pistas guardam a posição em bits a partir de streams[0] em 32 bits:
+  // fluxos fora de ordem ou distantes demais ficam com o kernel escalar
+  for (int s = 0; s < HUFF_STREAMS; ++s)
+  {
+    if (streams[s] < base || sizes[s] >= (1ul << 27) ||
+        (unsigned long)(streams[s] - base) >= (1ul << 27))
+      return huffmanDecodeStreams64(work, codes, tree, streams, sizes, out,
+                                    count, consumed);
+    offsets[s] = (int)(streams[s] - base);
+    ends[s] = offsets[s] + (int)sizes[s];
+  }
+
+  const __m256i end = _mm256_loadu_si256((const __m256i *)ends);
+  const __m256i byteMask = _mm256_set1_epi32(0xFF);
+  const __m128i primaryShift = _mm_cvtsi32_si128((int)work->primaryBits);
+  const __m128i indexShift = _mm_cvtsi32_si128(32 - (int)work->primaryBits);
+  // Inverte os bytes de cada pista: o gather lê em little-endian
+  const __m256i bswap = _mm256_setr_epi8(
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  // Junta o byte 0 (linha atual) e o byte 1 (linha seguinte) de cada pista
+  const __m256i pack = _mm256_setr_epi8(
+      0, 4, 8, 12, 1, 5, 9, 13, -1, -1, -1, -1, -1, -1, -1, -1,
+      0, 4, 8, 12, 1, 5, 9, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i rowOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  // A janela tem ao menos 25 bits válidos: com códigos de até 12 bits, cabem
+  // dois por pista, e o gather da janela serve para duas linhas
+  const unsigned long perWindow = 2 * work->lookupBits <= 25 ? 2 : 1;
+  __m256i pos = _mm256_slli_epi32(
+      _mm256_loadu_si256((const __m256i *)offsets), 3);
+
+  for (; row + perWindow <= rows; row += perWindow)
+  {
+    __m256i byteIndex = _mm256_srli_epi32(pos, 3);
+
+    // Todas as pistas precisam de 4 bytes inteiros dentro do seu fluxo
+    __m256i past = _mm256_cmpgt_epi32(
+        _mm256_add_epi32(byteIndex, _mm256_set1_epi32(4)), end);
+    if (!_mm256_testz_si256(past, past))
+      break;
+
+    __m256i window = _mm256_i32gather_epi32((const int *)base, byteIndex, 1);
+    window = _mm256_shuffle_epi8(window, bswap);
+    window = _mm256_sllv_epi32(window,
+                               _mm256_and_si256(pos, _mm256_set1_epi32(7)));
+
+    __m256i entry = lookupLanes(work, window, primaryShift, indexShift);
+    __m256i len = _mm256_srli_epi32(entry, 8);
+    __m256i invalid = _mm256_cmpeq_epi32(len, _mm256_setzero_si256());
+    __m256i symbols = _mm256_and_si256(entry, byteMask);
+
+    pos = _mm256_add_epi32(pos, len);
+    if (perWindow == 2)
+    {
+      window = _mm256_sllv_epi32(window, len);
+      entry = lookupLanes(work, window, primaryShift, indexShift);
+      len = _mm256_srli_epi32(entry, 8);
+      invalid = _mm256_or_si256(
+          invalid, _mm256_cmpeq_epi32(len, _mm256_setzero_si256()));
+      symbols = _mm256_or_si256(
+          symbols, _mm256_slli_epi32(_mm256_and_si256(entry, byteMask), 8));
+      pos = _mm256_add_epi32(pos, len);
+    }
+
+    // Código inválido em alguma pista
+    if (!_mm256_testz_si256(invalid, invalid))
+      return -1;
+
+    symbols = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(symbols, pack),
+                                          rowOrder);
+    if (perWindow == 2)
+      _mm_storeu_si128((__m128i *)(out + row * HUFF_STREAMS),
+                       _mm256_castsi256_si128(symbols));
+    else
+      _mm_storel_epi64((__m128i *)(out + row * HUFF_STREAMS),
+                       _mm256_castsi256_si128(symbols));
+  }
+
+  // O restante de cada fluxo segue no kernel escalar, de onde a pista parou
+  _mm256_storeu_si256((__m256i *)positions, pos);
+  for (int s = 0; s < HUFF_STREAMS; ++s)
+  {
+    unsigned long first = row * HUFF_STREAMS;
+    long long stop = decode64(
+        work, streams[s], sizes[s], positions[s] - 8ull * (unsigned)offsets[s],
+        out + first + s, HUFF_STREAMS, laneCount(first, count, s));
+    if (stop < 0)
+      return -1;
+    consumed[s] = (unsigned long long)stop;
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Algoritmo de Codificação de Huffman - Decodificação de qualquer bloco
+ *
+ * Descrição:
+ * Escolhe o decodificador pelo tipo do bloco, inteiro ou num intervalo
+ * indexado. Ver huffman_blocks.h.
+ */
+#include <string.h>
+#include "huffman_blocks.h"
+
+long huffmanDecodeAnyBlock(struct HuffmanAnyWork *work,
+                           const unsigned char *in, unsigned long size,
+                           char *out, unsigned long outSize)
+{
+  struct HuffmanBlockInfo info;
+
+  if (huffmanBlockParse(in, size, &info) != 0)
+    return -1;
+
+  switch (info.type)
+  {
+  case HUFF_BLOCK_HUFFMAN:
+  case HUFF_BLOCK_STORED:
+  case HUFF_BLOCK_RLE:
+  case HUFF_BLOCK_STREAMS:
+    return huffmanBlockDecode(&work->bwt.context.decode, in, size, out,
+                              outSize);
+  case HUFF_BLOCK_CONTEXT:
+  case HUFF_BLOCK_SEGMENTS:
+    return huffmanContextDecode(&work->bwt.context, in, size, out, outSize);
+  case HUFF_BLOCK_LZ:
+    return huffmanLzDecode(&work->lz, in, size, out, outSize);
+  case HUFF_BLOCK_BWT:
+    return huffmanBwtDecode(&work->bwt, in, size, out, outSize);
+  default:
+    return -1;
+  }
+}
+
+int huffmanDecodeAnyRange(struct HuffmanAnyWork *work,
+                          const unsigned char *archive,
+                          unsigned long archiveSize,
+                          const struct HuffmanSeekIndex *index,
+                          uint64_t offset, char *out, unsigned long size)
+{
+  if (offset > index->rawSize || size > index->rawSize - offset)
+    return -1;
+
+  while (size > 0)
+  {
+    const struct HuffmanSeekPoint *point = huffmanSeekIndexFind(index, offset);
+    const unsigned char *block;
+    unsigned long available;
+    struct HuffmanBlockInfo info;
+    unsigned long first; // Posição de offset dentro do bloco
+    unsigned long part;
+
+    if (point == 0 || point->blockOffset >= archiveSize)
+      return -1;
+    block = archive + (unsigned long)point->blockOffset;
+    available = archiveSize - (unsigned long)point->blockOffset;
+    if (huffmanBlockParse(block, available, &info) != 0 ||
+        offset - point->blockRawOffset >= info.rawSize)
+      return -1;
+
+    first = (unsigned long)(offset - point->blockRawOffset);
+    part = info.rawSize - first;
+    if (part > size)
+      part = size;
+
+    switch (info.type)
+    {
+    case HUFF_BLOCK_HUFFMAN:
+    case HUFF_BLOCK_STORED:
+    case HUFF_BLOCK_RLE:
+    case HUFF_BLOCK_STREAMS:
+      if (huffmanDecodeRange(&work->bwt.context.decode, archive, archiveSize,
+                             index, offset, out, part) != 0)
+        return -1;
+      break;
+    default:
+      // Entrada de bloco inteiro: direto para out se o intervalo cobre o
+      // bloco todo; senão, para work->range, de onde sai só o trecho pedido
+      if (part == info.rawSize)
+      {
+        if (huffmanDecodeAnyBlock(work, block, available, out, part) !=
+            (long)part)
+          return -1;
+        break;
+      }
+      if (info.rawSize > HUFF_ANY_RANGE_BLOCK ||
+          huffmanDecodeAnyBlock(work, block, available, work->range,
+                                HUFF_ANY_RANGE_BLOCK) != (long)info.rawSize)
+        return -1;
+      memcpy(out, work->range + first, part);
+      break;
+    }
+
+    offset += part;
+    out += part;
+    size -= part;
+  }
+  return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * Algoritmo de Codificação de Huffman - Decodificação de qualquer bloco
+ *
+ * Descrição:
+ * Ponto de entrada único do host para arquivos com blocos de tipos
+ * variados: escolhe o decodificador pelo tipo do cabeçalho. Cada módulo
+ * decodifica só os seus tipos e os de huffman_frame.c, que o seu
+ * codificador gera quando o modelo não compensa; assim, quem usa um módulo
+ * só não precisa ligar os demais, e quem mistura módulos usa esta função.
+ *
+ * huffmanDecodeAnyRange faz o mesmo com o índice de acesso aleatório: os
+ * blocos de huffman_frame.c vão para huffmanDecodeRange, e as entradas de
+ * bloco inteiro (CONTEXT, SEGMENTS, LZ e BWT) são decodificadas inteiras a
+ * cada chamada, o que custa o bloco todo mesmo para um trecho curto.
+ */
+#ifndef HUFFMAN_BLOCKS_H
+#define HUFFMAN_BLOCKS_H
+
+#include "huffman_context.h"
+#include "huffman_lz.h"
+#include "huffman_bwt.h"
+
+// Maior bloco inteiro de que huffmanDecodeAnyRange serve só um trecho: o
+// maior bloco SEGMENTS, LZ ou BWT. Blocos CONTEXT maiores só são servidos
+// quando o intervalo cobre o bloco todo
+#define HUFF_ANY_RANGE_BLOCK HUFF_LZ_MAX_BLOCK
+
+#if HUFF_SEGMENT_MAX_BLOCK > HUFF_ANY_RANGE_BLOCK || \
+    HUFF_BWT_MAX_BLOCK > HUFF_ANY_RANGE_BLOCK
+#error "HUFF_ANY_RANGE_BLOCK deve comportar os blocos SEGMENTS e BWT"
+#endif
+
+// Memória de trabalho de huffmanDecodeAnyBlock e huffmanDecodeAnyRange: a
+// de cada módulo. Grande demais para a pilha (ver HuffmanBwtWork); deve
+// começar zerada.
+struct HuffmanAnyWork
+{
+  struct HuffmanBwtWork bwt; // Também para CONTEXT, SEGMENTS e huffman_frame.c
+  struct HuffmanLzWork lz;
+  char range[HUFF_ANY_RANGE_BLOCK]; // Bloco inteiro de huffmanDecodeAnyRange
+};
+
+/**
+ * Decodifica um bloco de qualquer tipo (HUFF_BLOCK_HUFFMAN a
+ * HUFF_BLOCK_BWT), conferindo o CRC32C se presente.
+ *
+ * @param work Memória de trabalho.
+ * @param in Início do bloco.
+ * @param size Bytes disponíveis a partir de in.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @return Tamanho original, ou -1 se o bloco for inválido, de tipo
+ *         desconhecido ou não couber em out.
+ */
+long huffmanDecodeAnyBlock(struct HuffmanAnyWork *work,
+                           const unsigned char *in, unsigned long size,
+                           char *out, unsigned long outSize);
+
+/**
+ * Decodifica só o intervalo [offset, offset + size) de um arquivo com
+ * blocos de qualquer tipo, indexado por huffmanSeekIndexAddBlock. Cada
+ * bloco do intervalo é achado com huffmanSeekIndexFind: os de
+ * huffman_frame.c são servidos por huffmanDecodeRange, a partir do ponto
+ * mais próximo e sem conferir o CRC; as entradas de bloco inteiro são
+ * decodificadas por huffmanDecodeAnyBlock, que confere o CRC, e só o
+ * trecho pedido é copiado para out.
+ *
+ * @param work Memória de trabalho.
+ * @param archive Início do arquivo de blocos.
+ * @param archiveSize Tamanho do arquivo.
+ * @param index Índice do arquivo.
+ * @param offset Posição descomprimida do primeiro byte.
+ * @param out Buffer de saída, com ao menos size bytes.
+ * @param size Quantidade de bytes a decodificar.
+ * @return 0 em caso de sucesso, -1 se o intervalo ou o arquivo for inválido
+ *         ou se pedir só parte de um bloco CONTEXT maior que
+ *         HUFF_ANY_RANGE_BLOCK.
+ */
+int huffmanDecodeAnyRange(struct HuffmanAnyWork *work,
+                          const unsigned char *archive,
+                          unsigned long archiveSize,
+                          const struct HuffmanSeekIndex *index,
+                          uint64_t offset, char *out, unsigned long size);
+
+#endif
@@ -0,0 +1,409 @@
+/*
+ * Algoritmo de Codificação de Huffman - BWT + MTF + RLE
+ *
+ * Descrição:
+ * Ordena os sufixos do bloco por duplicação de prefixo, tira deles a última
+ * coluna da matriz de rotações (BWT), aplica move-to-front e as corridas de
+ * zeros do bzip2 e entrega os símbolos a huffmanSegmentsEncode. A
+ * decodificação refaz a entrada percorrendo o mapeamento LF da última
+ * coluna para a primeira. Ver huffman_bwt.h.
+ */
+#include <string.h>
+#include "huffman_bwt.h"
+#include "huffman_coder.h"
+
+#define RUNA 0 // Dígito 1 de uma corrida de zeros
+#define RUNB 1 // Dígito 2 de uma corrida de zeros
+#define BWT_HEADER_SIZE (4 + HUFF_BWT_MAP_SIZE)
+
+/**
+ * Ordena os sufixos de in por duplicação de prefixo. Com os postos dos
+ * prefixos de k bytes, os de 2k bytes saem de uma ordenação por contagem
+ * pelo par (posto de i, posto de i + k), e um sufixo que acaba antes fica
+ * na frente, como se terminasse numa sentinela menor que qualquer byte.
+ * Para quando todos os postos são distintos: no máximo log2(n) passes de
+ * O(n).
+ */
+static void sortSuffixes(struct HuffmanBwtWork *work, const unsigned char *in,
+                         unsigned long n)
+{
+  unsigned *rank = work->ranks;
+  unsigned *next = work->scratch;
+  unsigned long maxRank = 256;
+
+  // Primeiro passe: posto = byte + 1 (0 fica para depois do fim)
+  memset(work->counts, 0, (maxRank + 2) * sizeof(work->counts[0]));
+  for (unsigned long i = 0; i < n; ++i)
+  {
+    rank[i] = in[i] + 1u;
+    work->counts[rank[i] + 1]++;
+  }
+  for (unsigned long r = 1; r <= maxRank + 1; ++r)
+    work->counts[r] += work->counts[r - 1];
+  for (unsigned long i = 0; i < n; ++i)
+    work->suffixes[work->counts[rank[i]]++] = (unsigned)i;
+
+  for (unsigned long k = 1;; k <<= 1)
+  {
+    unsigned long count = 0;
+    unsigned long r = 1;
+
+    // Ordem pela segunda chave: os que acabam antes de k bytes (chave 0)
+    // e depois os demais, na ordem atual de i + k
+    for (unsigned long i = n - (k < n ? k : n); i < n; ++i)
+      next[count++] = (unsigned)i;
+    for (unsigned long j = 0; j < n; ++j)
+    {
+      if (work->suffixes[j] >= k)
+        next[count++] = work->suffixes[j] - (unsigned)k;
+    }
+
+    // Ordenação estável pela primeira chave
+    memset(work->counts, 0, (maxRank + 2) * sizeof(work->counts[0]));
+    for (unsigned long i = 0; i < n; ++i)
+      work->counts[rank[i] + 1]++;
+    for (unsigned long v = 1; v <= maxRank + 1; ++v)
+      work->counts[v] += work->counts[v - 1];
+    for (unsigned long j = 0; j < n; ++j)
+      work->suffixes[work->counts[rank[next[j]]]++] = next[j];
+
+    // Novos postos: o par mudou, o posto sobe
+    next[work->suffixes[0]] = 1;
+    for (unsigned long j = 1; j < n; ++j)
+    {
+      unsigned a = work->suffixes[j - 1];
+      unsigned b = work->suffixes[j];
+      unsigned secondA = a + k < n ? rank[a + k] : 0;
+      unsigned secondB = b + k < n ? rank[b + k] : 0;
+
+      if (rank[a] != rank[b] || secondA != secondB)
+        r++;
+      next[b] = (unsigned)r;
+    }
+
+    unsigned *swap = rank;
+    rank = next;
+    next = swap;
+    maxRank = r;
+    if (r == n)
+      break;
+  }
+}
+
+/**
+ * Calcula a BWT de in + sentinela em last, sem a sentinela: a linha 0 é a
+ * da sentinela (precedida do último byte), e a linha da entrada original é
+ * a única precedida da sentinela.
+ *
+ * @return Linha da entrada original (1 a n).
+ */
+static unsigned long transform(struct HuffmanBwtWork *work,
+                               const unsigned char *in, unsigned long n)
+{
+  unsigned long primary = 0;
+  unsigned long j = 0;
+
+  sortSuffixes(work, in, n);
+  work->last[j++] = in[n - 1];
+  for (unsigned long i = 0; i < n; ++i)
+  {
+    if (work->suffixes[i] == 0)
+      primary = i + 1;
+    else
+      work->last[j++] = in[work->suffixes[i] - 1];
+  }
+  return primary;
+}
+
+// Grava a corrida de zeros em base 2 bijetiva: RUNA vale 1 e RUNB vale 2,
+// multiplicados pelo peso da posição
+static unsigned long putRun(struct HuffmanBwtWork *work, unsigned long run,
+                            unsigned long count)
+{
+  while (run > 0)
+  {
+    run--;
+    work->symbols[count++] = run & 1 ? RUNB : RUNA;
+    run >>= 1;
+  }
+  return count;
+}
+
+/**
+ * Aplica move-to-front (só com os bytes presentes) e as corridas de zeros
+ * a last, gravando os símbolos em symbols e os bits extras em escapes.
+ *
+ * @param order Bytes presentes, em ordem crescente; é alterado.
+ * @param used Quantidade de bytes presentes.
+ * @param escapeCount Recebe a quantidade de bits extras.
+ * @return Quantidade de símbolos.
+ */
+static unsigned long encodeSymbols(struct HuffmanBwtWork *work,
+                                   unsigned long n, unsigned char order[],
+                                   int used, unsigned long *escapeCount)
+{
+  unsigned long count = 0;
+  unsigned long run = 0;
+  int escaped = used + 1 > HUFF_ALPHABET_SIZE;
+
+  *escapeCount = 0;
+  memset(work->escapes, 0, n / 8 + 1);
+  for (unsigned long i = 0; i < n; ++i)
+  {
+    unsigned char c = work->last[i];
+    int value = 0;
+
+    if (order[0] == c)
+    {
+      run++;
+      continue;
+    }
+    while (order[value] != c)
+      value++;
+    memmove(order + 1, order, (size_t)value);
+    order[0] = c;
+
+    count = putRun(work, run, count);
+    run = 0;
+    if (escaped && value + 1 >= HUFF_ALPHABET_SIZE - 1)
+    {
+      // O último símbolo vale para os dois valores mais altos
+      if (value + 1 == HUFF_ALPHABET_SIZE)
+        work->escapes[*escapeCount / 8] |=
+            (unsigned char)(0x80 >> (*escapeCount % 8));
+      ++*escapeCount;
+      work->symbols[count++] = HUFF_ALPHABET_SIZE - 1;
+    }
+    else
+      work->symbols[count++] = (unsigned char)(value + 1);
+  }
+  return putRun(work, run, count);
+}
+
+long huffmanBwtEncode(struct HuffmanBwtWork *work, const char *in,
+                      unsigned long size, unsigned char *out,
+                      unsigned long outSize, int flags)
+{
+  unsigned long reserved =
+      HUFF_BLOCK_HEADER_SIZE + (flags & HUFF_BLOCK_FLAG_CRC ? HUFF_BLOCK_CRC_SIZE : 0);
+  unsigned char *body = out + HUFF_BLOCK_HEADER_SIZE;
+  unsigned char order[HUFF_ALPHABET_SIZE];
+  unsigned long escapeCount;
+  int used = 0;
+
+  flags &= HUFF_BLOCK_FLAG_CRC;
+  if (size > HUFF_BWT_MAX_BLOCK)
+    return huffmanBlockEncode(&work->context.block, in, size, out, outSize,
+                              flags);
+
+  memset(work->freq, 0, sizeof(work->freq));
+  if (calculateFrequencyInChunks(in, work->freq, (int)size, (int)size) != 0)
+    return -1;
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (work->freq[i] != 0)
+      order[used++] = (unsigned char)i;
+  }
+
+  // Vazio ou um só símbolo: não há o que transformar
+  if (used <= 1 || outSize < reserved + BWT_HEADER_SIZE)
+    return huffmanBlockEncode(&work->context.block, in, size, out, outSize,
+                              flags);
+
+  unsigned long order0Size =
+      huffmanOrder0Size(&work->context.tree, work->freq, &work->codes);
+  unsigned long primary = transform(work, (const unsigned char *)in, size);
+  memset(body + 4, 0, HUFF_BWT_MAP_SIZE);
+  for (int i = 0; i < used; ++i)
+    body[4 + order[i] / 8] |= (unsigned char)(0x80 >> (order[i] % 8));
+  unsigned long count = encodeSymbols(work, size, order, used, &escapeCount);
+
+  // Os símbolos vão num bloco completo, com as tabelas por segmento
+  unsigned long capacity = outSize - reserved - BWT_HEADER_SIZE;
+  long inner = huffmanSegmentsEncode(&work->context,
+                                     (const char *)work->symbols, count,
+                                     body + BWT_HEADER_SIZE, capacity, 0);
+  unsigned long escapeSize = (escapeCount + 7) / 8;
+  if (inner < 0 || capacity - (unsigned long)inner < escapeSize)
+    return huffmanBlockEncode(&work->context.block, in, size, out, outSize,
+                              flags);
+
+  unsigned long bodySize = BWT_HEADER_SIZE + (unsigned long)inner + escapeSize;
+  if (bodySize >= order0Size || bodySize >= size)
+    return huffmanBlockEncode(&work->context.block, in, size, out, outSize,
+                              flags);
+
+  body[0] = (unsigned char)primary;
+  body[1] = (unsigned char)(primary >> 8);
+  body[2] = (unsigned char)(primary >> 16);
+  body[3] = (unsigned char)(primary >> 24);
+  memcpy(body + BWT_HEADER_SIZE + inner, work->escapes, escapeSize);
+  return huffmanBlockFinish(out, HUFF_BLOCK_BWT, flags, size, bodySize);
+}
+
+/**
+ * Desfaz as corridas de zeros e o move-to-front, gravando a última coluna
+ * em last.
+ *
+ * @param count Quantidade de símbolos em symbols.
+ * @param escapeData Bits extras.
+ * @param escapeSize Tamanho de escapeData.
+ * @return 0 em caso de sucesso, -1 se os símbolos não gerarem exatamente n
+ *         bytes ou os bits extras não baterem.
+ */
+static int decodeSymbols(struct HuffmanBwtWork *work, unsigned long n,
+                         unsigned long count,
+                         unsigned char order[], int used,
+                         const unsigned char *escapeData,
+                         unsigned long escapeSize)
+{
+  int escaped = used + 1 > HUFF_ALPHABET_SIZE;
+  unsigned long escapeCount = 0;
+  unsigned long pos = 0;
+  unsigned long run = 0;
+  unsigned long weight = 1;
+
+  for (unsigned long i = 0; i <= count; ++i)
+  {
+    int symbol = i < count ? work->symbols[i] : -1;
+
+    if (symbol == RUNA || symbol == RUNB)
+    {
+      run += symbol == RUNA ? weight : 2 * weight;
+      weight <<= 1;
+      if (run > n - pos)
+        return -1;
+      continue;
+    }
+    memset(work->last + pos, order[0], run);
+    pos += run;
+    run = 0;
+    weight = 1;
+    if (symbol < 0)
+      break;
+
+    int value = symbol - 1;
+    if (escaped && symbol == HUFF_ALPHABET_SIZE - 1)
+    {
+      if (escapeCount / 8 >= escapeSize)
+        return -1;
+      value += (escapeData[escapeCount / 8] >> (7 - escapeCount % 8)) & 1;
+      escapeCount++;
+    }
+    if (value >= used || pos == n)
+      return -1;
+
+    unsigned char c = order[value];
+    memmove(order + 1, order, (size_t)value);
+    order[0] = c;
+    work->last[pos++] = c;
+  }
+  return pos == n && (escapeCount + 7) / 8 == escapeSize ? 0 : -1;
+}
+
+/**
+ * Refaz a entrada de trás para a frente: a partir da linha da sentinela,
+ * o byte da última coluna é o anterior, e LF leva à linha que começa por
+ * ele (a k-ésima ocorrência de um byte na última coluna é a k-ésima na
+ * primeira).
+ *
+ * @return 0 em caso de sucesso, -1 se a linha original for inconsistente.
+ */
+static int inverseTransform(struct HuffmanBwtWork *work, unsigned long n,
+                            unsigned long primary, char *out)
+{
+  unsigned long first[256] = {0};
+  unsigned long row = 0;
+
+  // Primeira linha de cada byte na coluna ordenada (a 0 é a da sentinela)
+  for (unsigned long i = 0; i < n; ++i)
+    first[work->last[i]]++;
+  for (unsigned long c = 0, total = 1; c < 256; ++c)
+  {
+    unsigned long occurrences = first[c];
+    first[c] = total;
+    total += occurrences;
+  }
+  for (unsigned long i = 0; i <= n; ++i)
+  {
+    if (i != primary)
+      work->suffixes[i] =
+          (unsigned)first[work->last[i < primary ? i : i - 1]]++;
+  }
+
+  for (unsigned long k = n; k-- > 0;)
+  {
+    if (row == primary)
+      return -1;
+    out[k] = (char)work->last[row < primary ? row : row - 1];
+    row = work->suffixes[row];
+  }
+  return row == primary ? 0 : -1;
+}
+
+/**
+ * Decodifica o corpo de um bloco HUFF_BLOCK_BWT.
+ *
+ * @param body Início do corpo.
+ * @param info Campos do cabeçalho.
+ * @param out Buffer de saída, com ao menos info->rawSize bytes.
+ * @return 0 em caso de sucesso, -1 se o corpo for inválido.
+ */
+static int decodeBwtBody(struct HuffmanBwtWork *work,
+                         const unsigned char *body,
+                         const struct HuffmanBlockInfo *info, char *out)
+{
+  struct HuffmanBlockInfo inner;
+  unsigned char order[HUFF_ALPHABET_SIZE];
+  unsigned long n = info->rawSize;
+  unsigned long primary;
+  int used = 0;
+
+  if (info->compressedSize < BWT_HEADER_SIZE || n == 0 ||
+      n > HUFF_BWT_MAX_BLOCK)
+    return -1;
+  primary = (unsigned long)body[0] | (unsigned long)body[1] << 8 |
+            (unsigned long)body[2] << 16 | (unsigned long)body[3] << 24;
+  if (primary == 0 || primary > n)
+    return -1;
+  for (int i = 0; i < 8 * HUFF_BWT_MAP_SIZE; ++i)
+  {
+    if (!((body[4 + i / 8] >> (7 - i % 8)) & 1))
+      continue;
+    if (i >= HUFF_ALPHABET_SIZE)
+      return -1;
+    order[used++] = (unsigned char)i;
+  }
+  if (used == 0)
+    return -1;
+
+  const unsigned char *innerBlock = body + BWT_HEADER_SIZE;
+  unsigned long available = info->compressedSize - BWT_HEADER_SIZE;
+  if (huffmanBlockParse(innerBlock, available, &inner) != 0)
+    return -1;
+  long count = huffmanContextDecode(&work->context, innerBlock,
+                                    inner.blockSize, (char *)work->symbols, n);
+  if (count < 0 ||
+      decodeSymbols(work, n, (unsigned long)count, order, used,
+                    innerBlock + inner.blockSize,
+                    available - inner.blockSize) != 0)
+    return -1;
+  return inverseTransform(work, n, primary, out);
+}
+
+long huffmanBwtDecode(struct HuffmanBwtWork *work, const unsigned char *in,
+                      unsigned long size, char *out, unsigned long outSize)
+{
+  struct HuffmanBlockInfo info;
+
+  if (huffmanBlockParse(in, size, &info) != 0)
+    return -1;
+  if (info.type != HUFF_BLOCK_BWT)
+    return huffmanBlockDecode(&work->context.decode, in, size, out,
+                              outSize);
+
+  if (huffmanBlockVerify(in, &info) != 0 || info.rawSize > outSize ||
+      decodeBwtBody(work, in + HUFF_BLOCK_HEADER_SIZE, &info, out) != 0)
+    return -1;
+  return (long)info.rawSize;
+}
@@ -0,0 +1,94 @@
+/*
+ * Algoritmo de Codificação de Huffman - BWT + MTF + RLE
+ *
+ * Descrição:
+ * Pré-processamento como no bzip2, para arquivar logs de texto: a
+ * transformada de Burrows-Wheeler (calculada com um vetor de sufixos)
+ * agrupa os bytes que aparecem antes de contextos parecidos, o
+ * move-to-front transforma essas repetições locais em valores pequenos
+ * (quase sempre 0), as corridas de zeros viram poucos símbolos e o
+ * resultado é codificado com as tabelas por segmento de huffman_context.c.
+ *
+ * Símbolos após o MTF: as corridas de zeros são gravadas em base 2
+ * bijetiva com RUNA (0, vale 1) e RUNB (1, vale 2), cada dígito com o dobro
+ * do peso do anterior, e um valor v >= 1 vira o símbolo v + 1. O MTF usa
+ * só os bytes presentes no bloco, então há até HUFF_ALPHABET_SIZE + 1
+ * símbolos; se faltar um, o último símbolo vale para os dois valores mais
+ * altos e é seguido de um bit extra (0 para o menor).
+ *
+ * Corpo de um bloco HUFF_BLOCK_BWT: 4 bytes (little-endian) com a linha da
+ * entrada original na matriz ordenada das rotações de entrada + sentinela,
+ * 32 bytes com o mapa dos bytes presentes (bit i % 8 do byte i / 8, o mais
+ * significativo primeiro), um bloco completo (huffman_frame.h) com os
+ * símbolos, gerado por huffmanSegmentsEncode, e os bits extras do último
+ * símbolo, o mais significativo primeiro, completados com zeros.
+ *
+ * O vetor de sufixos, os postos e os buffers intermediários ficam em uma
+ * HuffmanBwtWork do chamador, de cerca de 18 * HUFF_BWT_MAX_BLOCK bytes
+ * (16 MB): o módulo é para o host, e quem não o usa não paga essa memória.
+ */
+#ifndef HUFFMAN_BWT_H
+#define HUFFMAN_BWT_H
+
+#include "huffman_context.h"
+
+#define HUFF_BLOCK_BWT 7 // BWT + MTF + corridas de zeros, com tabelas por segmento
+
+#define HUFF_BWT_MAX_BLOCK 900000ul // Maior entrada de um bloco BWT (como bzip2 -9)
+#define HUFF_BWT_MAP_SIZE 32        // Bytes do mapa de bytes presentes
+
+// Memória de trabalho de huffmanBwtEncode e huffmanBwtDecode. Grande demais
+// para a pilha: aloque com calloc (ou como estática do programa), zerada, e
+// use uma por thread.
+struct HuffmanBwtWork
+{
+  // Vetor de sufixos; na decodificação, o mapeamento LF de cada linha
+  unsigned suffixes[HUFF_BWT_MAX_BLOCK + 1];
+  unsigned ranks[HUFF_BWT_MAX_BLOCK];
+  unsigned scratch[HUFF_BWT_MAX_BLOCK];
+  unsigned counts[HUFF_BWT_MAX_BLOCK + 2];
+  unsigned char last[HUFF_BWT_MAX_BLOCK];            // Última coluna, sem a sentinela
+  unsigned char symbols[HUFF_BWT_MAX_BLOCK];         // MTF com corridas de zeros
+  unsigned char escapes[HUFF_BWT_MAX_BLOCK / 8 + 1]; // Bits extras
+  unsigned freq[HUFF_ALPHABET_SIZE];
+  struct HuffmanCodeTable codes;
+  // Bloco de símbolos (SEGMENTS) e blocos de huffman_frame.c
+  struct HuffmanContextWork context;
+};
+
+/**
+ * Comprime a entrada em um bloco HUFF_BLOCK_BWT. Se a entrada passar de
+ * HUFF_BWT_MAX_BLOCK ou a transformada não deixar o bloco menor que o de
+ * ordem 0, gera o bloco de huffmanBlockEncode.
+ *
+ * @param work Memória de trabalho.
+ * @param in Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @param out Buffer de saída, com ao menos huffmanBlockBound(size) bytes
+ *            para nunca falhar.
+ * @param outSize Capacidade do buffer de saída.
+ * @param flags HUFF_BLOCK_FLAG_CRC para acrescentar o CRC32C, ou 0.
+ * @return Tamanho do bloco, ou -1 se não couber em out ou se algum
+ *         caractere estiver fora do alfabeto.
+ */
+long huffmanBwtEncode(struct HuffmanBwtWork *work, const char *in,
+                      unsigned long size, unsigned char *out,
+                      unsigned long outSize, int flags);
+
+/**
+ * Decodifica um bloco HUFF_BLOCK_BWT, conferindo o CRC32C se presente. Os
+ * tipos de huffman_frame.c, que huffmanBwtEncode gera quando a transformada
+ * não compensa, são repassados a huffmanBlockDecode; os demais são recusados
+ * (ver huffmanDecodeAnyBlock).
+ *
+ * @param work Memória de trabalho.
+ * @param in Início do bloco.
+ * @param size Bytes disponíveis a partir de in.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @return Tamanho original, ou -1 se o bloco for inválido ou não couber em out.
+ */
+long huffmanBwtDecode(struct HuffmanBwtWork *work, const unsigned char *in,
+                      unsigned long size, char *out, unsigned long outSize);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Algoritmo de Codificação de Huffman - Peças comuns dos blocos de host
+ *
+ * Descrição:
+ * Partes fora do laço de cada símbolo: fim do fluxo de bits, tabelas de
+ * comprimentos e tamanho do bloco de ordem 0. Ver huffman_coder.h.
+ */
+#include <string.h>
+#include "huffman_coder.h"
+
+void huffmanFlushBits(struct HuffmanBitWriter *writer)
+{
+  if (writer->bitCount > 0)
+    *writer->p = (unsigned char)(writer->bitBuffer << (8 - writer->bitCount));
+}
+
+int huffmanReadBit(struct HuffmanBitReader *reader)
+{
+  huffmanRefill(reader);
+  if (reader->bitCount == 0)
+    return -1;
+  reader->bitCount--;
+  return (int)(reader->bitBuffer >> reader->bitCount) & 1;
+}
+
+int huffmanCheckPadding(const struct HuffmanBitReader *reader,
+                        const struct HuffmanBlockInfo *info)
+{
+  unsigned long long consumed = 8ull * reader->pos - (unsigned)reader->bitCount;
+
+  return consumed + (unsigned)(info->flags & HUFF_BLOCK_PADDING_MASK) ==
+                 8ull * reader->size
+             ? 0
+             : -1;
+}
+
+void huffmanWriteNibbles(unsigned char *p, const unsigned char values[],
+                         int count)
+{
+  memset(p, 0, (size_t)(count + 1) / 2);
+  for (int i = 0; i < count; ++i)
+    p[i / 2] |= (unsigned char)(values[i] << (i % 2 ? 0 : 4));
+}
+
+int huffmanReadLengths(const unsigned char *lengths, int symbols,
+                       struct HuffmanCodeTable *codes,
+                       struct HuffmanLookupTable *table)
+{
+  memset(codes, 0, sizeof(*codes));
+  for (int i = 0; i < symbols; ++i)
+    codes->len[i] = (lengths[i / 2] >> (i % 2 ? 0 : 4)) & 0x0F;
+  if (assignCanonicalCodes(codes) != 0 ||
+      buildCanonicalTable(codes->len, &table->canonical) != 0)
+    return -1;
+
+  // Cada código curto ocupa todas as entradas que começam com ele
+  memset(table->entry, 0, sizeof(table->entry));
+  for (int i = 0; i < symbols; ++i)
+  {
+    int len = codes->len[i];
+    if (len == 0 || len > HUFF_CODER_LOOKUP_BITS)
+      continue;
+    unsigned first = (unsigned)codes->bits[i] << (HUFF_CODER_LOOKUP_BITS - len);
+    for (unsigned x = 0; x < (1u << (HUFF_CODER_LOOKUP_BITS - len)); ++x)
+      table->entry[first + x] = (unsigned short)(len << 8 | i);
+  }
+  return 0;
+}
+
+unsigned long huffmanOrder0Size(struct HuffmanTreeWork *tree,
+                                const unsigned freq[],
+                                struct HuffmanCodeTable *codes)
+{
+  int symbols = 0;
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (freq[i] != 0)
+      symbols = i + 1;
+  }
+  buildCodeTable(tree, freq, codes);
+  return 1 + (unsigned long)(symbols + 1) / 2 +
+         (unsigned long)((huffmanEncodedBits(freq, codes) + 7) / 8);
+}
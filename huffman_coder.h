@@ -0,0 +1,176 @@
+/*
+ * Algoritmo de Codificação de Huffman - Peças comuns dos blocos de host
+ *
+ * Descrição:
+ * Fluxo de bits com o mais significativo primeiro, tabelas de comprimentos
+ * em nibbles, consulta de decodificação e tamanho do bloco de ordem 0,
+ * usados pelos blocos de huffman_context.c, huffman_lz.c e huffman_bwt.c.
+ * Uso interno desses módulos: não faz parte da API dos blocos (as
+ * estruturas aparecem nos cabeçalhos deles só para dimensionar a memória
+ * de trabalho).
+ *
+ * A escrita de bits e a leitura de símbolos ficam no cabeçalho (static
+ * inline), pois são chamadas a cada símbolo.
+ */
+#ifndef HUFFMAN_CODER_H
+#define HUFFMAN_CODER_H
+
+#include "huffman_frame.h"
+
+#define HUFF_CODER_LOOKUP_BITS 10 // Bits resolvidos por consulta na decodificação
+
+// Fluxo de bits de saída, o mais significativo primeiro
+struct HuffmanBitWriter
+{
+  unsigned char *p;   // Próximo byte a gravar
+  unsigned bitBuffer; // Bits que ainda não completam um byte
+  int bitCount;       // Quantidade de bits em bitBuffer
+};
+
+// Fluxo de bits de entrada, o mais significativo primeiro
+struct HuffmanBitReader
+{
+  const unsigned char *in;      // Dados comprimidos
+  unsigned long size;           // Tamanho de in
+  unsigned long pos;            // Próximo byte a carregar
+  unsigned long long bitBuffer; // Bits carregados
+  int bitCount;                 // Bits de bitBuffer ainda não lidos
+};
+
+// Tabela de decodificação de um conjunto de comprimentos
+struct HuffmanLookupTable
+{
+  // Primeiros HUFF_CODER_LOOKUP_BITS bits -> (comprimento << 8) | símbolo,
+  // ou 0 se o código for mais longo (ou inválido)
+  unsigned short entry[1 << HUFF_CODER_LOOKUP_BITS];
+  struct HuffmanCanonicalTable canonical; // Códigos mais longos
+};
+
+// Grava len bits (até 24, com os pendentes) de bits
+static inline void huffmanPutBits(struct HuffmanBitWriter *writer,
+                                  unsigned bits, int len)
+{
+  writer->bitBuffer = (writer->bitBuffer << len) | bits;
+  writer->bitCount += len;
+  while (writer->bitCount >= 8)
+  {
+    writer->bitCount -= 8;
+    *writer->p++ = (unsigned char)(writer->bitBuffer >> writer->bitCount);
+  }
+}
+
+// Com 57 bits ou mais no buffer, qualquer código ou extra cabe
+static inline void huffmanRefill(struct HuffmanBitReader *reader)
+{
+  while (reader->bitCount <= 56 && reader->pos < reader->size)
+  {
+    reader->bitBuffer = (reader->bitBuffer << 8) | reader->in[reader->pos++];
+    reader->bitCount += 8;
+  }
+}
+
+// Lê um símbolo com a tabela dada, ou retorna -1 se o código for inválido
+static inline int huffmanReadSymbol(struct HuffmanBitReader *reader,
+                                    const struct HuffmanLookupTable *table)
+{
+  const struct HuffmanCanonicalTable *canonical = &table->canonical;
+  unsigned code;
+  unsigned entry;
+
+  huffmanRefill(reader);
+  if (reader->bitCount >= HUFF_CODER_LOOKUP_BITS)
+    code = (unsigned)(reader->bitBuffer >>
+                      (reader->bitCount - HUFF_CODER_LOOKUP_BITS));
+  else
+    code = (unsigned)(reader->bitBuffer
+                      << (HUFF_CODER_LOOKUP_BITS - reader->bitCount));
+  code &= (1u << HUFF_CODER_LOOKUP_BITS) - 1;
+  entry = table->entry[code];
+  if (entry != 0)
+  {
+    if ((int)(entry >> 8) > reader->bitCount)
+      return -1;
+    reader->bitCount -= (int)(entry >> 8);
+    return (int)(entry & 0xFF);
+  }
+
+  // Código longo: continua a partir da consulta, como huffmanDecodeCanonical
+  if (reader->bitCount < HUFF_CODER_LOOKUP_BITS)
+    return -1;
+  reader->bitCount -= HUFF_CODER_LOOKUP_BITS;
+  for (int len = HUFF_CODER_LOOKUP_BITS + 1; len <= HUFF_MAX_CODE_LEN; ++len)
+  {
+    if (reader->bitCount == 0)
+      return -1;
+    reader->bitCount--;
+    code = (code << 1) | (unsigned)((reader->bitBuffer >> reader->bitCount) & 1);
+    if (code - canonical->first[len] < canonical->count[len])
+      return canonical->symbols[canonical->offset[len] + code -
+                                canonical->first[len]];
+  }
+  return -1;
+}
+
+/**
+ * Completa o último byte com zeros.
+ *
+ * @param writer Fluxo de saída.
+ */
+void huffmanFlushBits(struct HuffmanBitWriter *writer);
+
+/**
+ * Lê um bit.
+ *
+ * @param reader Fluxo de entrada.
+ * @return O bit, ou -1 se a entrada acabou.
+ */
+int huffmanReadBit(struct HuffmanBitReader *reader);
+
+/**
+ * Confere que só sobraram os bits de preenchimento anunciados no cabeçalho.
+ *
+ * @param reader Fluxo de entrada, depois do último símbolo.
+ * @param info Campos do cabeçalho do bloco.
+ * @return 0 em caso de sucesso, -1 se sobrarem ou faltarem bits.
+ */
+int huffmanCheckPadding(const struct HuffmanBitReader *reader,
+                        const struct HuffmanBlockInfo *info);
+
+/**
+ * Grava 4 bits por posição, posição par no nibble alto.
+ *
+ * @param p Destino, com ceil(count / 2) bytes.
+ * @param values Valores de 0 a 15.
+ * @param count Quantidade de valores.
+ */
+void huffmanWriteNibbles(unsigned char *p, const unsigned char values[],
+                         int count);
+
+/**
+ * Lê uma tabela de comprimentos gravada com huffmanWriteNibbles e prepara
+ * os códigos e a tabela de decodificação.
+ *
+ * @param lengths Comprimentos (ceil(symbols / 2) bytes).
+ * @param symbols Símbolos na tabela (até HUFF_ALPHABET_SIZE).
+ * @param codes Recebe os comprimentos e os códigos canônicos.
+ * @param table Recebe a tabela de decodificação.
+ * @return 0 em caso de sucesso, -1 se os comprimentos forem inválidos.
+ */
+int huffmanReadLengths(const unsigned char *lengths, int symbols,
+                       struct HuffmanCodeTable *codes,
+                       struct HuffmanLookupTable *table);
+
+/**
+ * Tamanho do corpo que o bloco HUFFMAN teria com o histograma dado, para
+ * os blocos de host compararem com o seu.
+ *
+ * @param tree Memória de trabalho da árvore.
+ * @param freq Histograma da entrada.
+ * @param codes Área de trabalho: recebe os códigos de ordem 0.
+ * @return Tamanho do corpo, sem cabeçalho e CRC.
+ */
+unsigned long huffmanOrder0Size(struct HuffmanTreeWork *tree,
+                                const unsigned freq[],
+                                struct HuffmanCodeTable *codes);
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Perfis de orçamento de RAM do codificador de Huffman.
+ *
+ * Cada perfil define o tamanho do alfabeto, o comprimento máximo de código e
+ * o tamanho do bloco de saída. Todos os arrays estáticos de huffman.c são
+ * dimensionados a partir desses valores, e huffman.c falha na compilação
+ * (_Static_assert) se o total ultrapassar o orçamento de RAM do perfil.
+ *
+ * Seleção do perfil:
+ * - Automática: STM32F030 quando compilado para ARM, HOST caso contrário.
+ * - Manual: -DHUFF_PROFILE=STM32F030 (ou HOST) na linha de compilação.
+ *
+ * O relatório de footprint de cada perfil é gerado por huffman_footprint.c.
+ */
+#ifndef HUFFMAN_CONFIG_H
+#define HUFFMAN_CONFIG_H
+
+// Perfil HOST: PC (Windows/Linux), sem restrição real de memória
+#define HUFF_HOST_ALPHABET_SIZE 256     // Bytes de 0 a 255
+#define HUFF_HOST_MAX_CODE_LEN 15       // Comprimento máximo de código (bits)
+#define HUFF_HOST_OUT_CHUNK 4096        // Bloco de saída (bytes)
+#define HUFF_HOST_RAM_BUDGET (64 * 1024) // Orçamento de RAM do codificador
+
+// Perfil STM32F030: 8 KB de SRAM, dos quais 6 KB ficam para o codificador
+#define HUFF_STM32F030_ALPHABET_SIZE 128      // Apenas ASCII de 7 bits
+#define HUFF_STM32F030_MAX_CODE_LEN 12
+#define HUFF_STM32F030_OUT_CHUNK 64
+#define HUFF_STM32F030_RAM_BUDGET (6 * 1024)
+
+#ifndef HUFF_PROFILE
+#if defined(__arm__)
+#define HUFF_PROFILE STM32F030
+#else
+#define HUFF_PROFILE HOST
+#endif
+#endif
+
+// Expande HUFF_<perfil>_<parâmetro> para o perfil selecionado
+#define HUFF_PARAM_(profile, param) HUFF_##profile##_##param
+#define HUFF_PARAM(profile, param) HUFF_PARAM_(profile, param)
+
+#define HUFF_ALPHABET_SIZE HUFF_PARAM(HUFF_PROFILE, ALPHABET_SIZE)
+#define HUFF_MAX_CODE_LEN HUFF_PARAM(HUFF_PROFILE, MAX_CODE_LEN)
+#define HUFF_OUT_CHUNK HUFF_PARAM(HUFF_PROFILE, OUT_CHUNK)
+#define HUFF_RAM_BUDGET HUFF_PARAM(HUFF_PROFILE, RAM_BUDGET)
+
+#if HUFF_ALPHABET_SIZE > 256
+#error "HUFF_ALPHABET_SIZE deve caber em um byte"
+#endif
+
+#if HUFF_OUT_CHUNK < 8
+#error "HUFF_OUT_CHUNK deve comportar ao menos o cabeçalho do fluxo"
+#endif
+
+#if HUFF_MAX_CODE_LEN > 16
+#error "HUFF_MAX_CODE_LEN deve caber em unsigned short"
+#endif
+
+// Com todos os pesos iguais a 1 a árvore tem altura ceil(log2(alfabeto))
+#if (1 << HUFF_MAX_CODE_LEN) < HUFF_ALPHABET_SIZE
+#error "HUFF_MAX_CODE_LEN pequeno demais para o alfabeto"
+#endif
+
+#endif
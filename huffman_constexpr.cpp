@@ -0,0 +1,63 @@
+/*
+ * Algoritmo de Codificação de Huffman - Tabelas em tempo de compilação
+ *
+ * Descrição:
+ * Exemplo de protocolo com estatística fixa: as linhas de telemetria têm
+ * sempre o mesmo formato, então o histograma é conhecido na compilação e
+ * todo o pipeline (histograma -> comprimentos -> códigos canônicos ->
+ * árvore de decodificação) é avaliado pelo compilador. As tabelas ficam em
+ * .rodata e são conferidas com static_assert; em execução só há consulta.
+ *
+ * Uso:
+ * g++ -std=c++20 huffman_constexpr.cpp -o huffman_constexpr
+ * (com -std=c++17 as tabelas continuam constexpr, mas sem consteval)
+ */
+#include <cstdio>
+#include <cstring>
+#include "huffman.hpp"
+
+constexpr std::size_t kAlphabet = 128;
+constexpr unsigned kMaxBits = 12;
+
+// Amostra representativa do protocolo: temperatura, umidade, pressão e tensão
+constexpr std::string_view kSample = "T=23.51,H=45.20,P=1013.25,V=3.301\n"
+                                     "T=-4.07,H=88.90,P=998.70,V=3.298\n"
+                                     "T=31.66,H=12.45,P=1021.03,V=3.287\n"
+                                     "T=17.89,H=67.34,P=1005.46,V=3.312\n";
+
+static_assert(huffman::fitsAlphabet<kAlphabet>(kSample),
+              "A amostra tem símbolos fora do alfabeto");
+
+constexpr auto kFreq = huffman::makeHistogram<kAlphabet>(kSample);
+
+#if __cplusplus >= 202002L
+constexpr auto kTables = huffman::compileTables<kAlphabet, kMaxBits>(kFreq);
+#else
+constexpr auto kTables = huffman::makeTables<kAlphabet, kMaxBits>(kFreq);
+#endif
+
+static_assert(huffman::verifyTables(kTables, kFreq),
+              "Tabelas de Huffman inconsistentes");
+static_assert(kTables.codes.len['.'] < kTables.codes.len['V'],
+              "Símbolos mais frequentes devem ter códigos mais curtos");
+
+static constexpr huffman::Encoder<kAlphabet, kMaxBits> encoder(kTables);
+static constexpr huffman::Decoder<kAlphabet, kMaxBits> decoder(kTables);
+
+int main()
+{
+  static const char message[] = "T=19.02,H=53.18,P=1009.87,V=3.305\n";
+  const std::size_t size = sizeof(message) - 1;
+  unsigned char compressed[encoder.bound(sizeof(message))];
+  unsigned char decoded[sizeof(message)];
+
+  std::uint64_t bits = encoder.encode(
+      reinterpret_cast<const unsigned char *>(message), size, compressed);
+  bool ok = decoder.decode(compressed, (bits + 7) / 8, decoded, size) &&
+            std::memcmp(decoded, message, size) == 0;
+
+  std::printf("Mensagem: %zu bytes, comprimida: %llu bytes\n", size,
+              static_cast<unsigned long long>((bits + 7) / 8));
+  std::printf("Descompressao confere: %s\n", ok ? "sim" : "nao");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,685 @@
+/*
+ * Algoritmo de Codificação de Huffman - Blocos com várias tabelas
+ *
+ * Descrição:
+ * Modelo de ordem 1: conta um histograma por contexto (símbolo anterior),
+ * agrupa os contextos de estatísticas parecidas até sobrarem no máximo
+ * HUFF_CONTEXT_TABLES tabelas e codifica cada símbolo com a tabela do seu
+ * grupo. Tabelas por segmento: escolhe, a cada HUFF_SEGMENT_SIZE símbolos,
+ * a melhor de até HUFF_SEGMENT_TABLES tabelas, refinadas em alguns passes
+ * como no bzip2. Ver huffman_context.h.
+ */
+#include <string.h>
+#include "huffman_context.h"
+#include "huffman_coder.h"
+
+#if HUFF_CONTEXT_TABLES > 16
+#error "O mapa de contextos guarda o índice da tabela em 4 bits"
+#endif
+#if HUFF_SEGMENT_TABLES > HUFF_CONTEXT_TABLES
+#error "As tabelas de segmento usam os mesmos arrays das de contexto"
+#endif
+
+#define SEGMENT_PASSES 4      // Passes de escolha e reconstrução das tabelas
+
+/**
+ * Calcula x * log2(x) em Q8, sem libm: a parte inteira do logaritmo é a
+ * posição do bit mais alto, e os 16 bits da fração saem elevando a mantissa
+ * ao quadrado.
+ */
+static unsigned long long computeXlog2(unsigned long x)
+{
+  unsigned long long mantissa;
+  unsigned long log2Q16;
+  unsigned n = 0;
+
+  if (x < 2)
+    return 0;
+  while ((x >> n) > 1)
+    n++;
+
+  // Mantissa em [1, 2) com 30 bits de fração
+  mantissa = ((unsigned long long)x << 30) >> n;
+  log2Q16 = (unsigned long)n << 16;
+  for (int bit = 15; bit >= 0; --bit)
+  {
+    mantissa = (mantissa * mantissa) >> 30;
+    if (mantissa >= 2ull << 30)
+    {
+      mantissa >>= 1;
+      log2Q16 |= 1ul << bit;
+    }
+  }
+  return ((unsigned long long)x * log2Q16 + 128) >> 8;
+}
+
+// x * log2(x) em Q8; as contagens por contexto costumam ser pequenas
+static unsigned long long xlog2(const struct HuffmanContextWork *work,
+                                unsigned long x)
+{
+  return x < HUFF_CONTEXT_XLOG ? work->xlogTable[x] : computeXlog2(x);
+}
+
+/**
+ * Bits estimados (em Q8) para codificar um grupo com uma tabela própria: a
+ * entropia, count * log2(count) - soma de f * log2(f), mas nunca menos de
+ * 1 bit por símbolo (o mínimo de um código de Huffman), mais a tabela de
+ * comprimentos.
+ */
+static long long groupCost(const struct HuffmanContextWork *work,
+                           unsigned long count, unsigned long long sum,
+                           unsigned long tableBits)
+{
+  unsigned long long bits = xlog2(work, count) - sum;
+
+  if (bits < 256ull * count)
+    bits = 256ull * count;
+  return (long long)(bits + 256ull * tableBits);
+}
+
+// Recalcula a soma e a lista de símbolos presentes na linha c
+static void updateRow(struct HuffmanContextWork *work, int c, int symbols)
+{
+  work->ctxSum[c] = 0;
+  work->ctxDistinct[c] = 0;
+  for (int i = 0; i < symbols; ++i)
+  {
+    if (work->ctxFreq[c][i] != 0)
+    {
+      work->ctxSum[c] += xlog2(work, work->ctxFreq[c][i]);
+      work->ctxSymbols[c][work->ctxDistinct[c]++] = (unsigned char)i;
+    }
+  }
+}
+
+/**
+ * Variação do custo total se os grupos a e b passarem a dividir uma tabela.
+ * Um símbolo ausente em um dos dois não muda a soma de f * log2(f), então
+ * basta percorrer os símbolos do grupo com menos deles.
+ */
+static long long mergeDelta(const struct HuffmanContextWork *work, int a, int b,
+                            unsigned long tableBits)
+{
+  unsigned long long sum = work->ctxSum[a] + work->ctxSum[b];
+
+  if (work->ctxDistinct[b] < work->ctxDistinct[a])
+  {
+    int swap = a;
+    a = b;
+    b = swap;
+  }
+  for (int k = 0; k < work->ctxDistinct[a]; ++k)
+  {
+    unsigned char i = work->ctxSymbols[a][k];
+    if (work->ctxFreq[b][i] != 0)
+      sum += xlog2(work, work->ctxFreq[a][i] + work->ctxFreq[b][i]) -
+             xlog2(work, work->ctxFreq[a][i]) -
+             xlog2(work, work->ctxFreq[b][i]);
+  }
+  return groupCost(work, work->ctxCount[a] + work->ctxCount[b], sum,
+                   tableBits) -
+         groupCost(work, work->ctxCount[a], work->ctxSum[a], tableBits) -
+         groupCost(work, work->ctxCount[b], work->ctxSum[b], tableBits);
+}
+
+// Escolhe, entre as fusões já calculadas, a mais barata para o grupo a
+static void findPartner(struct HuffmanContextWork *work, int a, int symbols)
+{
+  work->partner[a] = -1;
+  for (int b = 0; b < symbols; ++b)
+  {
+    if (b != a && work->ctxCount[b] != 0 &&
+        (work->partner[a] < 0 ||
+         work->pairDelta[a][b] < work->pairDelta[a][work->partner[a]]))
+      work->partner[a] = (short)b;
+  }
+}
+
+/**
+ * Agrupa os contextos de ctxFreq fundindo sempre o par mais barato:
+ * obrigatoriamente enquanto houver mais de HUFF_CONTEXT_TABLES grupos, e
+ * depois só enquanto a fusão economizar bits (uma tabela a menos compensa
+ * estatísticas um pouco piores). O custo de cada par fica em pairDelta, e
+ * uma fusão só recalcula os pares do grupo resultante.
+ *
+ * @param symbols Contextos e símbolos em uso.
+ * @return Quantidade de grupos; ctxGroup indica o de cada contexto.
+ */
+static int clusterContexts(struct HuffmanContextWork *work, int symbols)
+{
+  unsigned long tableBits = 8ul * (unsigned long)((symbols + 1) / 2);
+  int groups = 0;
+
+  if (work->xlogTable[2] == 0)
+  {
+    for (unsigned long x = 0; x < HUFF_CONTEXT_XLOG; ++x)
+      work->xlogTable[x] = (unsigned)computeXlog2(x);
+  }
+
+  for (int c = 0; c < symbols; ++c)
+  {
+    work->ctxGroup[c] = (unsigned char)c;
+    updateRow(work, c, symbols);
+    if (work->ctxCount[c] != 0)
+      groups++;
+  }
+  for (int a = 0; a < symbols; ++a)
+  {
+    for (int b = a + 1; b < symbols; ++b)
+    {
+      if (work->ctxCount[a] != 0 && work->ctxCount[b] != 0)
+        work->pairDelta[a][b] = work->pairDelta[b][a] =
+            mergeDelta(work, a, b, tableBits);
+    }
+  }
+  for (int c = 0; c < symbols; ++c)
+    findPartner(work, c, symbols);
+
+  while (groups > 1)
+  {
+    int a = -1;
+
+    for (int c = 0; c < symbols; ++c)
+    {
+      if (work->ctxCount[c] != 0 && work->partner[c] >= 0 &&
+          (a < 0 || work->pairDelta[c][work->partner[c]] <
+                        work->pairDelta[a][work->partner[a]]))
+        a = c;
+    }
+    if (groups <= HUFF_CONTEXT_TABLES &&
+        work->pairDelta[a][work->partner[a]] >= 0)
+      break;
+
+    // O grupo b passa para a linha de a
+    int b = work->partner[a];
+    for (int i = 0; i < symbols; ++i)
+      work->ctxFreq[a][i] += work->ctxFreq[b][i];
+    work->ctxCount[a] += work->ctxCount[b];
+    work->ctxCount[b] = 0;
+    updateRow(work, a, symbols);
+    for (int c = 0; c < symbols; ++c)
+    {
+      if (work->ctxGroup[c] == b)
+        work->ctxGroup[c] = (unsigned char)a;
+    }
+    groups--;
+
+    for (int c = 0; c < symbols; ++c)
+    {
+      if (c != a && work->ctxCount[c] != 0)
+        work->pairDelta[a][c] = work->pairDelta[c][a] =
+            mergeDelta(work, a, c, tableBits);
+    }
+
+    // Quem apontava para a ou b procura de novo; os demais só comparam com a
+    for (int c = 0; c < symbols; ++c)
+    {
+      if (c == a || work->ctxCount[c] == 0)
+        continue;
+      if (work->partner[c] == a || work->partner[c] == b)
+        findPartner(work, c, symbols);
+      else if (work->pairDelta[c][a] < work->pairDelta[c][work->partner[c]])
+        work->partner[c] = (short)a;
+    }
+    findPartner(work, a, symbols);
+  }
+  return groups;
+}
+
+// Codifica a entrada trocando de tabela conforme o símbolo anterior
+static void encodeContext(const struct HuffmanContextWork *work,
+                          const char *in, unsigned long size,
+                          unsigned char *out)
+{
+  struct HuffmanBitWriter writer = {out, 0, 0};
+  unsigned char prev = 0;
+
+  for (unsigned long i = 0; i < size; ++i)
+  {
+    const struct HuffmanCodeTable *table = &work->codes[work->tableOf[prev]];
+    unsigned char c = (unsigned char)in[i];
+
+    huffmanPutBits(&writer, table->bits[c], table->len[c]);
+    prev = c;
+  }
+  huffmanFlushBits(&writer);
+}
+
+long huffmanContextEncode(struct HuffmanContextWork *work, const char *in,
+                          unsigned long size, unsigned char *out,
+                          unsigned long outSize, int flags)
+{
+  unsigned long reserved =
+      HUFF_BLOCK_HEADER_SIZE + (flags & HUFF_BLOCK_FLAG_CRC ? HUFF_BLOCK_CRC_SIZE : 0);
+  unsigned char *body = out + HUFF_BLOCK_HEADER_SIZE;
+  unsigned char index[HUFF_ALPHABET_SIZE];
+  unsigned long long bits = 0;
+  unsigned char prev = 0;
+  int symbols = 0;
+  int distinct = 0;
+  int tables = 0;
+
+  flags &= HUFF_BLOCK_FLAG_CRC;
+  if (size < HUFF_CONTEXT_MIN_BLOCK)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+
+  memset(work->freq, 0, sizeof(work->freq));
+  memset(work->ctxCount, 0, sizeof(work->ctxCount));
+  memset(work->ctxFreq, 0, sizeof(work->ctxFreq));
+  for (unsigned long i = 0; i < size; ++i)
+  {
+    unsigned char c = (unsigned char)in[i];
+#if HUFF_ALPHABET_SIZE < 256
+    if (c >= HUFF_ALPHABET_SIZE)
+      return -1;
+#endif
+    work->ctxFreq[prev][c]++;
+    work->ctxCount[prev]++;
+    work->freq[c]++;
+    prev = c;
+  }
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (work->freq[i] != 0)
+    {
+      symbols = i + 1;
+      distinct++;
+    }
+  }
+
+  // Vazio ou um só símbolo: não há o que modelar
+  if (distinct <= 1)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+
+  unsigned long mapSize = (unsigned long)(symbols + 1) / 2;
+  unsigned long order0Size =
+      huffmanOrder0Size(&work->tree, work->freq, &work->codes[0]);
+
+  clusterContexts(work, symbols);
+  for (int c = 0; c < symbols; ++c)
+  {
+    if (work->ctxCount[c] != 0)
+    {
+      index[c] = (unsigned char)tables;
+      buildCodeTable(&work->tree, work->ctxFreq[c], &work->codes[tables]);
+      bits += huffmanEncodedBits(work->ctxFreq[c], &work->codes[tables]);
+      tables++;
+    }
+  }
+  // Contextos que não aparecem ficam com a tabela 0
+  for (int c = 0; c < symbols; ++c)
+    work->tableOf[c] =
+        work->ctxCount[work->ctxGroup[c]] != 0 ? index[work->ctxGroup[c]] : 0;
+
+  unsigned long headerSize = 2 + mapSize * (unsigned long)(tables + 1);
+  unsigned long bodySize = headerSize + (unsigned long)((bits + 7) / 8);
+  if (bodySize >= order0Size || bodySize >= size)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+  if (outSize < reserved || outSize - reserved < bodySize)
+    return -1;
+
+  body[0] = (unsigned char)symbols; // 256 vira 0
+  body[1] = (unsigned char)tables;
+  huffmanWriteNibbles(body + 2, work->tableOf, symbols);
+  for (int t = 0; t < tables; ++t)
+    huffmanWriteNibbles(body + 2 + mapSize * (unsigned long)(t + 1),
+                        work->codes[t].len, symbols);
+
+  // O espaço já foi conferido: a codificação não verifica limites
+  encodeContext(work, in, size, body + headerSize);
+
+  flags |= (int)((8 - bits % 8) % 8);
+  return huffmanBlockFinish(out, HUFF_BLOCK_CONTEXT, flags, size, bodySize);
+}
+
+/**
+ * Quantidade de tabelas para um bloco, como no bzip2: blocos curtos não
+ * pagam o custo de muitas tabelas.
+ */
+static int segmentTables(unsigned long size)
+{
+  if (size < 200)
+    return 2;
+  if (size < 600)
+    return 3;
+  if (size < 1200)
+    return 4;
+  if (size < 2400)
+    return 5;
+  return HUFF_SEGMENT_TABLES;
+}
+
+/**
+ * Ponto de partida das tabelas: os símbolos são divididos em faixas de
+ * frequência total parecida, e a tabela t começa barata para a sua faixa e
+ * cara para as demais.
+ */
+static void seedSegmentCosts(struct HuffmanContextWork *work, int symbols,
+                             unsigned long size, int tables)
+{
+  unsigned long remaining = size;
+  int first = 0;
+
+  for (int t = 0; t < tables; ++t)
+  {
+    unsigned long target = remaining / (unsigned long)(tables - t);
+    unsigned long sum = 0;
+    int last = first - 1;
+
+    while (sum < target && last < symbols - 1)
+      sum += work->freq[++last];
+    for (int c = 0; c < symbols; ++c)
+      work->segCost[t][c] = c >= first && c <= last ? 0 : HUFF_MAX_CODE_LEN;
+    first = last + 1;
+    remaining -= sum;
+  }
+}
+
+// Escolhe para cada segmento a tabela mais barata e conta nela os símbolos
+static void assignSegments(struct HuffmanContextWork *work, const char *in,
+                           unsigned long size, int tables)
+{
+  unsigned long segment = 0;
+
+  memset(work->segFreq, 0, sizeof(work->segFreq));
+  for (unsigned long start = 0; start < size; start += HUFF_SEGMENT_SIZE)
+  {
+    unsigned long end =
+        size - start < HUFF_SEGMENT_SIZE ? size : start + HUFF_SEGMENT_SIZE;
+    unsigned long cost[HUFF_SEGMENT_TABLES] = {0};
+    int best = 0;
+
+    for (unsigned long i = start; i < end; ++i)
+    {
+      for (int t = 0; t < tables; ++t)
+        cost[t] += work->segCost[t][(unsigned char)in[i]];
+    }
+    for (int t = 1; t < tables; ++t)
+    {
+      if (cost[t] < cost[best])
+        best = t;
+    }
+
+    work->selectors[segment++] = (unsigned char)best;
+    for (unsigned long i = start; i < end; ++i)
+      work->segFreq[best][(unsigned char)in[i]]++;
+  }
+}
+
+// Move value para o início da lista e retorna a posição em que estava
+static int moveToFront(unsigned char order[], unsigned char value)
+{
+  int rank = 0;
+
+  while (order[rank] != value)
+    rank++;
+  memmove(order + 1, order, (size_t)rank);
+  order[0] = value;
+  return rank;
+}
+
+long huffmanSegmentsEncode(struct HuffmanContextWork *work, const char *in,
+                           unsigned long size, unsigned char *out,
+                           unsigned long outSize, int flags)
+{
+  unsigned long reserved =
+      HUFF_BLOCK_HEADER_SIZE + (flags & HUFF_BLOCK_FLAG_CRC ? HUFF_BLOCK_CRC_SIZE : 0);
+  unsigned char *body = out + HUFF_BLOCK_HEADER_SIZE;
+  unsigned char order[HUFF_SEGMENT_TABLES];
+  unsigned char index[HUFF_SEGMENT_TABLES];
+  unsigned long long bits = 0;
+  unsigned long segments = (size + HUFF_SEGMENT_SIZE - 1) / HUFF_SEGMENT_SIZE;
+  int symbols = 0;
+  int distinct = 0;
+  int tables = 0;
+
+  flags &= HUFF_BLOCK_FLAG_CRC;
+  if (size > HUFF_SEGMENT_MAX_BLOCK || segments < 2)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+
+  memset(work->freq, 0, sizeof(work->freq));
+  if (calculateFrequencyInChunks(in, work->freq, (int)size, (int)size) != 0)
+    return -1;
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (work->freq[i] != 0)
+    {
+      symbols = i + 1;
+      distinct++;
+    }
+  }
+  if (distinct <= 1)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+
+  unsigned long tableSize = (unsigned long)(symbols + 1) / 2;
+  unsigned long order0Size =
+      huffmanOrder0Size(&work->tree, work->freq, &work->codes[0]);
+
+  // Cada passe escolhe as tabelas com os custos do anterior e as reconstrói
+  // só com os segmentos escolhidos: no último, tabelas e seletores batem
+  int candidates = segmentTables(size);
+  seedSegmentCosts(work, symbols, size, candidates);
+  for (int pass = 0; pass < SEGMENT_PASSES; ++pass)
+  {
+    assignSegments(work, in, size, candidates);
+    for (int t = 0; t < candidates; ++t)
+    {
+      buildCodeTable(&work->tree, work->segFreq[t], &work->codes[t]);
+      for (int c = 0; c < symbols; ++c)
+        work->segCost[t][c] = work->codes[t].len[c]
+                                  ? work->codes[t].len[c]
+                                  : (unsigned char)(HUFF_MAX_CODE_LEN + 1);
+    }
+  }
+
+  // Tabelas que nenhum segmento escolheu não vão para o bloco
+  for (int t = 0; t < candidates; ++t)
+  {
+    unsigned long long tableBits =
+        huffmanEncodedBits(work->segFreq[t], &work->codes[t]);
+    if (tableBits == 0)
+      continue;
+    index[t] = (unsigned char)tables;
+    work->codes[tables++] = work->codes[t];
+    bits += tableBits;
+  }
+  if (tables < 2)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+
+  for (int t = 0; t < tables; ++t)
+    order[t] = (unsigned char)t;
+  for (unsigned long s = 0; s < segments; ++s)
+  {
+    work->selectors[s] = index[work->selectors[s]];
+    bits += (unsigned long long)moveToFront(order, work->selectors[s]) + 1;
+  }
+
+  unsigned long headerSize = 2 + tableSize * (unsigned long)tables;
+  unsigned long bodySize = headerSize + (unsigned long)((bits + 7) / 8);
+  if (bodySize >= order0Size || bodySize >= size)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+  if (outSize < reserved || outSize - reserved < bodySize)
+    return -1;
+
+  body[0] = (unsigned char)symbols; // 256 vira 0
+  body[1] = (unsigned char)tables;
+  for (int t = 0; t < tables; ++t)
+    huffmanWriteNibbles(body + 2 + tableSize * (unsigned long)t,
+                        work->codes[t].len, symbols);
+
+  // Cada segmento começa pelo seletor: posição move-to-front em unário
+  struct HuffmanBitWriter writer = {body + headerSize, 0, 0};
+  for (int t = 0; t < tables; ++t)
+    order[t] = (unsigned char)t;
+  for (unsigned long s = 0; s < segments; ++s)
+  {
+    const struct HuffmanCodeTable *table = &work->codes[work->selectors[s]];
+    unsigned long start = s * HUFF_SEGMENT_SIZE;
+    unsigned long end =
+        size - start < HUFF_SEGMENT_SIZE ? size : start + HUFF_SEGMENT_SIZE;
+    int rank = moveToFront(order, work->selectors[s]);
+
+    huffmanPutBits(&writer, (1u << (rank + 1)) - 2, rank + 1);
+    for (unsigned long i = start; i < end; ++i)
+    {
+      unsigned char c = (unsigned char)in[i];
+      huffmanPutBits(&writer, table->bits[c], table->len[c]);
+    }
+  }
+  huffmanFlushBits(&writer);
+
+  flags |= (int)((8 - bits % 8) % 8);
+  return huffmanBlockFinish(out, HUFF_BLOCK_SEGMENTS, flags, size, bodySize);
+}
+
+/**
+ * Lê tabelas de comprimentos consecutivas e prepara codes e lookups.
+ *
+ * @param lengths Primeira tabela (ceil(symbols / 2) bytes cada).
+ * @param symbols Símbolos em cada tabela.
+ * @param tables Quantidade de tabelas.
+ * @return 0 em caso de sucesso, -1 se alguma tabela for inválida.
+ */
+static int readTables(struct HuffmanContextWork *work,
+                      const unsigned char *lengths, int symbols, int tables)
+{
+  for (int t = 0; t < tables; ++t)
+  {
+    if (huffmanReadLengths(lengths, symbols, &work->codes[t],
+                           &work->lookups[t]) != 0)
+      return -1;
+    lengths += (symbols + 1) / 2;
+  }
+  return 0;
+}
+
+/**
+ * Decodifica o corpo de um bloco HUFF_BLOCK_CONTEXT.
+ *
+ * @param body Início do corpo.
+ * @param info Campos do cabeçalho.
+ * @param out Buffer de saída, com ao menos info->rawSize bytes.
+ * @return 0 em caso de sucesso, -1 se o corpo for inválido.
+ */
+static int decodeContextBody(struct HuffmanContextWork *work,
+                             const unsigned char *body,
+                             const struct HuffmanBlockInfo *info, char *out)
+{
+  struct HuffmanBitReader reader = {0};
+  int prev = 0;
+
+  if (info->compressedSize < 2)
+    return -1;
+  int symbols = body[0] ? body[0] : 256;
+  int tables = body[1];
+  unsigned long mapSize = (unsigned long)(symbols + 1) / 2;
+  unsigned long headerSize = 2 + mapSize * (unsigned long)(tables + 1);
+  if (symbols > HUFF_ALPHABET_SIZE || tables == 0 ||
+      tables > HUFF_CONTEXT_TABLES || headerSize > info->compressedSize)
+    return -1;
+
+  for (int c = 0; c < symbols; ++c)
+  {
+    work->tableOf[c] = (body[2 + c / 2] >> (c % 2 ? 0 : 4)) & 0x0F;
+    if (work->tableOf[c] >= tables)
+      return -1;
+  }
+  if (readTables(work, body + 2 + mapSize, symbols, tables) != 0)
+    return -1;
+
+  reader.in = body + headerSize;
+  reader.size = info->compressedSize - headerSize;
+  for (unsigned long i = 0; i < info->rawSize; ++i)
+  {
+    prev = huffmanReadSymbol(&reader, &work->lookups[work->tableOf[prev]]);
+    if (prev < 0)
+      return -1;
+    out[i] = (char)prev;
+  }
+  return huffmanCheckPadding(&reader, info);
+}
+
+/**
+ * Decodifica o corpo de um bloco HUFF_BLOCK_SEGMENTS.
+ *
+ * @param body Início do corpo.
+ * @param info Campos do cabeçalho.
+ * @param out Buffer de saída, com ao menos info->rawSize bytes.
+ * @return 0 em caso de sucesso, -1 se o corpo for inválido.
+ */
+static int decodeSegmentsBody(struct HuffmanContextWork *work,
+                              const unsigned char *body,
+                              const struct HuffmanBlockInfo *info, char *out)
+{
+  struct HuffmanBitReader reader = {0};
+  unsigned char order[HUFF_SEGMENT_TABLES];
+
+  if (info->compressedSize < 2)
+    return -1;
+  int symbols = body[0] ? body[0] : 256;
+  int tables = body[1];
+  unsigned long headerSize =
+      2 + (unsigned long)((symbols + 1) / 2) * (unsigned long)tables;
+  if (symbols > HUFF_ALPHABET_SIZE || tables == 0 ||
+      tables > HUFF_SEGMENT_TABLES || headerSize > info->compressedSize ||
+      readTables(work, body + 2, symbols, tables) != 0)
+    return -1;
+
+  for (int t = 0; t < tables; ++t)
+    order[t] = (unsigned char)t;
+  reader.in = body + headerSize;
+  reader.size = info->compressedSize - headerSize;
+
+  for (unsigned long start = 0; start < info->rawSize;
+       start += HUFF_SEGMENT_SIZE)
+  {
+    unsigned long end = info->rawSize - start < HUFF_SEGMENT_SIZE
+                            ? info->rawSize
+                            : start + HUFF_SEGMENT_SIZE;
+    int rank = 0;
+    int bit;
+
+    // Seletor: posição na lista move-to-front, em unário
+    while ((bit = huffmanReadBit(&reader)) == 1)
+    {
+      if (++rank >= tables)
+        return -1;
+    }
+    if (bit < 0)
+      return -1;
+    unsigned char t = order[rank];
+    memmove(order + 1, order, (size_t)rank);
+    order[0] = t;
+
+    for (unsigned long i = start; i < end; ++i)
+    {
+      int c = huffmanReadSymbol(&reader, &work->lookups[t]);
+      if (c < 0)
+        return -1;
+      out[i] = (char)c;
+    }
+  }
+  return huffmanCheckPadding(&reader, info);
+}
+
+long huffmanContextDecode(struct HuffmanContextWork *work,
+                          const unsigned char *in, unsigned long size,
+                          char *out, unsigned long outSize)
+{
+  struct HuffmanBlockInfo info;
+  const unsigned char *body = in + HUFF_BLOCK_HEADER_SIZE;
+
+  if (huffmanBlockParse(in, size, &info) != 0)
+    return -1;
+  if (info.type != HUFF_BLOCK_CONTEXT && info.type != HUFF_BLOCK_SEGMENTS)
+    return huffmanBlockDecode(&work->decode, in, size, out, outSize);
+
+  if (huffmanBlockVerify(in, &info) != 0 || info.rawSize > outSize)
+    return -1;
+  if (info.type == HUFF_BLOCK_CONTEXT
+          ? decodeContextBody(work, body, &info, out)
+          : decodeSegmentsBody(work, body, &info, out))
+    return -1;
+  return (long)info.rawSize;
+}
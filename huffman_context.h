@@ -0,0 +1,149 @@
+/*
+ * Algoritmo de Codificação de Huffman - Blocos com várias tabelas
+ *
+ * Descrição:
+ * Uma única tabela por bloco perde quando a estatística muda dentro dele.
+ * Este módulo gera dois tipos de bloco com várias tabelas:
+ *
+ * - Contexto de ordem 1: cada símbolo é codificado com a tabela do símbolo
+ *   anterior (o contexto). Com um histograma por contexto o custo das
+ *   tabelas cresceria com o quadrado do alfabeto, então contextos com
+ *   estatísticas parecidas são agrupados e dividem uma tabela: no máximo
+ *   HUFF_CONTEXT_TABLES.
+ * - Tabelas por segmento (como no bzip2): a entrada é dividida em segmentos
+ *   de HUFF_SEGMENT_SIZE símbolos, e cada um escolhe a melhor de até
+ *   HUFF_SEGMENT_TABLES tabelas, refinadas em alguns passes.
+ *
+ * Corpo de um bloco HUFF_BLOCK_CONTEXT: 1 byte n com a quantidade de
+ * símbolos (0 significa 256), 1 byte T com a quantidade de tabelas,
+ * ceil(n / 2) bytes com a tabela usada por cada contexto (4 bits, contexto
+ * par no nibble alto), T tabelas de comprimentos de ceil(n / 2) bytes cada
+ * (como em HUFF_BLOCK_HUFFMAN, sem o byte n) e um único fluxo de bits. O
+ * primeiro símbolo usa o contexto 0.
+ *
+ * Corpo de um bloco HUFF_BLOCK_SEGMENTS: os bytes n e T, as T tabelas de
+ * comprimentos e um único fluxo de bits. Cada segmento começa pelo seletor
+ * da sua tabela, codificado com move-to-front (posição da tabela numa lista
+ * que começa em 0, 1, ..., T - 1) e em unário (posição p = p bits 1 e um
+ * bit 0), seguido dos seus símbolos.
+ *
+ * Os histogramas por contexto e os custos de fusão de cada par ocupam
+ * 12 * HUFF_ALPHABET_SIZE^2 bytes (768 KB no perfil HOST), numa
+ * HuffmanContextWork do chamador: este módulo é para o host, e a placa
+ * continua com os blocos de huffman_frame.h.
+ */
+#ifndef HUFFMAN_CONTEXT_H
+#define HUFFMAN_CONTEXT_H
+
+#include "huffman_coder.h"
+
+#define HUFF_BLOCK_CONTEXT 4  // Uma tabela por grupo de contextos de ordem 1
+
+#define HUFF_BLOCK_SEGMENTS 5 // Uma tabela escolhida a cada segmento
+
+// Máximo de tabelas por bloco (o mapa de contextos usa 4 bits)
+#define HUFF_CONTEXT_TABLES 16
+
+// Menor entrada modelada com contextos: o agrupamento custa o mesmo em
+// qualquer bloco, e abaixo disso o ganho não paga o tempo
+#define HUFF_CONTEXT_MIN_BLOCK 8192ul
+
+#define HUFF_SEGMENT_TABLES 6             // Máximo de tabelas por bloco SEGMENTS
+#define HUFF_SEGMENT_SIZE 50              // Símbolos por seletor
+#define HUFF_SEGMENT_MAX_BLOCK (1ul << 20) // Maior entrada dividida em segmentos
+#define HUFF_SEGMENT_MAX_COUNT \
+  ((HUFF_SEGMENT_MAX_BLOCK + HUFF_SEGMENT_SIZE - 1) / HUFF_SEGMENT_SIZE)
+
+#define HUFF_CONTEXT_XLOG 4096 // Contagens com x * log2(x) tabelado
+
+// Memória de trabalho de huffmanContextEncode, huffmanSegmentsEncode e
+// huffmanContextDecode. Grande demais para a pilha: aloque com calloc (ou
+// como estática do programa), zerada, e use uma por thread.
+struct HuffmanContextWork
+{
+  // Histograma de cada contexto; depois do agrupamento, de cada grupo (na
+  // linha do seu representante)
+  unsigned ctxFreq[HUFF_ALPHABET_SIZE][HUFF_ALPHABET_SIZE];
+  unsigned long ctxCount[HUFF_ALPHABET_SIZE];    // Símbolos da linha
+  unsigned long long ctxSum[HUFF_ALPHABET_SIZE]; // Soma de f * log2(f) da linha
+  unsigned char ctxGroup[HUFF_ALPHABET_SIZE];    // Representante do grupo
+  unsigned char ctxSymbols[HUFF_ALPHABET_SIZE][HUFF_ALPHABET_SIZE]; // Símbolos presentes
+  unsigned short ctxDistinct[HUFF_ALPHABET_SIZE]; // Quantos em ctxSymbols
+  long long pairDelta[HUFF_ALPHABET_SIZE][HUFF_ALPHABET_SIZE]; // Custo da fusão
+  short partner[HUFF_ALPHABET_SIZE];               // Grupo mais barato para fundir
+  unsigned xlogTable[HUFF_CONTEXT_XLOG];           // Preenchida no primeiro uso
+  unsigned freq[HUFF_ALPHABET_SIZE];
+  unsigned char tableOf[HUFF_ALPHABET_SIZE]; // Tabela de cada contexto
+  unsigned segFreq[HUFF_SEGMENT_TABLES][HUFF_ALPHABET_SIZE];
+  unsigned char segCost[HUFF_SEGMENT_TABLES][HUFF_ALPHABET_SIZE]; // Bits por símbolo
+  unsigned char selectors[HUFF_SEGMENT_MAX_COUNT]; // Tabela de cada segmento
+  struct HuffmanCodeTable codes[HUFF_CONTEXT_TABLES];
+  struct HuffmanLookupTable lookups[HUFF_CONTEXT_TABLES];
+  struct HuffmanTreeWork tree;
+  // Blocos de huffman_frame.c, quando o modelo não compensa
+  struct HuffmanBlockEncodeWork block;
+  struct HuffmanBlockDecodeWork decode;
+};
+
+/**
+ * Comprime a entrada em um bloco HUFF_BLOCK_CONTEXT. Se a entrada for menor
+ * que HUFF_CONTEXT_MIN_BLOCK ou o modelo de ordem 1 não ficar menor que o
+ * de ordem 0, gera o bloco de huffmanBlockEncode.
+ *
+ * O agrupamento compara todos os pares de contextos, então o seu custo
+ * depende dos símbolos em uso, não do tamanho do bloco: cerca de 0,5 ms por
+ * bloco em texto e alguns ms em dados binários (alfabeto inteiro). Com
+ * blocos de 8 KB a codificação fica em ~6 MB/s em texto (contra ~150 MB/s
+ * do bloco HUFFMAN) e ~2 MB/s em binário; com blocos de 64 KB, em ~25 e
+ * ~4 MB/s.
+ *
+ * @param work Memória de trabalho.
+ * @param in Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @param out Buffer de saída, com ao menos huffmanBlockBound(size) bytes
+ *            para nunca falhar.
+ * @param outSize Capacidade do buffer de saída.
+ * @param flags HUFF_BLOCK_FLAG_CRC para acrescentar o CRC32C, ou 0.
+ * @return Tamanho do bloco, ou -1 se não couber em out.
+ */
+long huffmanContextEncode(struct HuffmanContextWork *work, const char *in,
+                          unsigned long size, unsigned char *out,
+                          unsigned long outSize, int flags);
+
+/**
+ * Comprime a entrada em um bloco HUFF_BLOCK_SEGMENTS. Se a entrada passar
+ * de HUFF_SEGMENT_MAX_BLOCK, tiver um só segmento ou as tabelas por
+ * segmento não ficarem menores que uma tabela só, gera o bloco de
+ * huffmanBlockEncode.
+ *
+ * @param work Memória de trabalho.
+ * @param in Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @param out Buffer de saída, com ao menos huffmanBlockBound(size) bytes
+ *            para nunca falhar.
+ * @param outSize Capacidade do buffer de saída.
+ * @param flags HUFF_BLOCK_FLAG_CRC para acrescentar o CRC32C, ou 0.
+ * @return Tamanho do bloco, ou -1 se não couber em out.
+ */
+long huffmanSegmentsEncode(struct HuffmanContextWork *work, const char *in,
+                           unsigned long size, unsigned char *out,
+                           unsigned long outSize, int flags);
+
+/**
+ * Decodifica um bloco HUFF_BLOCK_CONTEXT ou HUFF_BLOCK_SEGMENTS, conferindo
+ * o CRC32C se presente. Os tipos de huffman_frame.c, que huffmanContextEncode
+ * e huffmanSegmentsEncode geram quando o modelo não compensa, são repassados
+ * a huffmanBlockDecode; os demais são recusados (ver huffmanDecodeAnyBlock).
+ *
+ * @param work Memória de trabalho.
+ * @param in Início do bloco.
+ * @param size Bytes disponíveis a partir de in.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @return Tamanho original, ou -1 se o bloco for inválido ou não couber em out.
+ */
+long huffmanContextDecode(struct HuffmanContextWork *work,
+                          const unsigned char *in, unsigned long size,
+                          char *out, unsigned long outSize);
+
+#endif
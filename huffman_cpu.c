@@ -0,0 +1,251 @@
+/*
+ * Algoritmo de Codificação de Huffman - Seleção de kernels por CPU
+ *
+ * Descrição:
+ * Consulta de recursos (CPUID/XGETBV) e tabelas de implementações de cada
+ * etapa, da mais rápida para a portável. A primeira cujos recursos exigidos
+ * estejam disponíveis é a escolhida.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "huffman_cpu.h"
+
+#ifdef HUFF_X86
+#include <cpuid.h>
+#include <stdatomic.h>
+#endif
+
+// Uma implementação de uma etapa e os recursos que ela exige
+struct EncodeImpl
+{
+  const char *name;
+  unsigned required;
+  HuffmanEncodeKernel run;
+};
+
+struct DecodeImpl
+{
+  const char *name;
+  unsigned required;
+  HuffmanDecodeKernel run;
+};
+
+struct DecodeStreamsImpl
+{
+  const char *name;
+  unsigned required;
+  HuffmanDecodeStreamsKernel run;
+};
+
+static long long decodePortable(struct HuffmanKernelWork *work,
+                                const struct HuffmanCodeTable *codes,
+                                const struct HuffmanDecodeTable *tree,
+                                const unsigned char *in, unsigned long inSize,
+                                char *out, unsigned long count)
+{
+  (void)work;
+  (void)codes;
+  return huffmanDecodeBuffer(tree, in, inSize, out, count);
+}
+
+static int decodeStreamsPortable(struct HuffmanKernelWork *work,
+                                 const struct HuffmanCodeTable *codes,
+                                 const struct HuffmanDecodeTable *tree,
+                                 const unsigned char *const streams[HUFF_STREAMS],
+                                 const unsigned long sizes[HUFF_STREAMS],
+                                 char *out, unsigned long count,
+                                 unsigned long long consumed[HUFF_STREAMS])
+{
+  (void)work;
+  (void)codes;
+  return huffmanDecodeStreamsBuffer(tree, streams, sizes, HUFF_STREAMS, out,
+                                    count, consumed);
+}
+
+// Da mais rápida para a portável, que não exige nada e fecha cada lista
+static const struct EncodeImpl encodeImpls[] = {
+#ifdef HUFF_X86_64
+    {"bmi2", HUFF_CPU_BMI2, huffmanEncodeBmi2},
+    {"x86-64", HUFF_CPU_X86_64, huffmanEncode64},
+#endif
+    {"portable", 0, huffmanEncodeBuffer}};
+
+static const struct DecodeImpl decodeImpls[] = {
+#ifdef HUFF_X86_64
+    {"bmi2", HUFF_CPU_BMI2, huffmanDecodeMultiBmi2},
+    {"x86-64", HUFF_CPU_X86_64, huffmanDecodeMulti64},
+#endif
+    {"portable", 0, decodePortable}};
+
+static const struct DecodeStreamsImpl decodeStreamsImpls[] = {
+#ifdef HUFF_X86_64
+    {"avx2", HUFF_CPU_AVX2 | HUFF_CPU_X86_64, huffmanDecodeStreamsAvx2},
+    {"x86-64", HUFF_CPU_X86_64, huffmanDecodeStreams64},
+#endif
+    {"portable", 0, decodeStreamsPortable}};
+
+#define HUFF_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+#ifdef HUFF_X86
+// Registradores que o sistema operacional salva na troca de contexto
+static unsigned long long readXcr0(void)
+{
+  unsigned lo, hi;
+  __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return ((unsigned long long)hi << 32) | lo;
+}
+
+static unsigned probeCpu(void)
+{
+  unsigned a, b, c, d;
+  unsigned features = 0;
+  unsigned long long xcr0 = 0;
+
+#ifdef HUFF_X86_64
+  features |= HUFF_CPU_X86_64;
+#endif
+  if (!__get_cpuid(1, &a, &b, &c, &d))
+    return features;
+  if ((c & bit_OSXSAVE) && (c & bit_AVX))
+    xcr0 = readXcr0();
+
+  if (__get_cpuid_max(0, 0) >= 7)
+  {
+    __cpuid_count(7, 0, a, b, c, d);
+    if ((b & bit_AVX2) && (xcr0 & 0x06) == 0x06)
+      features |= HUFF_CPU_AVX2;
+    if (b & bit_BMI2)
+      features |= HUFF_CPU_BMI2;
+  }
+  return features;
+}
+
+// Converte HUFF_CPU (lista separada por vírgulas) em uma máscara
+static unsigned parseOverride(const char *value)
+{
+  static const struct
+  {
+    const char *name;
+    unsigned feature;
+  } names[] = {{"x86-64", HUFF_CPU_X86_64},
+               {"avx2", HUFF_CPU_AVX2},
+               {"bmi2", HUFF_CPU_BMI2}};
+  unsigned mask = 0;
+
+  while (*value)
+  {
+    size_t len = strcspn(value, ",");
+    for (size_t i = 0; i < HUFF_COUNT(names); ++i)
+    {
+      if (strlen(names[i].name) == len && strncmp(value, names[i].name, len) == 0)
+        mask |= names[i].feature;
+    }
+    value += len;
+    if (*value == ',')
+      value++;
+  }
+  return mask; // "portable" (ou qualquer nome desconhecido) não liga nada
+}
+#endif
+
+#ifdef HUFF_X86
+// Tabelas publicadas: a da consulta à CPU é escrita uma vez só, pela thread
+// que ganha probeState; a de huffmanSetCpuFeatures, só com as demais paradas.
+// Os kernels escolhidos guardam as suas tabelas na HuffmanKernelWork de quem
+// os chama
+static unsigned detected = 0; // Recursos da CPU, já limitados por HUFF_CPU
+static struct HuffmanKernels probedKernels;
+static struct HuffmanKernels maskedKernels;
+static atomic_int probeState = 0; // 1 depois que uma thread assume a consulta
+static _Atomic(const struct HuffmanKernels *) activeKernels = NULL;
+
+/**
+ * Consulta a CPU na primeira chamada e devolve a tabela em uso. As demais
+ * threads que chegam durante a consulta esperam a publicação, que é feita
+ * com release depois de a tabela estar completa.
+ */
+static const struct HuffmanKernels *currentKernels(void)
+{
+  const struct HuffmanKernels *active =
+      atomic_load_explicit(&activeKernels, memory_order_acquire);
+  int expected = 0;
+
+  if (active != NULL)
+    return active;
+  if (atomic_compare_exchange_strong(&probeState, &expected, 1))
+  {
+    struct HuffmanKernels local;
+    const char *override = getenv("HUFF_CPU");
+    unsigned mask = probeCpu();
+
+    if (override != NULL)
+      mask &= parseOverride(override);
+    huffmanSelectKernels(mask, &local);
+    detected = mask;
+    probedKernels = local;
+    atomic_store_explicit(&activeKernels, &probedKernels, memory_order_release);
+    return &probedKernels;
+  }
+  while ((active = atomic_load_explicit(&activeKernels,
+                                        memory_order_acquire)) == NULL)
+    ;
+  return active;
+}
+
+void huffmanSetCpuFeatures(unsigned mask)
+{
+  struct HuffmanKernels local;
+
+  currentKernels();
+  huffmanSelectKernels(detected & mask, &local);
+  maskedKernels = local;
+  atomic_store_explicit(&activeKernels, &maskedKernels, memory_order_release);
+}
+#else
+// Sem CPUID só há os kernels portáveis: a tabela é constante
+static const struct HuffmanKernels portableKernels = {
+    0, huffmanEncodeBuffer, decodePortable, decodeStreamsPortable,
+    "portable", "portable", "portable"};
+
+static const struct HuffmanKernels *currentKernels(void)
+{
+  return &portableKernels;
+}
+
+void huffmanSetCpuFeatures(unsigned mask)
+{
+  (void)mask;
+}
+#endif
+
+unsigned huffmanCpuFeatures(void)
+{
+  return currentKernels()->features;
+}
+
+void huffmanSelectKernels(unsigned features, struct HuffmanKernels *kernels)
+{
+  size_t i;
+
+  kernels->features = features;
+
+  for (i = 0; (encodeImpls[i].required & ~features) != 0; ++i)
+    ;
+  kernels->encode = encodeImpls[i].run;
+  kernels->encodeName = encodeImpls[i].name;
+
+  for (i = 0; (decodeImpls[i].required & ~features) != 0; ++i)
+    ;
+  kernels->decode = decodeImpls[i].run;
+  kernels->decodeName = decodeImpls[i].name;
+
+  for (i = 0; (decodeStreamsImpls[i].required & ~features) != 0; ++i)
+    ;
+  kernels->decodeStreams = decodeStreamsImpls[i].run;
+  kernels->decodeStreamsName = decodeStreamsImpls[i].name;
+}
+
+const struct HuffmanKernels *huffmanKernels(void)
+{
+  return currentKernels();
+}
@@ -0,0 +1,217 @@
+/*
+ * Algoritmo de Codificação de Huffman - Seleção de kernels por CPU
+ *
+ * Descrição:
+ * Um mesmo executável roda em máquinas com conjuntos de instruções
+ * diferentes. Na primeira chamada de huffmanKernels, a CPU é consultada
+ * (CPUID) e, para cada etapa (empacotamento de bits e decodificação), é
+ * escolhida a melhor implementação suportada.
+ *
+ * A variável de ambiente HUFF_CPU limita os recursos usados, para comparar
+ * cada caminho em benchmarks: HUFF_CPU=portable usa só o código em C puro,
+ * HUFF_CPU=x86-64,bmi2 permite apenas esses recursos, e assim por diante
+ * (x86-64, bmi2, avx2). Recursos ausentes na CPU nunca são ligados.
+ *
+ * Os kernels de decodificação montam as tabelas de consulta numa
+ * HuffmanKernelWork do chamador e só as refazem quando os comprimentos do
+ * bloco mudam: threads diferentes podem decodificar ao mesmo tempo, cada
+ * uma com a sua.
+ *
+ * Fora de x86 (ex: STM32F030) não há consulta nem variável de ambiente:
+ * sempre são usados os kernels portáveis.
+ */
+#ifndef HUFFMAN_CPU_H
+#define HUFFMAN_CPU_H
+
+#include "huffman.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HUFF_X86 1
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HUFF_X86_64 1
+#endif
+
+// Recursos de CPU para os quais há kernels
+#define HUFF_CPU_AVX2 0x02   // AVX2 (com suporte do sistema aos registradores YMM)
+#define HUFF_CPU_BMI2 0x04   // BMI2 (shlx, shrx, bzhi)
+#define HUFF_CPU_X86_64 0x10 // Registradores de 64 bits e RAM para tabelas grandes
+
+// Fluxos intercalados: o símbolo i vai para o fluxo i % HUFF_STREAMS
+#define HUFF_STREAMS 8
+
+#ifdef HUFF_X86_64
+// Largura máxima da tabela de vários símbolos por consulta
+#define HUFF_MULTI_MAX_BITS 12
+
+// Tabelas de consulta dos kernels de huffman_bitio.c. Deve começar zerada
+// (estática, calloc ou memset): lookupBits == 0 indica que ainda não há
+// tabela e forcedBits == 0, a largura automática.
+struct HuffmanKernelWork
+{
+  // Entradas: símbolo no byte baixo, comprimento total no alto (0 = inválido).
+  // A entrada extra mantém dentro do array o gather de 4 bytes da última.
+  unsigned primary[1 << HUFF_MAX_CODE_LEN];
+  unsigned short secondary[(1 << HUFF_MAX_CODE_LEN) + 1];
+  unsigned char prefixBits[1 << HUFF_MAX_CODE_LEN]; // Largura por prefixo
+  unsigned char lookupLen[HUFF_ALPHABET_SIZE];      // Comprimentos da tabela atual
+  unsigned lookupBits;  // Maior código da tabela atual (0 = vazia)
+  unsigned primaryBits; // Largura da tabela primária atual
+  unsigned forcedBits;  // Largura pedida (0 = automática)
+
+  // Tabela de vários símbolos: até 3 símbolos nos bytes 0-2, bits
+  // consumidos nos bits 24-27 e quantidade de símbolos nos bits 28-29
+  unsigned multi[1 << HUFF_MULTI_MAX_BITS];
+  unsigned multiBits; // Largura da tabela atual (0 = não compensa)
+  int multiReady;     // multi corresponde à tabela de um símbolo
+};
+#else
+// Os kernels portáveis não guardam tabelas entre chamadas
+struct HuffmanKernelWork
+{
+  char unused;
+};
+#endif
+
+/**
+ * Codifica um buffer inteiro; mesmo contrato de huffmanEncodeBuffer.
+ *
+ * @return Bits escritos.
+ */
+typedef unsigned long long (*HuffmanEncodeKernel)(
+    const struct HuffmanCodeTable *table, const char in[], unsigned long size,
+    unsigned char out[]);
+
+/**
+ * Decodifica exatamente count símbolos a partir do primeiro bit de in.
+ * Recebe os códigos e a árvore já construída; cada kernel usa o que
+ * precisar, e guarda em work as tabelas que montar a partir deles.
+ *
+ * @return Bits consumidos, ou -1 se a entrada acabar ou tiver código inválido.
+ */
+typedef long long (*HuffmanDecodeKernel)(struct HuffmanKernelWork *work,
+                                         const struct HuffmanCodeTable *codes,
+                                         const struct HuffmanDecodeTable *tree,
+                                         const unsigned char *in,
+                                         unsigned long inSize, char *out,
+                                         unsigned long count);
+
+/**
+ * Decodifica count símbolos intercalados em HUFF_STREAMS fluxos
+ * independentes: o símbolo i sai do fluxo i % HUFF_STREAMS e vai para
+ * out[i]. Como os fluxos não dependem um do outro, podem ser decodificados
+ * em paralelo (ex: uma pista SIMD por fluxo).
+ *
+ * @param streams Início de cada fluxo.
+ * @param sizes Tamanho de cada fluxo.
+ * @param consumed Recebe os bits consumidos de cada fluxo.
+ * @return 0 em caso de sucesso, -1 se algum fluxo acabar ou for inválido.
+ */
+typedef int (*HuffmanDecodeStreamsKernel)(
+    struct HuffmanKernelWork *work, const struct HuffmanCodeTable *codes,
+    const struct HuffmanDecodeTable *tree,
+    const unsigned char *const streams[HUFF_STREAMS],
+    const unsigned long sizes[HUFF_STREAMS], char *out, unsigned long count,
+    unsigned long long consumed[HUFF_STREAMS]);
+
+// Implementações escolhidas para um conjunto de recursos
+struct HuffmanKernels
+{
+  unsigned features;            // HUFF_CPU_* usados na escolha
+  HuffmanEncodeKernel encode;
+  HuffmanDecodeKernel decode;
+  HuffmanDecodeStreamsKernel decodeStreams;
+  const char *encodeName;       // Nomes, para relatórios de benchmark
+  const char *decodeName;
+  const char *decodeStreamsName;
+};
+
+#ifdef HUFF_X86_64
+// Kernels de huffman_bitio.c: contêiner de 64 bits e decodificação por tabela
+unsigned long long huffmanEncode64(const struct HuffmanCodeTable *table,
+                                   const char in[], unsigned long size,
+                                   unsigned char out[]);
+unsigned long long huffmanEncodeBmi2(const struct HuffmanCodeTable *table,
+                                     const char in[], unsigned long size,
+                                     unsigned char out[]);
+long long huffmanDecode64(struct HuffmanKernelWork *work,
+                          const struct HuffmanCodeTable *codes,
+                          const struct HuffmanDecodeTable *tree,
+                          const unsigned char *in, unsigned long inSize,
+                          char *out, unsigned long count);
+long long huffmanDecodeBmi2(struct HuffmanKernelWork *work,
+                            const struct HuffmanCodeTable *codes,
+                            const struct HuffmanDecodeTable *tree,
+                            const unsigned char *in, unsigned long inSize,
+                            char *out, unsigned long count);
+/**
+ * Fixa a largura da tabela primária dos kernels x86-64, para medir o efeito
+ * do cache. Larguras a partir do maior código do bloco equivalem a uma
+ * tabela de um nível só.
+ *
+ * @param work Tabelas afetadas; são refeitas na próxima decodificação.
+ * @param bits Largura em bits, ou 0 para a escolha automática.
+ */
+void huffmanSetLookupBits(struct HuffmanKernelWork *work, unsigned bits);
+long long huffmanDecodeMulti64(struct HuffmanKernelWork *work,
+                               const struct HuffmanCodeTable *codes,
+                               const struct HuffmanDecodeTable *tree,
+                               const unsigned char *in, unsigned long inSize,
+                               char *out, unsigned long count);
+long long huffmanDecodeMultiBmi2(struct HuffmanKernelWork *work,
+                                 const struct HuffmanCodeTable *codes,
+                                 const struct HuffmanDecodeTable *tree,
+                                 const unsigned char *in, unsigned long inSize,
+                                 char *out, unsigned long count);
+int huffmanDecodeStreams64(struct HuffmanKernelWork *work,
+                           const struct HuffmanCodeTable *codes,
+                           const struct HuffmanDecodeTable *tree,
+                           const unsigned char *const streams[HUFF_STREAMS],
+                           const unsigned long sizes[HUFF_STREAMS], char *out,
+                           unsigned long count,
+                           unsigned long long consumed[HUFF_STREAMS]);
+int huffmanDecodeStreamsAvx2(struct HuffmanKernelWork *work,
+                             const struct HuffmanCodeTable *codes,
+                             const struct HuffmanDecodeTable *tree,
+                             const unsigned char *const streams[HUFF_STREAMS],
+                             const unsigned long sizes[HUFF_STREAMS], char *out,
+                             unsigned long count,
+                             unsigned long long consumed[HUFF_STREAMS]);
+#endif
+
+/**
+ * Recursos da CPU atual, já limitados por HUFF_CPU. Consultados uma vez só,
+ * na primeira chamada.
+ *
+ * @return Combinação de HUFF_CPU_*.
+ */
+unsigned huffmanCpuFeatures(void);
+
+/**
+ * Restringe os recursos usados daqui em diante (como HUFF_CPU, mas em
+ * tempo de execução) e escolhe os kernels de novo. Serve para um benchmark
+ * medir cada caminho no mesmo processo; não deve ser chamada enquanto outra
+ * thread codifica ou decodifica, pois a tabela anterior pode ser reescrita.
+ *
+ * @param mask Recursos permitidos (HUFF_CPU_*); os ausentes na CPU são ignorados.
+ */
+void huffmanSetCpuFeatures(unsigned mask);
+
+/**
+ * Escolhe a melhor implementação de cada etapa para os recursos dados, sem
+ * consultar a CPU (ex: para um benchmark percorrer todos os caminhos).
+ *
+ * @param features Combinação de HUFF_CPU_*.
+ * @param kernels Implementações escolhidas.
+ */
+void huffmanSelectKernels(unsigned features, struct HuffmanKernels *kernels);
+
+/**
+ * Implementações para a CPU atual (huffmanCpuFeatures), escolhidas na
+ * primeira chamada.
+ *
+ * @return Kernels escolhidos.
+ */
+const struct HuffmanKernels *huffmanKernels(void);
+
+#endif
@@ -0,0 +1,341 @@
+/*
+ * Algoritmo de Codificação de Huffman - Decodificador em fluxo
+ *
+ * Descrição:
+ * Decodifica a saída de huffman_encode.c recebida em fragmentos de tamanho
+ * arbitrário (ex: pacotes de rede). O cabeçalho do fluxo informa quantos
+ * símbolos decodificar e quantos bits de preenchimento esperar no fim. A árvore de decodificação é reconstruída
+ * só com os comprimentos dos códigos canônicos e pode ser compartilhada; cada
+ * fluxo guarda apenas o nó atual e o byte parcialmente lido, sem nunca
+ * acumular a mensagem comprimida inteira.
+ *
+ * Também ficam aqui a atribuição dos códigos canônicos, comum ao
+ * codificador, e os decodificadores portáveis de buffer inteiro (um fluxo
+ * ou vários intercalados), para que a decodificação na placa não dependa de
+ * huffman.c nem de huffman_cpu.c.
+ */
+#include <string.h>
+#include "huffman.h"
+
+int assignCanonicalCodes(struct HuffmanCodeTable *table)
+{
+  unsigned short count[HUFF_MAX_CODE_LEN + 1] = {0};
+  unsigned short nextCode[HUFF_MAX_CODE_LEN + 1];
+  long left = 1;
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (table->len[i] > HUFF_MAX_CODE_LEN)
+      return -1;
+    count[table->len[i]]++;
+  }
+  count[0] = 0;
+
+  // Desigualdade de Kraft: os comprimentos precisam caber numa árvore binária
+  for (int len = 1; len <= HUFF_MAX_CODE_LEN; ++len)
+  {
+    left = (left << 1) - count[len];
+    if (left < 0)
+      return -1;
+  }
+
+  // Códigos de mesmo comprimento são consecutivos, em ordem de símbolo
+  unsigned short code = 0;
+  for (int len = 1; len <= HUFF_MAX_CODE_LEN; ++len)
+  {
+    code = (unsigned short)((code + count[len - 1]) << 1);
+    nextCode[len] = code;
+  }
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (table->len[i] != 0)
+      table->bits[i] = nextCode[table->len[i]]++;
+  }
+  return 0;
+}
+
+int buildDecodeTable(const struct HuffmanCodeTable *codes,
+                     struct HuffmanDecodeTable *table)
+{
+  int nodeCount = 1; // A raiz já existe
+
+  memset(table->child, 0xFF, sizeof(table->child)); // Tudo HUFF_NO_NODE
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    int len = codes->len[i];
+    unsigned short node = 0;
+
+    if (len == 0)
+      continue;
+
+    // Desce pelos bits do código criando os nós internos que faltarem
+    for (int j = len - 1; j > 0; --j)
+    {
+      unsigned short *next = &table->child[node][(codes->bits[i] >> j) & 1];
+      if (*next == HUFF_NO_NODE)
+      {
+        if (nodeCount == HUFF_ALPHABET_SIZE)
+          return -1;
+        *next = (unsigned short)nodeCount++;
+      }
+      else if (*next & HUFF_LEAF)
+      {
+        return -1; // Um código mais curto é prefixo deste
+      }
+      node = *next;
+    }
+
+    unsigned short *leaf = &table->child[node][codes->bits[i] & 1];
+    if (*leaf != HUFF_NO_NODE)
+      return -1;
+    *leaf = (unsigned short)(HUFF_LEAF | i);
+  }
+
+  return 0;
+}
+
+void huffmanDecoderInit(struct HuffmanDecoder *decoder,
+                        const struct HuffmanDecodeTable *table)
+{
+  huffmanDecoderInitRaw(decoder, table, 0, 0);
+  decoder->headerPos = 0;
+}
+
+void huffmanDecoderInitRaw(struct HuffmanDecoder *decoder,
+                           const struct HuffmanDecodeTable *table,
+                           unsigned long rawSize, int padding)
+{
+  decoder->table = table;
+  decoder->remaining = rawSize;
+  decoder->node = 0;
+  decoder->bits = 0;
+  decoder->bitCount = 0;
+  decoder->headerPos = HUFF_FRAME_HEADER_SIZE;
+  decoder->padding = (unsigned char)padding;
+}
+
+long long huffmanDecodeBuffer(const struct HuffmanDecodeTable *table,
+                              const unsigned char *in, unsigned long inSize,
+                              char *out, unsigned long count)
+{
+  unsigned long long total = 8ull * inSize;
+  unsigned long long pos = 0;
+
+  for (unsigned long i = 0; i < count; ++i)
+  {
+    unsigned short node = 0;
+    unsigned short next;
+
+    for (;;)
+    {
+      if (pos == total)
+        return -1;
+      next = table->child[node][(in[pos >> 3] >> (7 - (pos & 7))) & 1];
+      pos++;
+      if (next == HUFF_NO_NODE)
+        return -1;
+      if (next & HUFF_LEAF)
+        break;
+      node = next;
+    }
+    out[i] = (char)(next & 0xFF);
+  }
+  return (long long)pos;
+}
+
+int huffmanDecodeStreamsBuffer(const struct HuffmanDecodeTable *table,
+                               const unsigned char *const streams[],
+                               const unsigned long sizes[], int streamCount,
+                               char *out, unsigned long count,
+                               unsigned long long consumed[])
+{
+  // Um fluxo de cada vez: a árvore percorre os símbolos s, s + streamCount...
+  for (int s = 0; s < streamCount; ++s)
+  {
+    unsigned long long total = 8ull * sizes[s];
+    unsigned long long pos = 0;
+
+    for (unsigned long i = (unsigned long)s; i < count;
+         i += (unsigned long)streamCount)
+    {
+      unsigned short node = 0;
+      unsigned short next;
+
+      do
+      {
+        if (pos == total)
+          return -1;
+        int bit = (streams[s][pos >> 3] >> (7 - (pos & 7))) & 1;
+        next = table->child[node][bit];
+        pos++;
+        if (next == HUFF_NO_NODE)
+          return -1;
+        node = next;
+      } while (!(next & HUFF_LEAF));
+
+      out[i] = (char)(next & 0xFF);
+    }
+    consumed[s] = pos;
+  }
+  return 0;
+}
+
+int buildCanonicalTable(const unsigned char len[],
+                        struct HuffmanCanonicalTable *table)
+{
+  unsigned short code = 0;
+  unsigned short next = 0;
+  long left = 1;
+
+  memset(table->count, 0, sizeof(table->count));
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (len[i] > HUFF_MAX_CODE_LEN)
+      return -1;
+    table->count[len[i]]++;
+  }
+  table->count[0] = 0;
+
+  // Mesmas regras de assignCanonicalCodes: Kraft e códigos consecutivos
+  for (int l = 1; l <= HUFF_MAX_CODE_LEN; ++l)
+  {
+    left = (left << 1) - table->count[l];
+    if (left < 0)
+      return -1;
+
+    code = (unsigned short)((code + table->count[l - 1]) << 1);
+    table->first[l] = code;
+    table->offset[l] = next;
+
+    // Símbolos de comprimento l, em ordem crescente
+    for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    {
+      if (len[i] == l)
+        table->symbols[next++] = (unsigned char)i;
+    }
+  }
+  return 0;
+}
+
+long long huffmanDecodeCanonical(const struct HuffmanCanonicalTable *table,
+                                 const unsigned char *in, unsigned long inSize,
+                                 char *out, unsigned long count)
+{
+  unsigned long long total = 8ull * inSize;
+  unsigned long long pos = 0;
+
+  for (unsigned long i = 0; i < count; ++i)
+  {
+    unsigned code = 0;
+    int len = 0;
+
+    // Um código de len bits está em [first, first + count); acima disso é
+    // prefixo de um código mais longo
+    do
+    {
+      if (pos == total || len == HUFF_MAX_CODE_LEN)
+        return -1;
+      code = (code << 1) | ((in[pos >> 3] >> (7 - (pos & 7))) & 1);
+      pos++;
+      len++;
+    } while (code - table->first[len] >= table->count[len]);
+
+    out[i] = (char)table->symbols[table->offset[len] + code - table->first[len]];
+  }
+  return (long long)pos;
+}
+
+void huffmanDecoderStartAt(struct HuffmanDecoder *decoder, unsigned char first,
+                           int skip)
+{
+  decoder->bits = (unsigned char)(first << skip);
+  decoder->bitCount = (unsigned char)(8 - skip);
+}
+
+int huffmanDecodeUpdate(struct HuffmanDecoder *decoder, const unsigned char *in,
+                        int inSize, int *consumed, char *out, int outSize,
+                        int *produced)
+{
+  const struct HuffmanDecodeTable *table = decoder->table;
+  unsigned short node = decoder->node;
+  unsigned bits = decoder->bits;
+  int bitCount = decoder->bitCount;
+  int inPos = 0;
+  int outPos = 0;
+  int status;
+
+  // O cabeçalho também pode chegar dividido entre fragmentos
+  while (decoder->headerPos < HUFF_FRAME_HEADER_SIZE && inPos < inSize)
+  {
+    if (decoder->headerPos < 4)
+      decoder->remaining |= (unsigned long)in[inPos] << (8 * decoder->headerPos);
+    else
+      decoder->padding = in[inPos];
+    decoder->headerPos++;
+    inPos++;
+  }
+
+  for (;;)
+  {
+    if (decoder->headerPos < HUFF_FRAME_HEADER_SIZE)
+    {
+      status = HUFF_DECODE_NEED_INPUT;
+      break;
+    }
+
+    if (decoder->remaining == 0)
+    {
+      // Só podem sobrar os bits de preenchimento anunciados no cabeçalho
+      status = bitCount == decoder->padding ? HUFF_DECODE_DONE
+                                            : HUFF_DECODE_ERROR;
+      break;
+    }
+
+    if (bitCount == 0)
+    {
+      if (inPos == inSize)
+      {
+        status = HUFF_DECODE_NEED_INPUT;
+        break;
+      }
+      bits = in[inPos++];
+      bitCount = 8;
+    }
+
+    if (outPos == outSize)
+    {
+      status = HUFF_DECODE_OUTPUT_FULL;
+      break;
+    }
+
+    // Consome um bit (o mais significativo primeiro) e desce um nível
+    unsigned short next = table->child[node][(bits >> 7) & 1];
+    bits = (bits << 1) & 0xFF;
+    bitCount--;
+
+    if (next == HUFF_NO_NODE)
+    {
+      status = HUFF_DECODE_ERROR;
+      break;
+    }
+
+    if (!(next & HUFF_LEAF))
+    {
+      node = next;
+      continue;
+    }
+
+    node = 0;
+    out[outPos++] = (char)(next & 0xFF);
+    decoder->remaining--;
+  }
+
+  decoder->node = node;
+  decoder->bits = (unsigned char)bits;
+  decoder->bitCount = (unsigned char)bitCount;
+  *consumed = inPos;
+  *produced = outPos;
+  return status;
+}
@@ -0,0 +1,571 @@
+/*
+ * Algoritmo de Codificação de Huffman - Saída compatível com DEFLATE
+ *
+ * Descrição:
+ * Monta, para cada bloco, os códigos de literais/comprimentos e de
+ * distâncias limitados a 15 bits, o código de comprimentos (limitado a 7
+ * bits) que os descreve, e grava o bloco dinâmico da RFC 1951, ou um bloco
+ * "stored" se ele ficar menor. Ver huffman_deflate.h.
+ */
+#include <string.h>
+#include "huffman_deflate.h"
+
+#define CODELEN_MAX_LEN 7
+#define END_OF_BLOCK 256
+#define STORED_MAX 65535ul // Maior bloco "stored"
+
+// Ordem em que os comprimentos do código de comprimentos são gravados
+static const unsigned char codeLengthOrder[HUFF_DEFLATE_CODELEN_CODES] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// CRC-32 (polinômio refletido 0xEDB88320) processado 4 bits por vez
+static const unsigned long crcTable[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+    0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+unsigned long huffmanCrc32(unsigned long crc, const unsigned char *data,
+                           unsigned long size)
+{
+  crc = ~crc & 0xFFFFFFFF;
+  for (unsigned long i = 0; i < size; ++i)
+  {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ crcTable[crc & 0x0F];
+    crc = (crc >> 4) ^ crcTable[crc & 0x0F];
+  }
+  return ~crc & 0xFFFFFFFF;
+}
+
+unsigned long huffmanDeflateBound(unsigned long size)
+{
+  // Por bloco: dois "stored" (65535 + 1 bytes) de até 5 bytes de cabeçalho
+  return size + 10 * (size / HUFF_DEFLATE_CHUNK + 1) + 1;
+}
+
+/**
+ * Calcula comprimentos de código de Huffman limitados a maxLen bits. Como
+ * em buildCodeTable, se a árvore passar do limite os pesos são deslocados
+ * (nunca ficando menores que 1) e a árvore é refeita. As folhas ordenadas
+ * por peso e os nós internos, criados em ordem crescente de peso, formam
+ * duas filas: os dois menores estão sempre no início de uma delas.
+ *
+ * @param freq Frequência de cada símbolo.
+ * @param count Quantidade de símbolos (no máximo HUFF_DEFLATE_LITLEN_CODES).
+ * @param maxLen Comprimento máximo.
+ * @param len Recebe o comprimento de cada símbolo (0 se ausente).
+ */
+static void buildLengths(struct HuffmanDeflateWork *work,
+                         const unsigned freq[], int count, int maxLen,
+                         unsigned char len[])
+{
+  int leaves = 0;
+
+  memset(len, 0, (size_t)count);
+  for (int i = 0; i < count; ++i)
+  {
+    if (freq[i] == 0)
+      continue;
+
+    // Inserção ordenada por frequência
+    int k = leaves++;
+    while (k > 0 && freq[work->sortedSymbols[k - 1]] > freq[i])
+    {
+      work->sortedSymbols[k] = work->sortedSymbols[k - 1];
+      k--;
+    }
+    work->sortedSymbols[k] = (unsigned short)i;
+  }
+
+  // Um único símbolo ainda precisa de um bit por ocorrência
+  if (leaves == 1)
+    len[work->sortedSymbols[0]] = 1;
+  if (leaves <= 1)
+    return;
+
+  int root = 2 * leaves - 2;
+  for (int shift = 0;; ++shift)
+  {
+    int maxDepth = 0;
+    int nextLeaf = 0;
+    int nextNode = leaves;
+
+    for (int k = 0; k < leaves; ++k)
+    {
+      work->weight[k] = freq[work->sortedSymbols[k]] >> shift;
+      if (work->weight[k] == 0)
+        work->weight[k] = 1;
+    }
+    for (int node = leaves; node <= root; ++node)
+    {
+      work->weight[node] = 0;
+      for (int child = 0; child < 2; ++child)
+      {
+        int c = nextLeaf < leaves &&
+                        (nextNode >= node ||
+                         work->weight[nextLeaf] <= work->weight[nextNode])
+                    ? nextLeaf++
+                    : nextNode++;
+        work->parent[c] = (unsigned short)node;
+        work->weight[node] += work->weight[c];
+      }
+    }
+
+    // O pai sempre tem índice maior que os filhos
+    work->depth[root] = 0;
+    for (int node = root - 1; node >= 0; --node)
+    {
+      work->depth[node] = (unsigned short)(work->depth[work->parent[node]] + 1);
+      if (node < leaves && work->depth[node] > maxDepth)
+        maxDepth = work->depth[node];
+    }
+    if (maxDepth <= maxLen)
+      break;
+  }
+
+  for (int k = 0; k < leaves; ++k)
+    len[work->sortedSymbols[k]] = (unsigned char)work->depth[k];
+}
+
+/**
+ * Atribui os códigos canônicos da RFC 1951 (as mesmas regras de
+ * assignCanonicalCodes) e inverte os bits de cada um, já que o formato
+ * grava o código a partir do bit mais significativo num fluxo que começa
+ * pelo menos significativo.
+ */
+static void assignCodes(const unsigned char len[], int count,
+                        unsigned short code[])
+{
+  unsigned short lengthCount[HUFF_DEFLATE_MAX_CODE_LEN + 1] = {0};
+  unsigned short nextCode[HUFF_DEFLATE_MAX_CODE_LEN + 1];
+  unsigned short value = 0;
+
+  for (int i = 0; i < count; ++i)
+    lengthCount[len[i]]++;
+  lengthCount[0] = 0;
+  for (int l = 1; l <= HUFF_DEFLATE_MAX_CODE_LEN; ++l)
+  {
+    value = (unsigned short)((value + lengthCount[l - 1]) << 1);
+    nextCode[l] = value;
+  }
+
+  for (int i = 0; i < count; ++i)
+  {
+    unsigned forward = len[i] ? nextCode[len[i]]++ : 0;
+    unsigned reversed = 0;
+
+    for (int b = 0; b < len[i]; ++b)
+      reversed |= ((forward >> b) & 1) << (len[i] - 1 - b);
+    code[i] = (unsigned short)reversed;
+  }
+}
+
+/**
+ * Código de comprimento (257 a 285) de uma cópia: como nos valores de
+ * huffman_lz.h, mas com os 2 bits seguintes ao mais alto no código.
+ *
+ * @param extra Recebe a quantidade de bits extras.
+ */
+static int lengthCode(unsigned long length, int *extra)
+{
+  unsigned long value = length - 3;
+  int n = 3;
+
+  *extra = 0;
+  if (length == HUFF_DEFLATE_MAX_MATCH)
+    return 285;
+  if (value < 8)
+    return 257 + (int)value;
+  while ((value >> (n + 1)) != 0)
+    n++;
+  *extra = n - 2;
+  return 257 + 4 * (n - 1) + (int)((value >> (n - 2)) & 3);
+}
+
+// Código de distância (0 a 29): bit mais alto de distance - 1 e o seguinte
+static int distanceCode(unsigned long distance, int *extra)
+{
+  unsigned long value = distance - 1;
+  int n = 2;
+
+  *extra = 0;
+  if (value < 4)
+    return (int)value;
+  while ((value >> (n + 1)) != 0)
+    n++;
+  *extra = n - 1;
+  return 2 * n + (int)((value >> (n - 1)) & 1);
+}
+
+/**
+ * Codifica os comprimentos das duas tabelas com as repetições do formato:
+ * 16 repete o anterior de 3 a 6 vezes, 17 grava de 3 a 10 zeros e 18, de
+ * 11 a 138.
+ *
+ * @return Quantidade de símbolos em codeLenSymbols.
+ */
+static int encodeLengths(struct HuffmanDeflateWork *work, int total)
+{
+  int count = 0;
+
+  for (int i = 0; i < total;)
+  {
+    unsigned char value = work->allLengths[i];
+    int run = 1;
+
+    while (i + run < total && work->allLengths[i + run] == value)
+      run++;
+    i += run;
+
+    if (value == 0)
+    {
+      while (run >= 11)
+      {
+        int r = run < 138 ? run : 138;
+        work->codeLenSymbols[count] = 18;
+        work->codeLenExtra[count++] = (unsigned char)(r - 11);
+        run -= r;
+      }
+      if (run >= 3)
+      {
+        work->codeLenSymbols[count] = 17;
+        work->codeLenExtra[count++] = (unsigned char)(run - 3);
+        run = 0;
+      }
+    }
+    else
+    {
+      work->codeLenSymbols[count] = value;
+      work->codeLenExtra[count++] = 0;
+      run--;
+      while (run >= 3)
+      {
+        int r = run < 6 ? run : 6;
+        work->codeLenSymbols[count] = 16;
+        work->codeLenExtra[count++] = (unsigned char)(r - 3);
+        run -= r;
+      }
+    }
+    while (run-- > 0)
+    {
+      work->codeLenSymbols[count] = value;
+      work->codeLenExtra[count++] = 0;
+    }
+  }
+  return count;
+}
+
+// Bits extras de cada símbolo do código de comprimentos
+static int codeLenExtraBits(int symbol)
+{
+  return symbol == 16 ? 2 : symbol == 17 ? 3 : symbol == 18 ? 7 : 0;
+}
+
+// Fluxo de bits de saída, o menos significativo primeiro
+struct BitWriter
+{
+  unsigned char *p;        // Próximo byte a gravar
+  unsigned char *end;      // Fim do buffer de saída
+  unsigned long bitBuffer; // Bits que ainda não completam um byte
+  int bitCount;            // Quantidade de bits em bitBuffer
+};
+
+static void putBits(struct BitWriter *writer, unsigned bits, int len)
+{
+  writer->bitBuffer |= (unsigned long)bits << writer->bitCount;
+  writer->bitCount += len;
+  while (writer->bitCount >= 8)
+  {
+    *writer->p++ = (unsigned char)writer->bitBuffer;
+    writer->bitBuffer >>= 8;
+    writer->bitCount -= 8;
+  }
+}
+
+// Completa o byte atual com zeros
+static void alignByte(struct BitWriter *writer)
+{
+  if (writer->bitCount > 0)
+    putBits(writer, 0, 8 - writer->bitCount);
+}
+
+// Cabe mais bits na saída?
+static int hasRoom(const struct BitWriter *writer, unsigned long long bits)
+{
+  return (unsigned long long)(writer->end - writer->p) >=
+         ((unsigned long long)writer->bitCount + bits + 7) / 8;
+}
+
+/**
+ * Grava in[start, end) em blocos "stored" de até STORED_MAX bytes.
+ *
+ * @param final 1 se o último deles encerra o fluxo.
+ */
+static void writeStored(struct BitWriter *writer, const unsigned char *in,
+                        unsigned long start, unsigned long end, int final)
+{
+  do
+  {
+    unsigned long length = end - start < STORED_MAX ? end - start : STORED_MAX;
+
+    putBits(writer, final && start + length == end ? 1 : 0, 1);
+    putBits(writer, 0, 2);
+    alignByte(writer);
+    putBits(writer, (unsigned)length & 0xFF, 8);
+    putBits(writer, (unsigned)(length >> 8), 8);
+    putBits(writer, (unsigned)~length & 0xFF, 8);
+    putBits(writer, (unsigned)(~length >> 8) & 0xFF, 8);
+    memcpy(writer->p, in + start, length);
+    writer->p += length;
+    start += length;
+  } while (start < end);
+}
+
+// Grava os literais de in[start, start + count)
+static void putLiterals(const struct HuffmanDeflateWork *work,
+                        struct BitWriter *writer, const unsigned char *in,
+                        unsigned long start, unsigned long count)
+{
+  for (unsigned long i = start; i < start + count; ++i)
+    putBits(writer, work->litCode[in[i]], work->litLen[in[i]]);
+}
+
+// Tamanho e cabeçalho de um bloco dinâmico, calculados por planBlock
+struct BlockPlan
+{
+  unsigned long long bits; // Bloco inteiro: cabeçalho, tabelas e dados
+  int hlit;                // Códigos de literais/comprimentos gravados
+  int hdist;               // Códigos de distâncias gravados
+  int hclen;               // Códigos do código de comprimentos gravados
+  int symbols;             // Símbolos em codeLenSymbols
+};
+
+/**
+ * Conta as count sequências de work->sequences (0 para só literais) sobre
+ * in[start, end), monta as três tabelas em work e calcula o tamanho exato
+ * do bloco dinâmico que as grava.
+ */
+static void planBlock(struct HuffmanDeflateWork *work, const unsigned char *in,
+                      unsigned long start, unsigned long end,
+                      unsigned long count, struct BlockPlan *plan)
+{
+  const struct HuffmanLzSequence *sequences = work->sequences;
+  unsigned long pos = start;
+  unsigned long long bits = 3 + 5 + 5 + 4;
+  int extra;
+  int hlit = 257;
+  int hdist = 1;
+  int hclen = 4;
+
+  // Histogramas; os bits extras das cópias já entram na conta
+  memset(work->litFreq, 0, sizeof(work->litFreq));
+  memset(work->distFreq, 0, sizeof(work->distFreq));
+  for (unsigned long s = 0; s < count; ++s)
+  {
+    for (unsigned long i = 0; i < sequences[s].run; ++i)
+      work->litFreq[in[pos + i]]++;
+    int code = lengthCode(sequences[s].length + HUFF_LZ_MIN_MATCH, &extra);
+    work->litFreq[code]++;
+    bits += (unsigned long long)extra;
+    work->distFreq[distanceCode(sequences[s].distance + 1ul, &extra)]++;
+    bits += (unsigned long long)extra;
+    pos += sequences[s].run + sequences[s].length + HUFF_LZ_MIN_MATCH;
+  }
+  for (unsigned long i = pos; i < end; ++i)
+    work->litFreq[in[i]]++;
+  work->litFreq[END_OF_BLOCK] = 1;
+
+  // Sem cópias, a tabela de distâncias ainda precisa de um código
+  if (count == 0)
+    work->distFreq[0] = 1;
+  buildLengths(work, work->litFreq, HUFF_DEFLATE_LITLEN_CODES,
+               HUFF_DEFLATE_MAX_CODE_LEN, work->litLen);
+  buildLengths(work, work->distFreq, HUFF_DEFLATE_DIST_CODES,
+               HUFF_DEFLATE_MAX_CODE_LEN, work->distLen);
+  if (count == 0)
+    work->distFreq[0] = 0;
+
+  // Tabelas: só até o último código usado
+  for (int i = 0; i < HUFF_DEFLATE_LITLEN_CODES; ++i)
+  {
+    if (work->litLen[i] != 0)
+      hlit = i + 1 > hlit ? i + 1 : hlit;
+    bits += (unsigned long long)work->litFreq[i] * work->litLen[i];
+  }
+  for (int i = 0; i < HUFF_DEFLATE_DIST_CODES; ++i)
+  {
+    if (work->distLen[i] != 0)
+      hdist = i + 1;
+    bits += (unsigned long long)work->distFreq[i] * work->distLen[i];
+  }
+  memcpy(work->allLengths, work->litLen, (size_t)hlit);
+  memcpy(work->allLengths + hlit, work->distLen, (size_t)hdist);
+  int symbols = encodeLengths(work, hlit + hdist);
+
+  memset(work->codeLenFreq, 0, sizeof(work->codeLenFreq));
+  for (int i = 0; i < symbols; ++i)
+  {
+    work->codeLenFreq[work->codeLenSymbols[i]]++;
+    bits += (unsigned long long)codeLenExtraBits(work->codeLenSymbols[i]);
+  }
+  buildLengths(work, work->codeLenFreq, HUFF_DEFLATE_CODELEN_CODES,
+               CODELEN_MAX_LEN, work->codeLenLen);
+  for (int i = 0; i < HUFF_DEFLATE_CODELEN_CODES; ++i)
+  {
+    if (work->codeLenLen[codeLengthOrder[i]] != 0)
+      hclen = i + 1 > hclen ? i + 1 : hclen;
+    bits += (unsigned long long)work->codeLenFreq[i] * work->codeLenLen[i];
+  }
+
+  plan->bits = bits + 3ull * (unsigned)hclen;
+  plan->hlit = hlit;
+  plan->hdist = hdist;
+  plan->hclen = hclen;
+  plan->symbols = symbols;
+}
+
+/**
+ * Comprime in[start, end) num bloco dinâmico, ou em blocos "stored" se
+ * ficarem menores. Com cópias, o bloco é comparado com o de só literais, e
+ * fica o menor: em dados de alfabeto pequeno e sem repetições longas, as
+ * cópias curtas custam mais que os literais que substituem. Os bytes
+ * anteriores a start servem de histórico.
+ *
+ * @return 0 em caso de sucesso, -1 se não couber na saída.
+ */
+static int writeBlock(struct HuffmanDeflateWork *work,
+                      struct BitWriter *writer, const unsigned char *in,
+                      unsigned long start, unsigned long end, int level,
+                      int final)
+{
+  const struct HuffmanLzSequence *sequences = work->sequences;
+  struct BlockPlan plan;
+  unsigned long count = 0;
+  unsigned long pos;
+  int extra;
+
+  planBlock(work, in, start, end, 0, &plan);
+  if (level != HUFF_DEFLATE_LITERALS)
+  {
+    unsigned long long literals = plan.bits;
+
+    count = huffmanLzParse(&work->match, (const char *)in, start, end, level,
+                           HUFF_DEFLATE_WINDOW, HUFF_DEFLATE_MAX_MATCH,
+                           work->sequences);
+    planBlock(work, in, start, end, count, &plan);
+    if (plan.bits >= literals)
+    {
+      count = 0;
+      planBlock(work, in, start, end, 0, &plan);
+    }
+  }
+
+  // "Stored": cabeçalho de 3 bits, alinhamento e LEN/NLEN a cada 65535 bytes
+  unsigned long storedBlocks =
+      end == start ? 1 : (end - start + STORED_MAX - 1) / STORED_MAX;
+  unsigned long long storedBits =
+      3 + (unsigned long long)((8 - (writer->bitCount + 3) % 8) % 8) +
+      8ull * (storedBlocks - 1) + 32ull * storedBlocks + 8ull * (end - start);
+
+  if (storedBits <= plan.bits)
+  {
+    if (!hasRoom(writer, storedBits))
+      return -1;
+    writeStored(writer, in, start, end, final);
+    return 0;
+  }
+  if (!hasRoom(writer, plan.bits))
+    return -1;
+
+  assignCodes(work->litLen, HUFF_DEFLATE_LITLEN_CODES, work->litCode);
+  assignCodes(work->distLen, HUFF_DEFLATE_DIST_CODES, work->distCode);
+  assignCodes(work->codeLenLen, HUFF_DEFLATE_CODELEN_CODES, work->codeLenCode);
+
+  putBits(writer, final ? 1u : 0u, 1);
+  putBits(writer, 2, 2); // Huffman dinâmico
+  putBits(writer, (unsigned)(plan.hlit - 257), 5);
+  putBits(writer, (unsigned)(plan.hdist - 1), 5);
+  putBits(writer, (unsigned)(plan.hclen - 4), 4);
+  for (int i = 0; i < plan.hclen; ++i)
+    putBits(writer, work->codeLenLen[codeLengthOrder[i]], 3);
+  for (int i = 0; i < plan.symbols; ++i)
+  {
+    int symbol = work->codeLenSymbols[i];
+    putBits(writer, work->codeLenCode[symbol], work->codeLenLen[symbol]);
+    putBits(writer, work->codeLenExtra[i], codeLenExtraBits(symbol));
+  }
+
+  pos = start;
+  for (unsigned long s = 0; s < count; ++s)
+  {
+    unsigned long length = sequences[s].length + HUFF_LZ_MIN_MATCH;
+    unsigned long distance = sequences[s].distance + 1ul;
+    int code;
+
+    putLiterals(work, writer, in, pos, sequences[s].run);
+    code = lengthCode(length, &extra);
+    putBits(writer, work->litCode[code], work->litLen[code]);
+    putBits(writer, (unsigned)((length - 3) & ((1ul << extra) - 1)), extra);
+    code = distanceCode(distance, &extra);
+    putBits(writer, work->distCode[code], work->distLen[code]);
+    putBits(writer, (unsigned)((distance - 1) & ((1ul << extra) - 1)), extra);
+    pos += sequences[s].run + length;
+  }
+  putLiterals(work, writer, in, pos, end - pos);
+  putBits(writer, work->litCode[END_OF_BLOCK], work->litLen[END_OF_BLOCK]);
+  return 0;
+}
+
+long huffmanDeflateEncode(struct HuffmanDeflateWork *work, const char *in,
+                          unsigned long size, unsigned char *out,
+                          unsigned long outSize, int level)
+{
+  struct BitWriter writer = {out, out + outSize, 0, 0};
+  unsigned long start = 0;
+
+  if (level != HUFF_DEFLATE_LITERALS &&
+      (level < HUFF_LZ_FAST || level > HUFF_LZ_BEST))
+    return -1;
+
+  // Mesmo a entrada vazia gera um bloco, o que tem BFINAL
+  do
+  {
+    unsigned long end =
+        size - start < HUFF_DEFLATE_CHUNK ? size : start + HUFF_DEFLATE_CHUNK;
+    if (writeBlock(work, &writer, (const unsigned char *)in, start, end, level,
+                   end == size) != 0)
+      return -1;
+    start = end;
+  } while (start < size);
+
+  // hasRoom já contou o byte incompleto
+  if (writer.bitCount > 0)
+    *writer.p++ = (unsigned char)writer.bitBuffer;
+  return (long)(writer.p - out);
+}
+
+long huffmanGzipEncode(struct HuffmanDeflateWork *work, const char *in,
+                       unsigned long size, unsigned char *out,
+                       unsigned long outSize, int level)
+{
+  // ID1 ID2, CM = 8 (deflate), sem flags nem data, XFL = 0, SO desconhecido
+  static const unsigned char header[10] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF};
+  unsigned long crc = huffmanCrc32(0, (const unsigned char *)in, size);
+  long written;
+
+  if (outSize < HUFF_GZIP_OVERHEAD)
+    return -1;
+  memcpy(out, header, sizeof(header));
+  written = huffmanDeflateEncode(work, in, size, out + sizeof(header),
+                                 outSize - HUFF_GZIP_OVERHEAD, level);
+  if (written < 0)
+    return -1;
+
+  unsigned char *trailer = out + sizeof(header) + written;
+  for (int i = 0; i < 4; ++i)
+  {
+    trailer[i] = (unsigned char)(crc >> (8 * i));
+    trailer[4 + i] = (unsigned char)(size >> (8 * i));
+  }
+  return written + HUFF_GZIP_OVERHEAD;
+}
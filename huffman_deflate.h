@@ -0,0 +1,124 @@
+/*
+ * Algoritmo de Codificação de Huffman - Saída compatível com DEFLATE
+ *
+ * Descrição:
+ * Gera fluxos DEFLATE (RFC 1951) com blocos de Huffman dinâmicos, que zlib,
+ * gzip e qualquer outro decodificador padrão leem sem conversão. Cada
+ * HUFF_DEFLATE_CHUNK bytes de entrada viram um bloco: os literais e as
+ * cópias de huffmanLzParse (janela de 32 KB, cópias de até 258 bytes) são
+ * contados, as duas tabelas (literais/comprimentos e distâncias) são
+ * limitadas a 15 bits e gravadas pelo código de comprimentos. O bloco com
+ * cópias é comparado com o de só literais, e o menor é gravado; ele só
+ * vira "stored" (sem compressão) se assim ficar menor ainda.
+ *
+ * Diferenças em relação aos blocos HB (huffman_frame.h): os bits são
+ * gravados a partir do menos significativo de cada byte, os códigos de
+ * Huffman com os bits invertidos, e o alfabeto de literais/comprimentos tem
+ * 286 símbolos, então as tabelas são montadas aqui, sem HuffmanCodeTable.
+ *
+ * huffmanGzipEncode envolve o fluxo no formato gzip (RFC 1952): cabeçalho de
+ * 10 bytes, o fluxo DEFLATE, o CRC-32 e o tamanho original.
+ */
+#ifndef HUFFMAN_DEFLATE_H
+#define HUFFMAN_DEFLATE_H
+
+#include "huffman_lz.h"
+
+#define HUFF_DEFLATE_LITERALS 0           // Nível sem cópias: só literais
+#define HUFF_DEFLATE_WINDOW (1ul << 15)   // Janela do formato (32 KB)
+#define HUFF_DEFLATE_MAX_MATCH 258        // Maior cópia do formato
+#define HUFF_DEFLATE_MAX_CODE_LEN 15      // Limite dos códigos do formato
+#define HUFF_DEFLATE_CHUNK (1ul << 16)    // Entrada de cada bloco
+#define HUFF_GZIP_OVERHEAD 18             // Cabeçalho (10) + CRC-32 e tamanho (8)
+
+#define HUFF_DEFLATE_LITLEN_CODES 286 // Literais, fim de bloco e comprimentos
+#define HUFF_DEFLATE_DIST_CODES 30
+#define HUFF_DEFLATE_CODELEN_CODES 19 // Comprimentos 0 a 15 e repetições
+#define HUFF_DEFLATE_LENGTHS \
+  (HUFF_DEFLATE_LITLEN_CODES + HUFF_DEFLATE_DIST_CODES)
+
+// Memória de trabalho de huffmanDeflateEncode e huffmanGzipEncode. Grande
+// demais para a pilha: aloque com calloc (ou como estática do programa) e
+// use uma por thread.
+struct HuffmanDeflateWork
+{
+  struct HuffmanLzSequence sequences[HUFF_DEFLATE_CHUNK / HUFF_LZ_MIN_MATCH];
+  struct HuffmanLzMatchWork match;
+  unsigned litFreq[HUFF_DEFLATE_LITLEN_CODES];
+  unsigned distFreq[HUFF_DEFLATE_DIST_CODES];
+  unsigned codeLenFreq[HUFF_DEFLATE_CODELEN_CODES];
+  unsigned char litLen[HUFF_DEFLATE_LITLEN_CODES];
+  unsigned char distLen[HUFF_DEFLATE_DIST_CODES];
+  unsigned char codeLenLen[HUFF_DEFLATE_CODELEN_CODES];
+  unsigned short litCode[HUFF_DEFLATE_LITLEN_CODES]; // Bits invertidos
+  unsigned short distCode[HUFF_DEFLATE_DIST_CODES];
+  unsigned short codeLenCode[HUFF_DEFLATE_CODELEN_CODES];
+  // Comprimentos das duas tabelas, em sequência, e a sua codificação com
+  // repetições: símbolo do código de comprimentos e bits extras
+  unsigned char allLengths[HUFF_DEFLATE_LENGTHS];
+  unsigned char codeLenSymbols[HUFF_DEFLATE_LENGTHS];
+  unsigned char codeLenExtra[HUFF_DEFLATE_LENGTHS];
+  // Árvore dos comprimentos: folhas em ordem de peso, depois os nós internos
+  unsigned short sortedSymbols[HUFF_DEFLATE_LITLEN_CODES];
+  unsigned weight[2 * HUFF_DEFLATE_LITLEN_CODES];
+  unsigned short parent[2 * HUFF_DEFLATE_LITLEN_CODES];
+  unsigned short depth[2 * HUFF_DEFLATE_LITLEN_CODES];
+};
+
+/**
+ * Calcula o CRC-32 (polinômio refletido 0xEDB88320) usado pelo gzip.
+ *
+ * @param crc Valor anterior (0 no primeiro trecho).
+ * @param data Dados.
+ * @param size Tamanho dos dados.
+ * @return CRC-32 acumulado.
+ */
+unsigned long huffmanCrc32(unsigned long crc, const unsigned char *data,
+                           unsigned long size);
+
+/**
+ * Limite superior do fluxo DEFLATE para qualquer entrada de size bytes: no
+ * pior caso, todos os blocos são "stored".
+ *
+ * @param size Tamanho da entrada.
+ * @return Bytes suficientes para a saída de huffmanDeflateEncode.
+ */
+unsigned long huffmanDeflateBound(unsigned long size);
+
+/**
+ * Comprime a entrada em um fluxo DEFLATE bruto (sem cabeçalho zlib ou gzip),
+ * terminado por um bloco com BFINAL.
+ *
+ * @param work Memória de trabalho.
+ * @param in Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @param out Buffer de saída, com ao menos huffmanDeflateBound(size) bytes
+ *            para nunca falhar.
+ * @param outSize Capacidade do buffer de saída.
+ * @param level HUFF_DEFLATE_LITERALS, ou HUFF_LZ_FAST a HUFF_LZ_BEST para
+ *              procurar cópias como em huffmanLzEncode.
+ * @return Tamanho do fluxo, ou -1 se não couber em out ou se level for
+ *         outro valor.
+ */
+long huffmanDeflateEncode(struct HuffmanDeflateWork *work, const char *in,
+                          unsigned long size, unsigned char *out,
+                          unsigned long outSize, int level);
+
+/**
+ * Como huffmanDeflateEncode, mas no formato gzip.
+ *
+ * @param work Memória de trabalho.
+ * @param in Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @param out Buffer de saída, com ao menos huffmanDeflateBound(size) +
+ *            HUFF_GZIP_OVERHEAD bytes para nunca falhar.
+ * @param outSize Capacidade do buffer de saída.
+ * @param level Como em huffmanDeflateEncode.
+ * @return Tamanho do arquivo gzip, ou -1 se não couber em out ou se level
+ *         for inválido.
+ */
+long huffmanGzipEncode(struct HuffmanDeflateWork *work, const char *in,
+                       unsigned long size, unsigned char *out,
+                       unsigned long outSize, int level);
+
+#endif
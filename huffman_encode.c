@@ -0,0 +1,163 @@
+/*
+ * Algoritmo de Codificação de Huffman - Codificador em fluxo
+ *
+ * Descrição:
+ * Converte a entrada em códigos de Huffman e acumula os bits em um bloco de
+ * HUFF_OUT_CHUNK bytes. Cada bloco é entregue ao sink assim que enche, de
+ * modo que a memória do codificador não depende do tamanho da entrada e os
+ * primeiros bytes saem antes de a entrada terminar.
+ *
+ * Este módulo não depende de huffman.c: com tabelas constantes geradas por
+ * huffman_gen.c, a placa codifica sem construir árvore nenhuma.
+ */
+#include "huffman.h"
+
+// Entrega o bloco atual ao sink e o esvazia
+static void flushChunk(struct HuffmanEncoder *encoder)
+{
+  if (encoder->size > 0)
+  {
+    encoder->sink(encoder->chunk, encoder->size, encoder->context);
+    encoder->total += encoder->size;
+    encoder->size = 0;
+  }
+}
+
+unsigned long long huffmanEncodedBits(const unsigned freq[],
+                                      const struct HuffmanCodeTable *table)
+{
+  unsigned long long bits = 0;
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    bits += (unsigned long long)freq[i] * table->len[i];
+  return bits;
+}
+
+unsigned long long huffmanEncodedBound(unsigned long size)
+{
+  return HUFF_FRAME_HEADER_SIZE +
+         ((unsigned long long)size * HUFF_MAX_CODE_LEN + 7) / 8;
+}
+
+void huffmanEncoderInitRaw(struct HuffmanEncoder *encoder,
+                           const struct HuffmanCodeTable *table,
+                           unsigned long rawSize, HuffmanSink sink,
+                           void *context)
+{
+  encoder->table = table;
+  encoder->sink = sink;
+  encoder->context = context;
+  encoder->total = 0;
+  encoder->remaining = rawSize;
+  encoder->bitBuffer = 0;
+  encoder->bitCount = 0;
+  encoder->size = 0;
+}
+
+void huffmanEncoderInit(struct HuffmanEncoder *encoder,
+                        const struct HuffmanCodeTable *table,
+                        const unsigned freq[], HuffmanSink sink, void *context)
+{
+  unsigned long long bits = huffmanEncodedBits(freq, table);
+  unsigned long rawSize = 0;
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    rawSize += freq[i];
+
+  huffmanEncoderInitRaw(encoder, table, rawSize, sink, context);
+
+  encoder->chunk[0] = (unsigned char)rawSize;
+  encoder->chunk[1] = (unsigned char)(rawSize >> 8);
+  encoder->chunk[2] = (unsigned char)(rawSize >> 16);
+  encoder->chunk[3] = (unsigned char)(rawSize >> 24);
+  encoder->chunk[4] = (unsigned char)((8 - bits % 8) % 8);
+  encoder->size = HUFF_FRAME_HEADER_SIZE;
+}
+
+int huffmanEncodeUpdate(struct HuffmanEncoder *encoder, const char data[],
+                        int size)
+{
+  const struct HuffmanCodeTable *table = encoder->table;
+  unsigned bitBuffer = encoder->bitBuffer;
+  int bitCount = encoder->bitCount;
+
+  if (size < 0 || (unsigned long)size > encoder->remaining)
+    return -1;
+
+  // Confere a parte inteira antes de mexer no estado: uma parte recusada
+  // não consome nada do tamanho anunciado e pode ser corrigida e reenviada
+  for (int i = 0; i < size; ++i)
+  {
+    unsigned char c = (unsigned char)data[i];
+#if HUFF_ALPHABET_SIZE < 256
+    if (c >= HUFF_ALPHABET_SIZE)
+      return -1;
+#endif
+    if (table->len[c] == 0)
+      return -1;
+  }
+  encoder->remaining -= (unsigned long)size;
+
+  for (int i = 0; i < size; ++i)
+  {
+    unsigned char c = (unsigned char)data[i];
+
+    // bitCount < 8 antes de acrescentar até 16 bits: cabe em 32 bits
+    bitBuffer = (bitBuffer << table->len[c]) | table->bits[c];
+    bitCount += table->len[c];
+
+    while (bitCount >= 8)
+    {
+      bitCount -= 8;
+      encoder->chunk[encoder->size++] = (unsigned char)(bitBuffer >> bitCount);
+      if (encoder->size == HUFF_OUT_CHUNK)
+        flushChunk(encoder);
+    }
+    bitBuffer &= (1u << bitCount) - 1;
+  }
+
+  encoder->bitBuffer = bitBuffer;
+  encoder->bitCount = bitCount;
+  return 0;
+}
+
+unsigned long long huffmanEncodeBuffer(const struct HuffmanCodeTable *table,
+                                       const char in[], unsigned long size,
+                                       unsigned char out[])
+{
+  unsigned char *p = out;
+  unsigned bitBuffer = 0;
+  int bitCount = 0;
+
+  // Os bits acima de bitCount + 8 são descartados pelo cast para byte, então
+  // não é preciso mascarar o acumulador
+  for (unsigned long i = 0; i < size; ++i)
+  {
+    unsigned char c = (unsigned char)in[i];
+    bitBuffer = (bitBuffer << table->len[c]) | table->bits[c];
+    bitCount += table->len[c];
+    while (bitCount >= 8)
+    {
+      bitCount -= 8;
+      *p++ = (unsigned char)(bitBuffer >> bitCount);
+    }
+  }
+
+  if (bitCount > 0)
+    *p++ = (unsigned char)(bitBuffer << (8 - bitCount));
+  return 8ull * (unsigned long long)(p - out) - (8 - bitCount) % 8;
+}
+
+int huffmanEncoderFinish(struct HuffmanEncoder *encoder)
+{
+  // Completa o último byte com zeros à direita
+  if (encoder->bitCount > 0)
+  {
+    encoder->chunk[encoder->size++] =
+        (unsigned char)(encoder->bitBuffer << (8 - encoder->bitCount));
+    encoder->bitBuffer = 0;
+    encoder->bitCount = 0;
+  }
+  flushChunk(encoder);
+  return encoder->remaining == 0 ? 0 : -1;
+}
@@ -0,0 +1,53 @@
+/*
+ * Relatório de footprint de RAM do codificador de Huffman
+ *
+ * Descrição:
+ * Lista o tamanho de cada objeto de huffman.c para o perfil selecionado em
+ * huffman_config.h e compara o total com o orçamento do perfil. O mesmo
+ * limite é verificado por _Static_assert em huffman.c, de modo que um perfil
+ * que não cabe nem chega a compilar.
+ *
+ * Os tamanhos são os da ABI do compilador usado. Como a árvore usa índices
+ * de 16 bits em vez de ponteiros, os valores do host coincidem com os do
+ * Cortex-M0, exceto por diferenças de alinhamento de int.
+ *
+ * Uso (um executável por perfil):
+ * gcc -DHUFF_PROFILE=STM32F030 -DHUFF_FOOTPRINT_REPORT huffman_footprint.c huffman.c huffman_encode.c huffman_decode.c -o huffman_footprint
+ */
+#include <stdio.h>
+#include "huffman.h"
+
+#ifndef HUFF_FOOTPRINT_REPORT
+#error "Compile com -DHUFF_FOOTPRINT_REPORT"
+#endif
+
+#define HUFF_STR_(x) #x
+#define HUFF_STR(x) HUFF_STR_(x)
+
+int main()
+{
+  unsigned long staticTotal = 0;
+  unsigned long stackTotal = 0;
+
+  printf("Perfil: %s\n", HUFF_STR(HUFF_PROFILE));
+  printf("Alfabeto: %d simbolos, codigo maximo: %d bits, bloco de saida: %d bytes\n",
+         HUFF_ALPHABET_SIZE, HUFF_MAX_CODE_LEN, HUFF_OUT_CHUNK);
+  printf("\n%-12s %8s\n", "Objeto", "Bytes");
+
+  for (int i = 0; huffmanFootprint[i].name != NULL; ++i)
+  {
+    printf("%-12s %8lu%s\n", huffmanFootprint[i].name, huffmanFootprint[i].size,
+           huffmanFootprint[i].onStack ? " (pilha)" : "");
+    if (huffmanFootprint[i].onStack)
+      stackTotal += huffmanFootprint[i].size;
+    else
+      staticTotal += huffmanFootprint[i].size;
+  }
+
+  printf("\nEstatico: %lu bytes\n", staticTotal);
+  printf("Pilha:    %lu bytes\n", stackTotal);
+  printf("Total:    %lu de %d bytes (%.1f%%)\n", staticTotal + stackTotal,
+         HUFF_RAM_BUDGET, 100.0 * (staticTotal + stackTotal) / HUFF_RAM_BUDGET);
+
+  return 0;
+}
@@ -0,0 +1,446 @@
+/*
+ * Algoritmo de Codificação de Huffman - Formato de blocos
+ *
+ * Descrição:
+ * Empacota a saída do codificador em blocos autodescritivos (ver
+ * huffman_frame.h), com tabela de comprimentos, tamanhos e CRC32C opcional,
+ * divide a entrada onde a estatística muda e monta o índice de acesso
+ * aleatório. A leitura dos blocos fica em huffman_frame_decode.c.
+ */
+#include <string.h>
+#include "huffman_frame.h"
+
+#if HUFF_MAX_CODE_LEN > 15
+#error "A tabela do bloco guarda comprimentos de 4 bits"
+#endif
+
+static void writeLE32(unsigned char *p, unsigned long value)
+{
+  p[0] = (unsigned char)value;
+  p[1] = (unsigned char)(value >> 8);
+  p[2] = (unsigned char)(value >> 16);
+  p[3] = (unsigned char)(value >> 24);
+}
+
+static void writeLE64(unsigned char *p, uint64_t value)
+{
+  writeLE32(p, (unsigned long)(value & 0xFFFFFFFF));
+  writeLE32(p + 4, (unsigned long)(value >> 32));
+}
+
+long huffmanBlockFinish(unsigned char *out, int type, int flags,
+                        unsigned long rawSize, unsigned long bodySize)
+{
+  unsigned long blockSize = HUFF_BLOCK_HEADER_SIZE + bodySize;
+
+  out[0] = HUFF_BLOCK_MAGIC0;
+  out[1] = HUFF_BLOCK_MAGIC1;
+  out[2] = HUFF_BLOCK_VERSION;
+  out[3] = (unsigned char)type;
+  out[4] = (unsigned char)flags;
+  writeLE32(out + 5, rawSize);
+  writeLE32(out + 9, bodySize);
+
+  if (flags & HUFF_BLOCK_FLAG_CRC)
+  {
+    writeLE32(out + blockSize, crc32c(0, out, blockSize));
+    blockSize += HUFF_BLOCK_CRC_SIZE;
+  }
+  return (long)blockSize;
+}
+
+/**
+ * Grava um bloco HUFF_BLOCK_STORED.
+ *
+ * @return Tamanho do bloco, ou -1 se não couber em out.
+ */
+static long encodeStored(const char *in, unsigned long size, unsigned char *out,
+                         unsigned long outSize, int flags)
+{
+  unsigned long reserved =
+      HUFF_BLOCK_HEADER_SIZE + (flags & HUFF_BLOCK_FLAG_CRC ? HUFF_BLOCK_CRC_SIZE : 0);
+
+  if (outSize < reserved || outSize - reserved < size)
+    return -1;
+  memcpy(out + HUFF_BLOCK_HEADER_SIZE, in, size);
+  return huffmanBlockFinish(out, HUFF_BLOCK_STORED, flags & HUFF_BLOCK_FLAG_CRC,
+                            size, size);
+}
+
+// Grava a tabela de comprimentos de codes no início do corpo
+static void writeLengths(const struct HuffmanCodeTable *codes,
+                         unsigned char *body, int symbols,
+                         unsigned long tableSize)
+{
+  body[0] = (unsigned char)symbols; // 256 vira 0
+  memset(body + 1, 0, tableSize - 1);
+  for (int i = 0; i < symbols; ++i)
+    body[1 + i / 2] |= (unsigned char)(codes->len[i] << (i % 2 ? 0 : 4));
+}
+
+/**
+ * Codifica os símbolos start, start + HUFF_STREAMS, ... da entrada.
+ *
+ * @return Bytes gravados em out, com o último completado com zeros.
+ */
+static unsigned long encodeStream(const struct HuffmanCodeTable *codes,
+                                  const char *in, unsigned long size,
+                                  unsigned long start, unsigned char *out)
+{
+  unsigned char *p = out;
+  unsigned bitBuffer = 0;
+  int bitCount = 0;
+
+  for (unsigned long i = start; i < size; i += HUFF_STREAMS)
+  {
+    unsigned char c = (unsigned char)in[i];
+    bitBuffer = (bitBuffer << codes->len[c]) | codes->bits[c];
+    bitCount += codes->len[c];
+    while (bitCount >= 8)
+    {
+      bitCount -= 8;
+      *p++ = (unsigned char)(bitBuffer >> bitCount);
+    }
+  }
+
+  if (bitCount > 0)
+    *p++ = (unsigned char)(bitBuffer << (8 - bitCount));
+  return (unsigned long)(p - out);
+}
+
+/**
+ * Grava um bloco HUFF_BLOCK_STREAMS com os códigos já em codes.
+ *
+ * @return Tamanho do bloco, ou -1 se não couber em out.
+ */
+static long encodeStreams(const struct HuffmanCodeTable *codes, const char *in,
+                          unsigned long size, unsigned char *out,
+                          unsigned long outSize, int flags, int symbols)
+{
+  unsigned long tableSize = 1 + (symbols + 1) / 2;
+  unsigned long reserved =
+      HUFF_BLOCK_HEADER_SIZE + (flags & HUFF_BLOCK_FLAG_CRC ? HUFF_BLOCK_CRC_SIZE : 0);
+  unsigned long long bits[HUFF_STREAMS] = {0};
+  unsigned char *body = out + HUFF_BLOCK_HEADER_SIZE;
+  unsigned long headerSize = tableSize + 4 * (HUFF_STREAMS - 1);
+  unsigned long bodySize = headerSize;
+  unsigned char *p;
+
+  // Cada fluxo tem o seu último byte incompleto: o tamanho sai por fluxo
+  for (unsigned long i = 0; i < size; ++i)
+    bits[i % HUFF_STREAMS] += codes->len[(unsigned char)in[i]];
+  for (int s = 0; s < HUFF_STREAMS; ++s)
+    bodySize += (unsigned long)((bits[s] + 7) / 8);
+
+  if (bodySize >= size)
+    return encodeStored(in, size, out, outSize, flags);
+  if (outSize - reserved < bodySize)
+    return -1;
+
+  writeLengths(codes, body, symbols, tableSize);
+  p = body + headerSize;
+  for (int s = 0; s < HUFF_STREAMS; ++s)
+  {
+    unsigned long streamSize =
+        encodeStream(codes, in, size, (unsigned long)s, p);
+    if (s < HUFF_STREAMS - 1)
+      writeLE32(body + tableSize + 4 * s, streamSize);
+    p += streamSize;
+  }
+
+  return huffmanBlockFinish(out, HUFF_BLOCK_STREAMS, flags & HUFF_BLOCK_FLAG_CRC,
+                            size, bodySize);
+}
+
+unsigned long huffmanBlockBound(unsigned long size)
+{
+  // Um bloco HUFFMAN só é usado quando fica menor que o STORED
+  return HUFF_BLOCK_HEADER_SIZE + size + HUFF_BLOCK_CRC_SIZE;
+}
+
+/**
+ * Soma (sign = 1) ou subtrai (sign = -1) os símbolos de um trecho.
+ *
+ * @return 0 em caso de sucesso, -1 se houver símbolo fora do alfabeto.
+ */
+static int countRange(unsigned target[], const char *in, unsigned long from,
+                      unsigned long to, int sign)
+{
+  for (unsigned long i = from; i < to; ++i)
+  {
+    unsigned char c = (unsigned char)in[i];
+#if HUFF_ALPHABET_SIZE < 256
+    if (c >= HUFF_ALPHABET_SIZE)
+      return -1;
+#endif
+    target[c] += (unsigned)sign;
+  }
+  return 0;
+}
+
+long huffmanBlockEncode(struct HuffmanBlockEncodeWork *work, const char *in,
+                        unsigned long size, unsigned char *out,
+                        unsigned long outSize, int flags)
+{
+  unsigned *freq = work->freq;
+  unsigned long reserved =
+      HUFF_BLOCK_HEADER_SIZE + (flags & HUFF_BLOCK_FLAG_CRC ? HUFF_BLOCK_CRC_SIZE : 0);
+  const struct HuffmanKernels *kernels = huffmanKernels();
+  unsigned char *body = out + HUFF_BLOCK_HEADER_SIZE;
+  int symbols = 0;
+  int distinct = 0;
+
+  if (outSize < reserved + 1)
+    return -1;
+
+  memset(freq, 0, sizeof(work->freq));
+  if (countRange(freq, in, 0, size, 1) != 0)
+    return -1;
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (freq[i] != 0)
+    {
+      symbols = i + 1;
+      distinct++;
+    }
+  }
+
+  // Um único símbolo: basta guardá-lo uma vez
+  if (distinct == 1)
+  {
+    out[HUFF_BLOCK_HEADER_SIZE] = (unsigned char)in[0];
+    return huffmanBlockFinish(out, HUFF_BLOCK_RLE, flags & HUFF_BLOCK_FLAG_CRC,
+                              size, 1);
+  }
+
+  // Sem ganho previsto (ex: bytes quase uniformes), nem constrói a árvore
+  unsigned long tableSize = 1 + (symbols + 1) / 2;
+  if (distinct == 0 ||
+      estimateEntropyBits(freq) / 8 + tableSize >= size - size / 64)
+    return encodeStored(in, size, out, outSize, flags);
+
+  buildCodeTable(&work->tree, freq, &work->codes);
+  if (flags & HUFF_BLOCK_FLAG_STREAMS)
+    return encodeStreams(&work->codes, in, size, out, outSize, flags, symbols);
+
+  // Tamanho exato do corpo: se a estimativa errou, ainda cai para STORED
+  unsigned long long bits = huffmanEncodedBits(freq, &work->codes);
+  unsigned long bodySize = tableSize + (unsigned long)((bits + 7) / 8);
+  if (bodySize >= size)
+    return encodeStored(in, size, out, outSize, flags);
+  if (outSize - reserved < bodySize)
+    return -1;
+
+  writeLengths(&work->codes, body, symbols, tableSize);
+
+  // O espaço já foi conferido: a codificação não verifica limites
+  kernels->encode(&work->codes, in, size, body + tableSize);
+
+  flags = (flags & HUFF_BLOCK_FLAG_CRC) | (int)((8 - bits % 8) % 8);
+  return huffmanBlockFinish(out, HUFF_BLOCK_HUFFMAN, flags, size, bodySize);
+}
+
+// Bits estimados de um bloco HUFFMAN com o histograma dado
+static unsigned long long splitCost(const unsigned f[])
+{
+  int symbols = 0;
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (f[i] != 0)
+      symbols = i + 1;
+  }
+  return estimateEntropyBits(f) +
+         8ull * (HUFF_BLOCK_HEADER_SIZE + 1 + (unsigned long)(symbols + 1) / 2);
+}
+
+long huffmanSplitBlock(struct HuffmanSplitWork *work, const char *in,
+                       unsigned long size, unsigned long start)
+{
+  unsigned *blockFreq = work->blockFreq;
+  unsigned *windowFreq = work->windowFreq;
+  unsigned *leftFreq = work->leftFreq;
+  unsigned *rightFreq = work->rightFreq;
+  unsigned long end = size - start < HUFF_SPLIT_UNIT ? size : start + HUFF_SPLIT_UNIT;
+  unsigned long windowEnd = end;
+
+  memset(blockFreq, 0, sizeof(work->blockFreq));
+  memset(windowFreq, 0, sizeof(work->windowFreq));
+  if (countRange(blockFreq, in, start, end, 1) != 0)
+    return -1;
+
+  while (end < size)
+  {
+    // A janela cobre [end, end + HUFF_SPLIT_LOOKAHEAD unidades)
+    unsigned long limit = size - end < HUFF_SPLIT_UNIT * HUFF_SPLIT_LOOKAHEAD
+                              ? size
+                              : end + HUFF_SPLIT_UNIT * HUFF_SPLIT_LOOKAHEAD;
+    if (countRange(windowFreq, in, windowEnd, limit, 1) != 0)
+      return -1;
+    windowEnd = limit;
+
+    for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+      leftFreq[i] = blockFreq[i] + windowFreq[i];
+    unsigned long long joined = splitCost(leftFreq);
+    unsigned long long best = splitCost(blockFreq) + splitCost(windowFreq);
+
+    if (best < joined)
+    {
+      // Vale dividir: o corte vai para a unidade da janela mais barata
+      unsigned long cut = end;
+
+      memcpy(leftFreq, blockFreq, sizeof(work->leftFreq));
+      memcpy(rightFreq, windowFreq, sizeof(work->rightFreq));
+      for (unsigned long at = end + HUFF_SPLIT_UNIT; at < windowEnd;
+           at += HUFF_SPLIT_UNIT)
+      {
+        countRange(leftFreq, in, at - HUFF_SPLIT_UNIT, at, 1);
+        countRange(rightFreq, in, at - HUFF_SPLIT_UNIT, at, -1);
+        unsigned long long cost = splitCost(leftFreq) + splitCost(rightFreq);
+        if (cost < best)
+        {
+          best = cost;
+          cut = at;
+        }
+      }
+      return (long)cut;
+    }
+
+    // Sem ganho: a primeira unidade da janela passa para o bloco
+    unsigned long next = size - end < HUFF_SPLIT_UNIT ? size : end + HUFF_SPLIT_UNIT;
+    countRange(blockFreq, in, end, next, 1);
+    countRange(windowFreq, in, end, next, -1);
+    end = next;
+  }
+  return (long)size;
+}
+
+long huffmanSplitEncode(struct HuffmanSplitWork *work, const char *in,
+                        unsigned long size, unsigned char *out,
+                        unsigned long outSize, int flags)
+{
+  unsigned long total = 0;
+  unsigned long start = 0;
+
+  // Entrada vazia ainda gera um bloco, como em huffmanBlockEncode
+  do
+  {
+    long end = huffmanSplitBlock(work, in, size, start);
+    if (end < 0)
+      return -1;
+
+    long written = huffmanBlockEncode(&work->block, in + start,
+                                      (unsigned long)end - start, out + total,
+                                      outSize - total, flags);
+    if (written < 0)
+      return -1;
+    total += (unsigned long)written;
+    start = (unsigned long)end;
+  } while (start < size);
+  return (long)total;
+}
+
+void huffmanSeekIndexInit(struct HuffmanSeekIndex *index,
+                          struct HuffmanSeekPoint *points,
+                          unsigned long capacity, unsigned long interval)
+{
+  index->points = points;
+  index->capacity = capacity;
+  index->count = 0;
+  index->interval = interval;
+  index->rawSize = 0;
+  index->archiveSize = 0;
+}
+
+// Acrescenta um ponto ao índice; -1 se não houver espaço
+static int addSeekPoint(struct HuffmanSeekIndex *index, uint64_t rawOffset,
+                        unsigned long long bitPos)
+{
+  struct HuffmanSeekPoint *point;
+
+  if (index->count == index->capacity)
+    return -1;
+  point = &index->points[index->count++];
+  point->rawOffset = rawOffset;
+  point->blockRawOffset = index->rawSize;
+  point->blockOffset = index->archiveSize;
+  point->byteOffset = bitPos / 8;
+  point->bit = (unsigned char)(bitPos % 8);
+  return 0;
+}
+
+int huffmanSeekIndexAddBlock(struct HuffmanSeekIndex *index,
+                             const unsigned char *block,
+                             unsigned long blockSize, const char *in)
+{
+  struct HuffmanBlockInfo info;
+  struct HuffmanCodeTable codes;
+
+  if (huffmanBlockParse(block, blockSize, &info) != 0)
+    return -1;
+
+  if (info.type >= HUFF_BLOCK_TYPES)
+    return -1;
+
+  // Blocos vazios não têm o que procurar
+  if (info.rawSize > 0)
+  {
+    if (addSeekPoint(index, index->rawSize, 0) != 0)
+      return -1;
+
+    // STORED e RLE já são endereçáveis diretamente a partir do início,
+    // STREAMS é percorrido desde o início de cada fluxo, e os blocos dos
+    // demais módulos são decodificados inteiros
+    if (info.type == HUFF_BLOCK_HUFFMAN && index->interval > 0)
+    {
+      unsigned long long bitPos = 0;
+
+      if (huffmanBlockReadLengths(&codes, block + HUFF_BLOCK_HEADER_SIZE,
+                                  &info) == 0)
+        return -1;
+      for (unsigned long i = 0; i < info.rawSize; ++i)
+      {
+        if (i > 0 && i % index->interval == 0 &&
+            addSeekPoint(index, index->rawSize + i, bitPos) != 0)
+          return -1;
+        bitPos += codes.len[(unsigned char)in[i]];
+      }
+    }
+  }
+
+  index->rawSize += info.rawSize;
+  index->archiveSize += info.blockSize;
+  return 0;
+}
+
+long huffmanSeekIndexWrite(const struct HuffmanSeekIndex *index,
+                           unsigned char *out, unsigned long outSize)
+{
+  unsigned long size = huffmanSeekIndexSize(index->count);
+  unsigned char *p = out + HUFF_SEEK_HEADER_SIZE;
+
+  if (size == 0 || outSize < size)
+    return -1;
+
+  out[0] = HUFF_SEEK_MAGIC0;
+  out[1] = HUFF_SEEK_MAGIC1;
+  out[2] = HUFF_SEEK_VERSION;
+  writeLE64(out + 3, index->interval);
+  writeLE64(out + 11, index->rawSize);
+  writeLE64(out + 19, index->archiveSize);
+  writeLE64(out + 27, index->count);
+
+  for (unsigned long i = 0; i < index->count; ++i)
+  {
+    const struct HuffmanSeekPoint *point = &index->points[i];
+    writeLE64(p, point->rawOffset);
+    writeLE64(p + 8, point->blockRawOffset);
+    writeLE64(p + 16, point->blockOffset);
+    writeLE64(p + 24, point->byteOffset);
+    p[32] = point->bit;
+    p += HUFF_SEEK_POINT_SIZE;
+  }
+  writeLE32(p, crc32c(0, out, size - HUFF_BLOCK_CRC_SIZE));
+  return (long)size;
+}
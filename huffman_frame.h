@@ -0,0 +1,410 @@
+/*
+ * Algoritmo de Codificação de Huffman - Formato de blocos
+ *
+ * Cada bloco é autodescritivo e pode ser pulado, verificado e decodificado
+ * sem ler os demais. Layout (inteiros em little-endian):
+ *
+ *   0  2 bytes  Assinatura 'H' 'B'
+ *   2  1 byte   Versão do formato (HUFF_BLOCK_VERSION)
+ *   3  1 byte   Tipo do bloco (HUFF_BLOCK_*)
+ *   4  1 byte   Flags: bit 7 = CRC32C presente, bits 0-2 = preenchimento
+ *   5  4 bytes  Tamanho original (bytes)
+ *   9  4 bytes  Tamanho comprimido: bytes após o cabeçalho, sem o CRC
+ *  13  ...      Corpo do bloco (tabela + dados, conforme o tipo)
+ *      4 bytes  CRC32C do cabeçalho e do corpo (se o flag estiver ativo)
+ *
+ * Corpo de um bloco HUFF_BLOCK_HUFFMAN: 1 byte n com a quantidade de
+ * símbolos na tabela (0 significa 256), ceil(n / 2) bytes com o comprimento
+ * de código de cada símbolo (4 bits, símbolo par no nibble alto) e o fluxo
+ * de bits com códigos canônicos, o mais significativo primeiro.
+ *
+ * Corpo de um bloco HUFF_BLOCK_STREAMS: a mesma tabela de comprimentos,
+ * 7 x 4 bytes com o tamanho dos fluxos 0 a 6 (o fluxo 7 ocupa o restante)
+ * e os 8 fluxos de bits, um após o outro. O símbolo i da entrada vai para o
+ * fluxo i % 8, e cada fluxo termina completado com zeros; o campo de
+ * preenchimento do cabeçalho fica em 0. Como os fluxos são independentes,
+ * o decodificador pode avançar os 8 ao mesmo tempo (ex: com AVX2).
+ *
+ * Corpo de um bloco HUFF_BLOCK_STORED: os dados originais, sem alteração.
+ * Corpo de um bloco HUFF_BLOCK_RLE: 1 byte, repetido rawSize vezes.
+ *
+ * Um arquivo é uma sequência de blocos. O índice de acesso aleatório
+ * (HuffmanSeekIndex) fica fora dos blocos: é montado durante a compressão e
+ * guardado à parte, sem alterar o formato. As posições do índice têm 64
+ * bits, para arquivos maiores que 4 GB também no perfil de 32 bits, e
+ * huffmanSeekIndexWrite o grava neste layout (inteiros em little-endian):
+ *
+ *   0  2 bytes  Assinatura 'H' 'I'
+ *   2  1 byte   Versão do layout (HUFF_SEEK_VERSION)
+ *   3  8 bytes  Distância entre pontos (interval)
+ *  11  8 bytes  Total descomprimido indexado (rawSize)
+ *  19  8 bytes  Total de bytes de blocos indexados (archiveSize)
+ *  27  8 bytes  Quantidade de pontos (n)
+ *  35  n x 33   Pontos: rawOffset, blockRawOffset, blockOffset e byteOffset
+ *               (8 bytes cada) e bit (1 byte)
+ *      4 bytes  CRC32C de tudo o que vem antes
+ *
+ * As funções de bloco não guardam estado em variáveis estáticas: cada uma
+ * recebe, como primeiro parâmetro, a memória de trabalho do chamador
+ * (HuffmanBlockEncodeWork, HuffmanBlockDecodeWork ou HuffmanSplitWork),
+ * dimensionada pelo perfil. Threads diferentes podem codificar e
+ * decodificar ao mesmo tempo, cada uma com a sua. As de decodificação
+ * devem começar zeradas (estáticas, calloc ou memset), pois guardam as
+ * tabelas dos kernels de um bloco para o seguinte.
+ *
+ * A compressão fica em huffman_frame.c e a leitura (cabeçalho, CRC,
+ * decodificação e huffmanDecodeRange) em huffman_frame_decode.c, que só
+ * depende de huffman_decode.c: o decodificador da placa liga os dois, sem
+ * huffman.c, e o codificador liga huffman_frame.c e huffman_frame_decode.c.
+ */
+#ifndef HUFFMAN_FRAME_H
+#define HUFFMAN_FRAME_H
+
+#include <stdint.h>
+#include "huffman_cpu.h"
+
+#define HUFF_BLOCK_MAGIC0 'H'
+#define HUFF_BLOCK_MAGIC1 'B'
+#define HUFF_BLOCK_VERSION 1
+#define HUFF_BLOCK_HEADER_SIZE 13
+#define HUFF_BLOCK_CRC_SIZE 4
+
+// Tipos de bloco
+#define HUFF_BLOCK_HUFFMAN 0 // Tabela de comprimentos + códigos canônicos
+#define HUFF_BLOCK_STORED 1  // Dados sem compressão (entrada incompressível)
+#define HUFF_BLOCK_RLE 2     // Um único símbolo repetido
+#define HUFF_BLOCK_STREAMS 3 // Como HUFFMAN, em 8 fluxos intercalados
+// HUFF_BLOCK_CONTEXT (4) e HUFF_BLOCK_SEGMENTS (5) são gerados por huffman_context.c
+// HUFF_BLOCK_LZ (6) é gerado por huffman_lz.c
+// HUFF_BLOCK_BWT (7) é gerado por huffman_bwt.c
+#define HUFF_BLOCK_TYPES 8 // Tipos conhecidos, de HUFFMAN a BWT
+
+// Flags do bloco
+#define HUFF_BLOCK_FLAG_CRC 0x80    // CRC32C ao final do bloco
+#define HUFF_BLOCK_PADDING_MASK 0x07 // Bits de preenchimento do último byte
+
+// Opção de huffmanBlockEncode (não é gravada no cabeçalho)
+#define HUFF_BLOCK_FLAG_STREAMS 0x40 // Gera HUFF_BLOCK_STREAMS em vez de HUFFMAN
+
+// Índice gravado por huffmanSeekIndexWrite
+#define HUFF_SEEK_MAGIC0 'H'
+#define HUFF_SEEK_MAGIC1 'I'
+#define HUFF_SEEK_VERSION 1
+#define HUFF_SEEK_HEADER_SIZE 35
+#define HUFF_SEEK_POINT_SIZE 33
+
+// Divisão automática em blocos (huffmanSplitBlock)
+#define HUFF_SPLIT_UNIT 1024   // Granularidade dos pontos de divisão (bytes)
+#define HUFF_SPLIT_LOOKAHEAD 8 // Unidades à frente comparadas com o bloco atual
+
+// Memória de trabalho de huffmanBlockEncode
+struct HuffmanBlockEncodeWork
+{
+  unsigned freq[HUFF_ALPHABET_SIZE]; // Histograma do bloco
+  struct HuffmanCodeTable codes;     // Códigos do bloco
+  struct HuffmanTreeWork tree;       // Construção dos códigos
+};
+
+// Memória de trabalho de huffmanBlockDecode e huffmanDecodeRange
+struct HuffmanBlockDecodeWork
+{
+  struct HuffmanCodeTable codes;         // Códigos lidos do bloco
+  struct HuffmanDecodeTable decodeTable; // Árvore reconstruída
+  struct HuffmanKernelWork kernel;       // Tabelas dos kernels (huffman_cpu.h)
+};
+
+// Memória de trabalho de huffmanSplitBlock e huffmanSplitEncode
+struct HuffmanSplitWork
+{
+  unsigned blockFreq[HUFF_ALPHABET_SIZE];  // Bloco em formação
+  unsigned windowFreq[HUFF_ALPHABET_SIZE]; // Unidades à frente
+  unsigned leftFreq[HUFF_ALPHABET_SIZE];   // Lados de um corte candidato
+  unsigned rightFreq[HUFF_ALPHABET_SIZE];
+  struct HuffmanBlockEncodeWork block;     // Blocos de huffmanSplitEncode
+};
+
+// Campos do cabeçalho de um bloco
+struct HuffmanBlockInfo
+{
+  int type;                     // HUFF_BLOCK_*
+  int flags;                    // HUFF_BLOCK_FLAG_* e preenchimento
+  unsigned long rawSize;        // Tamanho original
+  unsigned long compressedSize; // Corpo do bloco, sem cabeçalho e CRC
+  unsigned long blockSize;      // Bloco inteiro: cabeçalho + corpo + CRC
+};
+
+// Ponto de acesso aleatório: onde retomar a decodificação dentro de um bloco
+struct HuffmanSeekPoint
+{
+  uint64_t rawOffset;      // Posição descomprimida do ponto
+  uint64_t blockRawOffset; // Posição descomprimida do início do bloco
+  uint64_t blockOffset;    // Posição do bloco (e da sua tabela) no arquivo
+  uint64_t byteOffset;     // Byte do fluxo de bits, após a tabela
+  unsigned char bit;       // Bits já consumidos desse byte
+};
+
+// Índice de um arquivo de blocos, com pontos fornecidos pelo chamador
+struct HuffmanSeekIndex
+{
+  struct HuffmanSeekPoint *points; // Em ordem crescente de rawOffset
+  unsigned long capacity;          // Tamanho de points
+  unsigned long count;             // Pontos em uso
+  uint64_t interval;               // Distância entre pontos (bytes originais)
+  uint64_t rawSize;                // Total descomprimido já indexado
+  uint64_t archiveSize;            // Total de bytes de blocos já indexados
+};
+
+/**
+ * Calcula o CRC32C (Castagnoli) de um trecho de memória.
+ *
+ * @param crc Valor anterior (0 no primeiro trecho).
+ * @param data Dados.
+ * @param size Tamanho dos dados.
+ * @return CRC acumulado.
+ */
+unsigned long crc32c(unsigned long crc, const unsigned char *data,
+                     unsigned long size);
+
+/**
+ * Limite superior do tamanho de um bloco, com CRC, para size bytes de
+ * entrada. Um buffer desse tamanho nunca faz huffmanBlockEncode falhar.
+ *
+ * @param size Tamanho da entrada.
+ * @return Bytes suficientes para o bloco.
+ */
+unsigned long huffmanBlockBound(unsigned long size);
+
+/**
+ * Comprime a entrada em um único bloco.
+ *
+ * O tipo é escolhido pelo histograma antes de construir a árvore: RLE se
+ * houver um só símbolo, STORED se a entropia estimada indicar ganho menor
+ * que 1/64 do tamanho original, e HUFFMAN (ou STREAMS, se pedido) nos
+ * demais casos.
+ *
+ * @param work Memória de trabalho.
+ * @param in Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @param flags HUFF_BLOCK_FLAG_CRC para acrescentar o CRC32C e
+ *              HUFF_BLOCK_FLAG_STREAMS para dividir em 8 fluxos, ou 0.
+ * @return Tamanho do bloco, ou -1 se não couber em out.
+ */
+long huffmanBlockEncode(struct HuffmanBlockEncodeWork *work, const char *in,
+                        unsigned long size, unsigned char *out,
+                        unsigned long outSize, int flags);
+
+/**
+ * Escreve o cabeçalho de um bloco cujo corpo já está em
+ * out + HUFF_BLOCK_HEADER_SIZE e, se pedido, o CRC ao final do corpo. Usada
+ * pelos módulos que geram outros tipos de bloco.
+ *
+ * @param out Início do bloco, com espaço para o CRC se HUFF_BLOCK_FLAG_CRC.
+ * @param type Tipo do bloco.
+ * @param flags Flags (inclusive preenchimento).
+ * @param rawSize Tamanho original.
+ * @param bodySize Tamanho do corpo já escrito após o cabeçalho.
+ * @return Tamanho total do bloco.
+ */
+long huffmanBlockFinish(unsigned char *out, int type, int flags,
+                        unsigned long rawSize, unsigned long bodySize);
+
+/**
+ * Lê e valida o cabeçalho de um bloco, sem decodificar o corpo. Serve para
+ * pular blocos: o próximo começa em in + info->blockSize.
+ *
+ * @param in Início do bloco.
+ * @param size Bytes disponíveis a partir de in.
+ * @param info Campos do cabeçalho.
+ * @return 0 em caso de sucesso, -1 se o cabeçalho for inválido ou truncado.
+ */
+int huffmanBlockParse(const unsigned char *in, unsigned long size,
+                      struct HuffmanBlockInfo *info);
+
+/**
+ * Confere o CRC32C de um bloco sem decodificá-lo.
+ *
+ * @param in Início do bloco.
+ * @param info Campos do cabeçalho (ver huffmanBlockParse).
+ * @return 0 se o CRC confere ou se o bloco não tem CRC, -1 caso contrário.
+ */
+int huffmanBlockVerify(const unsigned char *in,
+                       const struct HuffmanBlockInfo *info);
+
+/**
+ * Lê a tabela de comprimentos do início do corpo de um bloco
+ * HUFF_BLOCK_HUFFMAN ou HUFF_BLOCK_STREAMS (só os comprimentos; os bits
+ * ficam a cargo de assignCanonicalCodes).
+ *
+ * @param codes Recebe os comprimentos.
+ * @param body Início do corpo.
+ * @param info Campos do cabeçalho.
+ * @return Tamanho da tabela, ou 0 se for inválida.
+ */
+unsigned long huffmanBlockReadLengths(struct HuffmanCodeTable *codes,
+                                      const unsigned char *body,
+                                      const struct HuffmanBlockInfo *info);
+
+/**
+ * Decodifica um bloco, conferindo o CRC32C se presente.
+ *
+ * @param work Memória de trabalho.
+ * @param in Início do bloco.
+ * @param size Bytes disponíveis a partir de in.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @return Tamanho original, ou -1 se o bloco for inválido ou não couber em out.
+ */
+long huffmanBlockDecode(struct HuffmanBlockDecodeWork *work,
+                        const unsigned char *in, unsigned long size, char *out,
+                        unsigned long outSize);
+
+/**
+ * Escolhe o fim do bloco que começa em start, dividindo onde a estatística
+ * dos símbolos muda. A cada HUFF_SPLIT_UNIT bytes, o histograma do bloco
+ * até ali é comparado com o das HUFF_SPLIT_LOOKAHEAD unidades seguintes: se
+ * a entropia estimada das duas partes, cada uma com a sua tabela e o seu
+ * cabeçalho, ficar menor que a das duas juntas, o bloco termina na unidade
+ * dessa janela que minimiza o custo; senão, a unidade entra no bloco.
+ *
+ * @param work Memória de trabalho.
+ * @param in Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @param start Início do bloco.
+ * @return Fim do bloco (exclusivo), entre start + 1 e size, ou -1 se houver
+ *         símbolo fora do alfabeto.
+ */
+long huffmanSplitBlock(struct HuffmanSplitWork *work, const char *in,
+                       unsigned long size, unsigned long start);
+
+/**
+ * Comprime a entrada em uma sequência de blocos, divididos por
+ * huffmanSplitBlock, cada um gerado por huffmanBlockEncode. Arquivos de
+ * conteúdo misto ganham tabelas melhores sem que o chamador escolha o
+ * tamanho dos blocos.
+ *
+ * @param work Memória de trabalho.
+ * @param in Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @param flags Como em huffmanBlockEncode, aplicados a todos os blocos.
+ * @return Tamanho total dos blocos, ou -1 se não couberem em out.
+ */
+long huffmanSplitEncode(struct HuffmanSplitWork *work, const char *in,
+                        unsigned long size, unsigned char *out,
+                        unsigned long outSize, int flags);
+
+/**
+ * Prepara um índice vazio.
+ *
+ * @param index Índice.
+ * @param points Armazenamento dos pontos (ex: array estático).
+ * @param capacity Quantidade de pontos em points.
+ * @param interval Bytes originais entre pontos dentro de um bloco HUFFMAN.
+ */
+void huffmanSeekIndexInit(struct HuffmanSeekIndex *index,
+                          struct HuffmanSeekPoint *points,
+                          unsigned long capacity, unsigned long interval);
+
+/**
+ * Registra o próximo bloco do arquivo, que deve ser gravado logo após os
+ * blocos já indexados. Cada bloco recebe um ponto no início e, se for
+ * HUFFMAN, um a cada index->interval bytes originais. Blocos STREAMS só têm
+ * o ponto inicial: os 8 fluxos são percorridos desde o começo.
+ *
+ * Os blocos de huffman_context.c, huffman_lz.c e huffman_bwt.c (CONTEXT,
+ * SEGMENTS, LZ e BWT) também só têm o ponto inicial: são entradas de bloco
+ * inteiro, que huffmanDecodeRange recusa e huffmanDecodeAnyRange
+ * (huffman_blocks.h) decodifica por inteiro.
+ *
+ * @param index Índice.
+ * @param block Bloco gerado por huffmanBlockEncode ou pelos módulos acima.
+ * @param blockSize Tamanho do bloco.
+ * @param in Dados originais do bloco, usados para somar os comprimentos
+ *           (só lidos em blocos HUFFMAN).
+ * @return 0 em caso de sucesso, -1 se o bloco for inválido, de tipo
+ *         desconhecido ou se faltar espaço.
+ */
+int huffmanSeekIndexAddBlock(struct HuffmanSeekIndex *index,
+                             const unsigned char *block,
+                             unsigned long blockSize, const char *in);
+
+/**
+ * Procura o ponto de onde retomar a decodificação de offset.
+ *
+ * @param index Índice.
+ * @param offset Posição descomprimida.
+ * @return Último ponto com rawOffset <= offset (busca binária), ou 0 se o
+ *         índice estiver vazio.
+ */
+const struct HuffmanSeekPoint *
+huffmanSeekIndexFind(const struct HuffmanSeekIndex *index, uint64_t offset);
+
+/**
+ * Tamanho de um índice de count pontos gravado por huffmanSeekIndexWrite.
+ *
+ * @param count Quantidade de pontos.
+ * @return Bytes do índice gravado, com o CRC.
+ */
+unsigned long huffmanSeekIndexSize(unsigned long count);
+
+/**
+ * Grava o índice no layout versionado descrito no início deste arquivo,
+ * para guardá-lo ao lado do arquivo de blocos.
+ *
+ * @param index Índice.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @return Tamanho gravado (huffmanSeekIndexSize(index->count)), ou -1 se
+ *         não couber em out.
+ */
+long huffmanSeekIndexWrite(const struct HuffmanSeekIndex *index,
+                           unsigned char *out, unsigned long outSize);
+
+/**
+ * Lê um índice gravado por huffmanSeekIndexWrite. Assinatura, versão,
+ * tamanho, CRC32C e a ordem dos pontos são conferidos antes de usá-lo.
+ *
+ * @param index Recebe o índice, com os pontos em points.
+ * @param points Armazenamento dos pontos.
+ * @param capacity Quantidade de pontos em points.
+ * @param in Índice gravado.
+ * @param size Tamanho do índice gravado.
+ * @return 0 em caso de sucesso, -1 se for inválido, de outra versão ou se
+ *         os pontos não couberem em points.
+ */
+int huffmanSeekIndexRead(struct HuffmanSeekIndex *index,
+                         struct HuffmanSeekPoint *points,
+                         unsigned long capacity, const unsigned char *in,
+                         unsigned long size);
+
+/**
+ * Decodifica só o intervalo [offset, offset + size) do arquivo, a partir do
+ * ponto do índice mais próximo. O CRC não é conferido, pois cobre o bloco
+ * inteiro; use huffmanBlockVerify se necessário.
+ *
+ * Em blocos HUFFMAN, o custo é o de decodificar no máximo index->interval
+ * bytes antes de offset. Em blocos STREAMS, que só têm o ponto inicial,
+ * cada um dos 8 fluxos é percorrido desde o seu início até o fim do
+ * intervalo: o custo cresce com a posição de offset dentro do bloco, e
+ * blocos STREAMS menores limitam essa distância. Intervalos que passam por
+ * entradas de bloco inteiro (CONTEXT, SEGMENTS, LZ ou BWT) são recusados.
+ *
+ * @param work Memória de trabalho.
+ * @param archive Início do arquivo de blocos.
+ * @param archiveSize Tamanho do arquivo.
+ * @param index Índice do arquivo.
+ * @param offset Posição descomprimida do primeiro byte.
+ * @param out Buffer de saída, com ao menos size bytes.
+ * @param size Quantidade de bytes a decodificar.
+ * @return 0 em caso de sucesso, -1 se o intervalo ou o arquivo for inválido
+ *         ou se passar por uma entrada de bloco inteiro.
+ */
+int huffmanDecodeRange(struct HuffmanBlockDecodeWork *work,
+                       const unsigned char *archive, unsigned long archiveSize,
+                       const struct HuffmanSeekIndex *index,
+                       uint64_t offset, char *out, unsigned long size);
+
+#endif
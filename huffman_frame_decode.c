@@ -0,0 +1,533 @@
+/*
+ * Algoritmo de Codificação de Huffman - Decodificação de blocos
+ *
+ * Descrição:
+ * Valida o cabeçalho e o CRC32C dos blocos de huffman_frame.h, decodifica
+ * cada bloco de forma independente e serve trechos pelo índice de acesso
+ * aleatório. Só depende de huffman_decode.c (e, no host, dos kernels de
+ * huffman_cpu.c): o decodificador da placa liga este arquivo sem o
+ * codificador, e huffman_frame.c fica só com a compressão.
+ */
+#include <string.h>
+#include "huffman_frame.h"
+
+#if HUFF_MAX_CODE_LEN > 15
+#error "A tabela do bloco guarda comprimentos de 4 bits"
+#endif
+
+// CRC32C (polinômio refletido 0x82F63B78) processado 4 bits por vez
+static const unsigned long crcTable[16] = {
+    0x00000000, 0x105EC76F, 0x20BD8EDE, 0x30E349B1, 0x417B1DBC, 0x5125DAD3,
+    0x61C69362, 0x7198540D, 0x82F63B78, 0x92A8FC17, 0xA24BB5A6, 0xB21572C9,
+    0xC38D26C4, 0xD3D3E1AB, 0xE330A81A, 0xF36E6F75};
+
+unsigned long crc32c(unsigned long crc, const unsigned char *data,
+                     unsigned long size)
+{
+  crc = ~crc & 0xFFFFFFFF;
+  for (unsigned long i = 0; i < size; ++i)
+  {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ crcTable[crc & 0x0F];
+    crc = (crc >> 4) ^ crcTable[crc & 0x0F];
+  }
+  return ~crc & 0xFFFFFFFF;
+}
+
+static unsigned long readLE32(const unsigned char *p)
+{
+  return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+         ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static uint64_t readLE64(const unsigned char *p)
+{
+  return (uint64_t)readLE32(p) | ((uint64_t)readLE32(p + 4) << 32);
+}
+
+#ifdef HUFF_X86
+// No host, os kernels escolhidos por huffman_cpu.c
+static long long decodeKernel(struct HuffmanBlockDecodeWork *work,
+                              const unsigned char *in, unsigned long inSize,
+                              char *out, unsigned long count)
+{
+  return huffmanKernels()->decode(&work->kernel, &work->codes,
+                                  &work->decodeTable, in, inSize, out, count);
+}
+
+static int decodeStreamsKernel(struct HuffmanBlockDecodeWork *work,
+                               const unsigned char *streams[HUFF_STREAMS],
+                               const unsigned long sizes[HUFF_STREAMS],
+                               char *out, unsigned long count,
+                               unsigned long long consumed[HUFF_STREAMS])
+{
+  return huffmanKernels()->decodeStreams(&work->kernel, &work->codes,
+                                         &work->decodeTable, streams, sizes,
+                                         out, count, consumed);
+}
+#else
+// Fora de x86 só há os decodificadores portáveis de huffman_decode.c, e o
+// decodificador da placa não precisa ligar huffman_cpu.c
+static long long decodeKernel(struct HuffmanBlockDecodeWork *work,
+                              const unsigned char *in, unsigned long inSize,
+                              char *out, unsigned long count)
+{
+  return huffmanDecodeBuffer(&work->decodeTable, in, inSize, out, count);
+}
+
+static int decodeStreamsKernel(struct HuffmanBlockDecodeWork *work,
+                               const unsigned char *streams[HUFF_STREAMS],
+                               const unsigned long sizes[HUFF_STREAMS],
+                               char *out, unsigned long count,
+                               unsigned long long consumed[HUFF_STREAMS])
+{
+  return huffmanDecodeStreamsBuffer(&work->decodeTable, streams, sizes,
+                                    HUFF_STREAMS, out, count, consumed);
+}
+#endif
+
+int huffmanBlockParse(const unsigned char *in, unsigned long size,
+                      struct HuffmanBlockInfo *info)
+{
+  if (size < HUFF_BLOCK_HEADER_SIZE || in[0] != HUFF_BLOCK_MAGIC0 ||
+      in[1] != HUFF_BLOCK_MAGIC1 || in[2] != HUFF_BLOCK_VERSION)
+    return -1;
+
+  info->type = in[3];
+  info->flags = in[4];
+  info->rawSize = readLE32(in + 5);
+  info->compressedSize = readLE32(in + 9);
+  info->blockSize = HUFF_BLOCK_HEADER_SIZE + info->compressedSize +
+                    (info->flags & HUFF_BLOCK_FLAG_CRC ? HUFF_BLOCK_CRC_SIZE : 0);
+
+  // Rejeita tamanhos que estouram ou ultrapassam os bytes disponíveis
+  if (info->compressedSize > size || info->blockSize > size)
+    return -1;
+  return 0;
+}
+
+int huffmanBlockVerify(const unsigned char *in,
+                       const struct HuffmanBlockInfo *info)
+{
+  unsigned long covered = HUFF_BLOCK_HEADER_SIZE + info->compressedSize;
+
+  if (!(info->flags & HUFF_BLOCK_FLAG_CRC))
+    return 0;
+  return crc32c(0, in, covered) == readLE32(in + covered) ? 0 : -1;
+}
+
+unsigned long huffmanBlockReadLengths(struct HuffmanCodeTable *codes,
+                                      const unsigned char *body,
+                                      const struct HuffmanBlockInfo *info)
+{
+  int symbols;
+  unsigned long tableSize;
+
+  if (info->compressedSize == 0)
+    return 0;
+  symbols = body[0] ? body[0] : 256;
+  tableSize = 1 + (symbols + 1) / 2;
+  if (symbols > HUFF_ALPHABET_SIZE || tableSize > info->compressedSize)
+    return 0;
+
+  memset(codes, 0, sizeof(*codes));
+  for (int i = 0; i < symbols; ++i)
+    codes->len[i] = (body[1 + i / 2] >> (i % 2 ? 0 : 4)) & 0x0F;
+  return tableSize;
+}
+
+/**
+ * Decodifica o corpo de um bloco HUFF_BLOCK_HUFFMAN.
+ *
+ * @param body Início do corpo (tabela de comprimentos).
+ * @param info Campos do cabeçalho.
+ * @param out Buffer de saída, com ao menos info->rawSize bytes.
+ * @return 0 em caso de sucesso, -1 se o corpo for inválido.
+ */
+static int decodeHuffmanBody(struct HuffmanBlockDecodeWork *work,
+                             const unsigned char *body,
+                             const struct HuffmanBlockInfo *info, char *out)
+{
+  unsigned long tableSize = huffmanBlockReadLengths(&work->codes, body, info);
+  unsigned long dataSize;
+  long long bits;
+
+  if (tableSize == 0 || assignCanonicalCodes(&work->codes) != 0 ||
+      buildDecodeTable(&work->codes, &work->decodeTable) != 0)
+    return -1;
+
+  dataSize = info->compressedSize - tableSize;
+  bits = decodeKernel(work, body + tableSize, dataSize, out, info->rawSize);
+
+  // Só podem sobrar os bits de preenchimento anunciados no cabeçalho
+  if (bits < 0 || (unsigned long long)bits +
+                          (info->flags & HUFF_BLOCK_PADDING_MASK) !=
+                      8ull * dataSize)
+    return -1;
+  return 0;
+}
+
+/**
+ * Localiza os fluxos de um bloco HUFF_BLOCK_STREAMS e prepara work->codes e
+ * work->decodeTable.
+ *
+ * @param body Início do corpo (tabela de comprimentos).
+ * @param info Campos do cabeçalho.
+ * @param streams Recebe o início de cada fluxo.
+ * @param sizes Recebe o tamanho de cada fluxo.
+ * @return 0 em caso de sucesso, -1 se o corpo for inválido.
+ */
+static int readStreams(struct HuffmanBlockDecodeWork *work,
+                       const unsigned char *body,
+                       const struct HuffmanBlockInfo *info,
+                       const unsigned char *streams[HUFF_STREAMS],
+                       unsigned long sizes[HUFF_STREAMS])
+{
+  unsigned long tableSize = huffmanBlockReadLengths(&work->codes, body, info);
+  unsigned long pos = tableSize + 4 * (HUFF_STREAMS - 1);
+
+  if (tableSize == 0 || pos > info->compressedSize ||
+      assignCanonicalCodes(&work->codes) != 0 ||
+      buildDecodeTable(&work->codes, &work->decodeTable) != 0)
+    return -1;
+
+  for (int s = 0; s < HUFF_STREAMS; ++s)
+  {
+    unsigned long left = info->compressedSize - pos;
+    sizes[s] = s < HUFF_STREAMS - 1 ? readLE32(body + tableSize + 4 * s) : left;
+    if (sizes[s] > left)
+      return -1;
+    streams[s] = body + pos;
+    pos += sizes[s];
+  }
+  return 0;
+}
+
+/**
+ * Decodifica o corpo de um bloco HUFF_BLOCK_STREAMS.
+ *
+ * @param body Início do corpo (tabela de comprimentos).
+ * @param info Campos do cabeçalho.
+ * @param out Buffer de saída, com ao menos info->rawSize bytes.
+ * @return 0 em caso de sucesso, -1 se o corpo for inválido.
+ */
+static int decodeStreamsBody(struct HuffmanBlockDecodeWork *work,
+                             const unsigned char *body,
+                             const struct HuffmanBlockInfo *info, char *out)
+{
+  const unsigned char *streams[HUFF_STREAMS];
+  unsigned long sizes[HUFF_STREAMS];
+  unsigned long long consumed[HUFF_STREAMS];
+
+  if (readStreams(work, body, info, streams, sizes) != 0 ||
+      decodeStreamsKernel(work, streams, sizes, out, info->rawSize,
+                          consumed) != 0)
+    return -1;
+
+  // Cada fluxo termina no seu último byte, só com o preenchimento
+  for (int s = 0; s < HUFF_STREAMS; ++s)
+  {
+    if ((consumed[s] + 7) / 8 != sizes[s])
+      return -1;
+  }
+  return 0;
+}
+
+long huffmanBlockDecode(struct HuffmanBlockDecodeWork *work,
+                        const unsigned char *in, unsigned long size, char *out,
+                        unsigned long outSize)
+{
+  struct HuffmanBlockInfo info;
+
+  if (huffmanBlockParse(in, size, &info) != 0 ||
+      huffmanBlockVerify(in, &info) != 0 || info.rawSize > outSize)
+    return -1;
+
+  switch (info.type)
+  {
+  case HUFF_BLOCK_HUFFMAN:
+    if (decodeHuffmanBody(work, in + HUFF_BLOCK_HEADER_SIZE, &info, out) != 0)
+      return -1;
+    break;
+  case HUFF_BLOCK_STREAMS:
+    if (decodeStreamsBody(work, in + HUFF_BLOCK_HEADER_SIZE, &info, out) != 0)
+      return -1;
+    break;
+  case HUFF_BLOCK_STORED:
+    if (info.compressedSize != info.rawSize)
+      return -1;
+    memcpy(out, in + HUFF_BLOCK_HEADER_SIZE, info.rawSize);
+    break;
+  case HUFF_BLOCK_RLE:
+    if (info.compressedSize != 1)
+      return -1;
+    memset(out, in[HUFF_BLOCK_HEADER_SIZE], info.rawSize);
+    break;
+  default:
+    return -1;
+  }
+  return (long)info.rawSize;
+}
+
+unsigned long huffmanSeekIndexSize(unsigned long count)
+{
+  unsigned long limit = (~0ul - HUFF_SEEK_HEADER_SIZE - HUFF_BLOCK_CRC_SIZE) /
+                        HUFF_SEEK_POINT_SIZE;
+
+  // 0 se o tamanho não couber em unsigned long
+  if (count > limit)
+    return 0;
+  return HUFF_SEEK_HEADER_SIZE + count * HUFF_SEEK_POINT_SIZE +
+         HUFF_BLOCK_CRC_SIZE;
+}
+
+int huffmanSeekIndexRead(struct HuffmanSeekIndex *index,
+                         struct HuffmanSeekPoint *points,
+                         unsigned long capacity, const unsigned char *in,
+                         unsigned long size)
+{
+  const unsigned char *p = in + HUFF_SEEK_HEADER_SIZE;
+  uint64_t count;
+
+  if (size < HUFF_SEEK_HEADER_SIZE + HUFF_BLOCK_CRC_SIZE ||
+      in[0] != HUFF_SEEK_MAGIC0 || in[1] != HUFF_SEEK_MAGIC1 ||
+      in[2] != HUFF_SEEK_VERSION)
+    return -1;
+  count = readLE64(in + 27);
+  if (count > capacity || huffmanSeekIndexSize((unsigned long)count) != size ||
+      crc32c(0, in, size - HUFF_BLOCK_CRC_SIZE) !=
+          readLE32(in + size - HUFF_BLOCK_CRC_SIZE))
+    return -1;
+
+  index->points = points;
+  index->capacity = capacity;
+  index->count = 0;
+  index->interval = readLE64(in + 3);
+  index->rawSize = readLE64(in + 11);
+  index->archiveSize = readLE64(in + 19);
+
+  // Os pontos ficam em ordem e dentro do que foi indexado, como os de
+  // huffmanSeekIndexAddBlock: huffmanDecodeRange confia nisso
+  for (unsigned long i = 0; i < (unsigned long)count; ++i)
+  {
+    struct HuffmanSeekPoint *point = &points[i];
+
+    point->rawOffset = readLE64(p);
+    point->blockRawOffset = readLE64(p + 8);
+    point->blockOffset = readLE64(p + 16);
+    point->byteOffset = readLE64(p + 24);
+    point->bit = p[32];
+    p += HUFF_SEEK_POINT_SIZE;
+
+    if (point->bit > 7 || point->blockRawOffset > point->rawOffset ||
+        point->rawOffset >= index->rawSize ||
+        point->blockOffset >= index->archiveSize ||
+        (i > 0 && (point->rawOffset <= points[i - 1].rawOffset ||
+                   point->blockRawOffset < points[i - 1].blockRawOffset ||
+                   point->blockOffset < points[i - 1].blockOffset)))
+      return -1;
+  }
+  index->count = (unsigned long)count;
+  return 0;
+}
+
+const struct HuffmanSeekPoint *
+huffmanSeekIndexFind(const struct HuffmanSeekIndex *index, uint64_t offset)
+{
+  unsigned long low = 0;
+  unsigned long high = index->count;
+
+  while (high - low > 1)
+  {
+    unsigned long mid = low + (high - low) / 2;
+    if (index->points[mid].rawOffset <= offset)
+      low = mid;
+    else
+      high = mid;
+  }
+  return index->count > 0 && index->points[low].rawOffset <= offset
+             ? &index->points[low]
+             : 0;
+}
+
+/**
+ * Decodifica size símbolos para out, continuando de *pos no corpo.
+ *
+ * @return 0 em caso de sucesso, -1 se o fluxo acabar ou for inválido.
+ */
+static int decodeSymbols(struct HuffmanDecoder *decoder,
+                         const unsigned char *body, unsigned long *pos,
+                         unsigned long end, char *out, unsigned long size)
+{
+  unsigned long done = 0;
+
+  while (done < size)
+  {
+    int inPart = end - *pos < 0x4000 ? (int)(end - *pos) : 0x4000;
+    int outPart = size - done < 0x4000 ? (int)(size - done) : 0x4000;
+    int consumed, produced;
+    int status = huffmanDecodeUpdate(decoder, body + *pos, inPart, &consumed,
+                                     out + done, outPart, &produced);
+    *pos += consumed;
+    done += produced;
+
+    if (status == HUFF_DECODE_ERROR ||
+        (status == HUFF_DECODE_DONE && done < size) ||
+        (status == HUFF_DECODE_NEED_INPUT && *pos == end))
+      return -1;
+  }
+  return 0;
+}
+
+/**
+ * Decodifica size bytes de um bloco HUFFMAN a partir da posição offset,
+ * retomando o fluxo no ponto de acesso point.
+ */
+static int decodeFromPoint(struct HuffmanBlockDecodeWork *work,
+                           const unsigned char *body,
+                           const struct HuffmanBlockInfo *info,
+                           const struct HuffmanSeekPoint *point,
+                           uint64_t offset, char *out, unsigned long size)
+{
+  struct HuffmanDecoder decoder;
+  unsigned long tableSize = huffmanBlockReadLengths(&work->codes, body, info);
+  unsigned long skip = (unsigned long)(offset - point->rawOffset);
+  unsigned long pos;
+  char discard[64];
+
+  if (tableSize == 0 || assignCanonicalCodes(&work->codes) != 0 ||
+      buildDecodeTable(&work->codes, &work->decodeTable) != 0)
+    return -1;
+
+  if (point->byteOffset > info->compressedSize - tableSize)
+    return -1;
+  pos = tableSize + (unsigned long)point->byteOffset;
+  if (point->bit > 0 && pos == info->compressedSize)
+    return -1;
+
+  huffmanDecoderInitRaw(&decoder, &work->decodeTable,
+                        (unsigned long)(point->blockRawOffset + info->rawSize -
+                                        point->rawOffset),
+                        info->flags & HUFF_BLOCK_PADDING_MASK);
+  if (point->bit > 0)
+    huffmanDecoderStartAt(&decoder, body[pos++], point->bit);
+
+  // Do ponto até offset: no máximo index->interval bytes descartados
+  while (skip > 0)
+  {
+    unsigned long part = skip < sizeof(discard) ? skip : sizeof(discard);
+    if (decodeSymbols(&decoder, body, &pos, info->compressedSize, discard,
+                      part) != 0)
+      return -1;
+    skip -= part;
+  }
+  return decodeSymbols(&decoder, body, &pos, info->compressedSize, out, size);
+}
+
+/**
+ * Decodifica os bytes [first, first + size) de um bloco HUFF_BLOCK_STREAMS.
+ * Cada fluxo é percorrido na árvore desde o início, descartando os símbolos
+ * anteriores a first.
+ */
+static int decodeStreamsRange(struct HuffmanBlockDecodeWork *work,
+                              const unsigned char *body,
+                              const struct HuffmanBlockInfo *info,
+                              unsigned long first, char *out,
+                              unsigned long size)
+{
+  const unsigned char *streams[HUFF_STREAMS];
+  unsigned long sizes[HUFF_STREAMS];
+
+  if (readStreams(work, body, info, streams, sizes) != 0)
+    return -1;
+
+  for (int s = 0; s < HUFF_STREAMS; ++s)
+  {
+    unsigned long long total = 8ull * sizes[s];
+    unsigned long long pos = 0;
+
+    for (unsigned long i = (unsigned long)s; i < first + size; i += HUFF_STREAMS)
+    {
+      unsigned short node = 0;
+      unsigned short next;
+
+      do
+      {
+        if (pos == total)
+          return -1;
+        int bit = (streams[s][pos >> 3] >> (7 - (pos & 7))) & 1;
+        next = work->decodeTable.child[node][bit];
+        pos++;
+        if (next == HUFF_NO_NODE)
+          return -1;
+        node = next;
+      } while (!(next & HUFF_LEAF));
+
+      if (i >= first)
+        out[i - first] = (char)(next & 0xFF);
+    }
+  }
+  return 0;
+}
+
+int huffmanDecodeRange(struct HuffmanBlockDecodeWork *work,
+                       const unsigned char *archive, unsigned long archiveSize,
+                       const struct HuffmanSeekIndex *index,
+                       uint64_t offset, char *out, unsigned long size)
+{
+  if (offset > index->rawSize || size > index->rawSize - offset)
+    return -1;
+
+  while (size > 0)
+  {
+    const struct HuffmanSeekPoint *point = huffmanSeekIndexFind(index, offset);
+    const unsigned char *block;
+    const unsigned char *body;
+    struct HuffmanBlockInfo info;
+    unsigned long first; // Posição de offset dentro do bloco
+    unsigned long part;
+
+    if (point == 0 || point->blockOffset >= archiveSize)
+      return -1;
+    block = archive + (unsigned long)point->blockOffset;
+    body = block + HUFF_BLOCK_HEADER_SIZE;
+    if (huffmanBlockParse(block, archiveSize - (unsigned long)point->blockOffset,
+                          &info) != 0 ||
+        offset - point->blockRawOffset >= info.rawSize)
+      return -1;
+
+    first = (unsigned long)(offset - point->blockRawOffset);
+    part = info.rawSize - first;
+    if (part > size)
+      part = size;
+
+    switch (info.type)
+    {
+    case HUFF_BLOCK_HUFFMAN:
+      if (decodeFromPoint(work, body, &info, point, offset, out, part) != 0)
+        return -1;
+      break;
+    case HUFF_BLOCK_STREAMS:
+      if (decodeStreamsRange(work, body, &info, first, out, part) != 0)
+        return -1;
+      break;
+    case HUFF_BLOCK_STORED:
+      if (info.compressedSize != info.rawSize)
+        return -1;
+      memcpy(out, body + first, part);
+      break;
+    case HUFF_BLOCK_RLE:
+      if (info.compressedSize != 1)
+        return -1;
+      memset(out, body[0], part);
+      break;
+    default:
+      return -1;
+    }
+
+    offset += part;
+    out += part;
+    size -= part;
+  }
+  return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Algoritmo de Codificação de Huffman - Gerador de tabelas constantes
+ *
+ * Descrição:
+ * Ferramenta de host que monta o histograma de um corpus representativo e
+ * gera um header com as tabelas de codificação e decodificação como const,
+ * para ficarem na flash. Na placa a compressão vira um laço de consulta à
+ * tabela (huffmanEncodeBuffer ou huffmanEncodeUpdate) e a descompressão usa
+ * huffmanDecodeUpdate, sem buildHuffmanTree, generateCodes nem a RAM dos
+ * nós: basta compilar huffman_encode.c e huffman_decode.c, sem huffman.c.
+ *
+ * Todo símbolo do alfabeto recebe ao menos frequência 1, de modo que dados
+ * que fujam do corpus ainda podem ser codificados (com códigos longos).
+ *
+ * Uso (compilar com o perfil do firmware):
+ * gcc -DHUFF_PROFILE=STM32F030 huffman_gen.c huffman.c huffman_encode.c huffman_decode.c -o huffman_gen
+ * ./huffman_gen telemetria corpus1.txt corpus2.txt > telemetria_tables.h
+ *
+ * O header gerado define telemetria_codes (struct HuffmanCodeTable) e
+ * telemetria_decode (struct HuffmanDecodeTable) como static const e deve
+ * ser incluído em um único arquivo .c.
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include "huffman.h"
+
+static unsigned freq[HUFF_ALPHABET_SIZE];
+static struct HuffmanCodeTable codes;
+static struct HuffmanDecodeTable decodeTable;
+static struct HuffmanTreeWork tree;
+static char buffer[0x4000];
+
+// Acrescenta o conteúdo de um arquivo ao histograma; -1 em caso de erro
+static int addCorpus(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  int size;
+
+  if (file == NULL)
+  {
+    fprintf(stderr, "Nao foi possivel abrir %s\n", path);
+    return -1;
+  }
+
+  while ((size = (int)fread(buffer, 1, sizeof(buffer), file)) > 0)
+  {
+    if (calculateFrequencyInChunks(buffer, freq, size, size) != 0)
+    {
+      fprintf(stderr, "%s tem simbolos fora do alfabeto do perfil (%d)\n", path,
+              HUFF_ALPHABET_SIZE);
+      fclose(file);
+      return -1;
+    }
+  }
+  fclose(file);
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *name;
+
+  if (argc < 3)
+  {
+    fprintf(stderr, "Uso: %s <nome> <corpus>...\n", argv[0]);
+    return 1;
+  }
+  name = argv[1];
+
+  for (int i = 2; i < argc; ++i)
+  {
+    if (addCorpus(argv[i]) != 0)
+      return 1;
+  }
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (freq[i] < 0xFFFFFFFFu)
+      freq[i]++;
+  }
+
+  buildCodeTable(&tree, freq, &codes);
+  if (buildDecodeTable(&codes, &decodeTable) != 0)
+  {
+    fprintf(stderr, "Tabela de decodificacao invalida\n");
+    return 1;
+  }
+
+  printf("/* Gerado por huffman_gen: alfabeto de %d simbolos, codigo maximo de "
+         "%d bits */\n",
+         HUFF_ALPHABET_SIZE, HUFF_MAX_CODE_LEN);
+  printf("#ifndef ");
+  for (const char *p = name; *p; ++p)
+    putchar(toupper((unsigned char)*p));
+  printf("_TABLES_H\n#define ");
+  for (const char *p = name; *p; ++p)
+    putchar(toupper((unsigned char)*p));
+  printf("_TABLES_H\n\n#include \"huffman.h\"\n\n");
+
+  printf("static const struct HuffmanCodeTable %s_codes = {\n    {", name);
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    printf("%s0x%04X%s", i % 8 == 0 ? "\n        " : " ", codes.bits[i],
+           i + 1 < HUFF_ALPHABET_SIZE ? "," : "");
+  printf("},\n    {");
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    printf("%s%2d%s", i % 16 == 0 ? "\n        " : " ", codes.len[i],
+           i + 1 < HUFF_ALPHABET_SIZE ? "," : "");
+  printf("}};\n\n");
+
+  printf("static const struct HuffmanDecodeTable %s_decode = {{", name);
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    printf("%s{0x%04X, 0x%04X}%s", i % 4 == 0 ? "\n    " : " ",
+           decodeTable.child[i][0], decodeTable.child[i][1],
+           i + 1 < HUFF_ALPHABET_SIZE ? "," : "");
+  printf("}};\n\n#endif\n");
+
+  return 0;
+}
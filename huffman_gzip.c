@@ -0,0 +1,74 @@
+/*
+ * Algoritmo de Codificação de Huffman - Compressor gzip
+ *
+ * Descrição:
+ * Ferramenta de host que comprime um arquivo no formato gzip com
+ * huffmanGzipEncode, para entregar a ferramentas que já leem gzip (gzip -d,
+ * zcat, zlib) sem descomprimir e recomprimir.
+ *
+ * Uso:
+ * gcc -O2 huffman_gzip.c huffman.c huffman_encode.c huffman_decode.c huffman_frame.c huffman_frame_decode.c huffman_cpu.c huffman_bitio.c huffman_coder.c huffman_lz.c huffman_deflate.c -o huffman_gzip
+ * ./huffman_gzip telemetria.txt 3 > telemetria.txt.gz
+ * gzip -t telemetria.txt.gz
+ *
+ * O nível vai de 0 (só literais) a 3 (HUFF_LZ_BEST); o padrão é 2.
+ */
+#include <stdio.h>
+#include "huffman_deflate.h"
+
+#define MAX_INPUT (16 * 1024 * 1024)
+
+// O dígito da linha de comando é o próprio nível
+_Static_assert(HUFF_DEFLATE_LITERALS == 0 && HUFF_LZ_FAST == 1 &&
+                   HUFF_LZ_DEFAULT == 2 && HUFF_LZ_BEST == 3,
+               "Os niveis 0-3 da linha de comando mudaram de valor");
+
+static char input[MAX_INPUT];
+static unsigned char output[MAX_INPUT + MAX_INPUT / 1024 + 1024];
+static struct HuffmanDeflateWork work;
+
+int main(int argc, char *argv[])
+{
+  FILE *file;
+  unsigned long size;
+  long written;
+  int level = HUFF_LZ_DEFAULT;
+
+  // O nível é um só dígito de 0 a 3: atoi leria "x" como 0, e o
+  // codificador recusaria "9" só depois de ler o arquivo
+  if ((argc != 2 && argc != 3) ||
+      (argc == 3 && (argv[2][0] < '0' || argv[2][0] > '3' || argv[2][1] != '\0')))
+  {
+    fprintf(stderr, "Uso: %s <arquivo> [nivel 0-3] > arquivo.gz\n", argv[0]);
+    return 1;
+  }
+  if (argc == 3)
+    level = argv[2][0] - '0';
+
+  file = fopen(argv[1], "rb");
+  if (file == NULL)
+  {
+    fprintf(stderr, "Nao foi possivel abrir %s\n", argv[1]);
+    return 1;
+  }
+  size = (unsigned long)fread(input, 1, MAX_INPUT, file);
+  if (fgetc(file) != EOF)
+  {
+    fprintf(stderr, "%s passa de %d bytes\n", argv[1], MAX_INPUT);
+    fclose(file);
+    return 1;
+  }
+  fclose(file);
+
+  // output comporta huffmanDeflateBound(MAX_INPUT) + HUFF_GZIP_OVERHEAD
+  written = huffmanGzipEncode(&work, input, size, output, sizeof(output), level);
+  if (written < 0 || fwrite(output, 1, (size_t)written, stdout) !=
+                         (size_t)written)
+  {
+    fprintf(stderr, "Falha ao gravar a saida\n");
+    return 1;
+  }
+
+  fprintf(stderr, "%s: %lu -> %ld bytes\n", argv[1], size, written);
+  return 0;
+}
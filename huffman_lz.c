@@ -0,0 +1,496 @@
+/*
+ * Algoritmo de Codificação de Huffman - LZ77 + Huffman
+ *
+ * Descrição:
+ * Encontra cópias com cadeias de hash sobre os 4 primeiros bytes de cada
+ * posição (a cadeia liga as posições anteriores com o mesmo hash, dentro da
+ * janela), divide a entrada em sequências (literais + cópia) e codifica
+ * literais, corridas, comprimentos e distâncias com quatro tabelas de
+ * Huffman. Ver huffman_lz.h.
+ */
+#include <string.h>
+#include "huffman_lz.h"
+#include "huffman_coder.h"
+
+#define LZ_CODES 48    // Códigos de valor: até 2^20 (HUFF_LZ_MAX_BLOCK)
+
+#if LZ_CODES > HUFF_ALPHABET_SIZE
+#error "Os códigos de valor precisam caber no alfabeto do perfil"
+#endif
+
+// Tabelas de um bloco, na ordem em que são gravadas
+#define LZ_LITERALS 0
+#define LZ_RUNS 1
+#define LZ_LENGTHS 2
+#define LZ_DISTANCES 3
+
+// Parâmetros de cada nível (HUFF_LZ_FAST a HUFF_LZ_BEST)
+static const struct
+{
+  unsigned chain;     // Posições visitadas por busca
+  unsigned long nice; // Cópia longa o bastante para encerrar a busca
+  int lazy;           // 1 para adiar a decisão em uma posição
+} levels[] = {
+    {4, 32, 0},
+    {32, 128, 1},
+    {1024, 1024, 1},
+};
+
+// Hash dos 4 bytes a partir de p
+static unsigned hash4(const unsigned char *p)
+{
+  unsigned long v = (unsigned long)p[0] | (unsigned long)p[1] << 8 |
+                    (unsigned long)p[2] << 16 | (unsigned long)p[3] << 24;
+
+  return (unsigned)(((v * 2654435761ul) & 0xFFFFFFFFul) >>
+                    (32 - HUFF_LZ_HASH_BITS));
+}
+
+// Insere nas cadeias as posições de *next até pos (exclusive)
+static void insertUpTo(struct HuffmanLzMatchWork *work,
+                       const unsigned char *in, unsigned long end,
+                       unsigned long *next, unsigned long pos)
+{
+  for (; *next < pos && *next + HUFF_LZ_MIN_MATCH <= end; ++*next)
+  {
+    unsigned h = hash4(in + *next);
+    work->chain[*next & (HUFF_LZ_WINDOW - 1)] = work->head[h];
+    work->head[h] = (unsigned)(*next + 1);
+  }
+}
+
+// Limites das cópias e parâmetros da busca de huffmanLzParse
+struct LzSearch
+{
+  unsigned long end;       // Fim da entrada
+  unsigned long window;    // Distância máxima + 1
+  unsigned long maxLength; // Maior cópia
+  int level;               // Índice em levels
+};
+
+/**
+ * Procura a cópia mais longa para pos, percorrendo a cadeia do seu hash.
+ * Todas as posições anteriores a pos já devem estar nas cadeias.
+ *
+ * @param distance Recebe a distância da cópia encontrada.
+ * @return Comprimento da cópia, ou 0 se não houver uma de ao menos
+ *         HUFF_LZ_MIN_MATCH bytes.
+ */
+static unsigned long findMatch(const struct HuffmanLzMatchWork *work,
+                               const unsigned char *in,
+                               const struct LzSearch *search,
+                               unsigned long pos, unsigned long *distance)
+{
+  unsigned long limit = search->end - pos < search->maxLength
+                            ? search->end - pos
+                            : search->maxLength;
+  unsigned long best = HUFF_LZ_MIN_MATCH - 1;
+  unsigned steps = levels[search->level].chain;
+  unsigned candidate;
+
+  if (limit < HUFF_LZ_MIN_MATCH)
+    return 0;
+  candidate = work->head[hash4(in + pos)];
+  while (candidate != 0 && steps-- > 0)
+  {
+    unsigned long match = candidate - 1;
+
+    // As cadeias só são confiáveis dentro da janela
+    if (pos - match >= search->window)
+      break;
+
+    // Só vale comparar se a candidata puder passar da melhor até agora
+    if (in[match + best] == in[pos + best])
+    {
+      unsigned long length = 0;
+      while (length < limit && in[match + length] == in[pos + length])
+        length++;
+      if (length > best)
+      {
+        best = length;
+        *distance = pos - match;
+        if (length >= levels[search->level].nice || length == limit)
+          break;
+      }
+    }
+    candidate = work->chain[match & (HUFF_LZ_WINDOW - 1)];
+  }
+  return best >= HUFF_LZ_MIN_MATCH ? best : 0;
+}
+
+unsigned long huffmanLzParse(struct HuffmanLzMatchWork *work, const char *in,
+                            unsigned long start, unsigned long end, int level,
+                            unsigned long window, unsigned long maxLength,
+                            struct HuffmanLzSequence sequences[])
+{
+  const unsigned char *data = (const unsigned char *)in;
+  struct LzSearch search = {end, window, maxLength, level - HUFF_LZ_FAST};
+  unsigned long next;
+  unsigned long pos = start;
+  unsigned long literalStart = start;
+  unsigned long count = 0;
+
+  if (search.window > HUFF_LZ_WINDOW)
+    search.window = HUFF_LZ_WINDOW;
+  if (search.maxLength > HUFF_LZ_MAX_MATCH)
+    search.maxLength = HUFF_LZ_MAX_MATCH;
+  if (search.level < 0 || search.level > HUFF_LZ_BEST - HUFF_LZ_FAST)
+    search.level = HUFF_LZ_DEFAULT - HUFF_LZ_FAST;
+
+  // O histórico antes de start entra nas cadeias sem gerar sequências
+  next = start - (start < search.window ? start : search.window - 1);
+  memset(work->head, 0, sizeof(work->head));
+  while (pos + HUFF_LZ_MIN_MATCH <= end)
+  {
+    unsigned long distance = 0;
+    unsigned long length;
+
+    insertUpTo(work, data, end, &next, pos);
+    length = findMatch(work, data, &search, pos, &distance);
+    if (length == 0)
+    {
+      pos++;
+      continue;
+    }
+
+    // Lazy: se a cópia da posição seguinte for mais longa, pos vira literal
+    while (levels[search.level].lazy &&
+           length < levels[search.level].nice &&
+           pos + 1 + HUFF_LZ_MIN_MATCH <= end)
+    {
+      unsigned long nextDistance = 0;
+      unsigned long nextLength;
+
+      insertUpTo(work, data, end, &next, pos + 1);
+      nextLength = findMatch(work, data, &search, pos + 1, &nextDistance);
+      if (nextLength <= length)
+        break;
+      pos++;
+      length = nextLength;
+      distance = nextDistance;
+    }
+
+    sequences[count].run = (unsigned)(pos - literalStart);
+    sequences[count].length = (unsigned short)(length - HUFF_LZ_MIN_MATCH);
+    sequences[count].distance = (unsigned short)(distance - 1);
+    count++;
+    pos += length;
+    literalStart = pos;
+  }
+  return count;
+}
+
+/**
+ * Reduz um valor a código e bits extras (ver huffman_lz.h).
+ *
+ * @param extra Recebe a quantidade de bits extras.
+ * @return Código do valor.
+ */
+static int valueCode(unsigned long value, int *extra)
+{
+  int n = 4;
+
+  if (value < 16)
+  {
+    *extra = 0;
+    return (int)value;
+  }
+  while ((value >> (n + 1)) != 0)
+    n++;
+  *extra = n - 1;
+  return 16 + 2 * (n - 4) + (int)((value >> (n - 1)) & 1);
+}
+
+// Conta o código de value na tabela t; retorna os bits extras
+static int countValue(struct HuffmanLzWork *work, int t, unsigned long value)
+{
+  int extra;
+
+  work->freq[t][valueCode(value, &extra)]++;
+  return extra;
+}
+
+// Grava o código de value com a tabela table, seguido dos bits extras
+static void putValue(struct HuffmanBitWriter *writer,
+                     const struct HuffmanCodeTable *table, unsigned long value)
+{
+  int extra;
+  int code = valueCode(value, &extra);
+
+  huffmanPutBits(writer, table->bits[code], table->len[code]);
+  if (extra > 0)
+    huffmanPutBits(writer, (unsigned)(value & ((1ul << extra) - 1)), extra);
+}
+
+static void putLiterals(struct HuffmanBitWriter *writer,
+                        const struct HuffmanCodeTable *table,
+                        const unsigned char *in, unsigned long count)
+{
+  for (unsigned long i = 0; i < count; ++i)
+    huffmanPutBits(writer, table->bits[in[i]], table->len[in[i]]);
+}
+
+// Símbolos gravados na tabela: até o último com código
+static int tableSymbols(const struct HuffmanCodeTable *table)
+{
+  int symbols = 1;
+
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+  {
+    if (table->len[i] != 0)
+      symbols = i + 1;
+  }
+  return symbols;
+}
+
+// Grava o byte n e os comprimentos da tabela; retorna os bytes gravados
+static unsigned long writeTable(unsigned char *p,
+                                const struct HuffmanCodeTable *table)
+{
+  int symbols = tableSymbols(table);
+
+  p[0] = (unsigned char)symbols; // 256 vira 0
+  huffmanWriteNibbles(p + 1, table->len, symbols);
+  return 1 + (unsigned long)(symbols + 1) / 2;
+}
+
+long huffmanLzEncode(struct HuffmanLzWork *work, const char *in,
+                     unsigned long size, unsigned char *out,
+                     unsigned long outSize, int flags, int level)
+{
+  unsigned (*freq)[HUFF_ALPHABET_SIZE] = work->freq;
+  struct HuffmanCodeTable *codes = work->codes;
+  struct HuffmanLzSequence *sequences = work->sequences;
+  const unsigned char *data = (const unsigned char *)in;
+  unsigned long reserved =
+      HUFF_BLOCK_HEADER_SIZE + (flags & HUFF_BLOCK_FLAG_CRC ? HUFF_BLOCK_CRC_SIZE : 0);
+  unsigned char *body = out + HUFF_BLOCK_HEADER_SIZE;
+  unsigned long long bits = 0;
+  unsigned long headerSize = 4;
+  unsigned long count;
+  unsigned long pos = 0;
+  int distinct = 0;
+
+  flags &= HUFF_BLOCK_FLAG_CRC;
+  if (level < HUFF_LZ_FAST || level > HUFF_LZ_BEST)
+    level = HUFF_LZ_DEFAULT;
+  if (size > HUFF_LZ_MAX_BLOCK)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+
+  // Tamanho do bloco de ordem 0, para a comparação no final
+  memset(work->freq, 0, sizeof(work->freq));
+  if (calculateFrequencyInChunks(in, freq[LZ_LITERALS], (int)size,
+                                 (int)size) != 0)
+    return -1;
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    distinct += freq[LZ_LITERALS][i] != 0;
+  if (distinct <= 1)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+  unsigned long order0Size =
+      huffmanOrder0Size(&work->tree, freq[LZ_LITERALS], &codes[LZ_LITERALS]);
+
+  count = huffmanLzParse(&work->match, in, 0, size, level, HUFF_LZ_WINDOW,
+                         HUFF_LZ_MAX_MATCH, sequences);
+  if (count == 0)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+
+  // Histogramas dos literais e dos códigos; os bits extras já entram na conta
+  memset(work->freq, 0, sizeof(work->freq));
+  for (unsigned long s = 0; s < count; ++s)
+  {
+    const struct HuffmanLzSequence *seq = &sequences[s];
+    for (unsigned long i = 0; i < seq->run; ++i)
+      freq[LZ_LITERALS][data[pos + i]]++;
+    bits += (unsigned long long)countValue(work, LZ_RUNS, seq->run);
+    bits += (unsigned long long)countValue(work, LZ_LENGTHS, seq->length);
+    bits += (unsigned long long)countValue(work, LZ_DISTANCES, seq->distance);
+    pos += seq->run + seq->length + HUFF_LZ_MIN_MATCH;
+  }
+  for (; pos < size; ++pos)
+    freq[LZ_LITERALS][data[pos]]++;
+
+  for (int t = 0; t < HUFF_LZ_TABLES; ++t)
+  {
+    buildCodeTable(&work->tree, freq[t], &codes[t]);
+    bits += huffmanEncodedBits(freq[t], &codes[t]);
+    headerSize += 1 + (unsigned long)(tableSymbols(&codes[t]) + 1) / 2;
+  }
+
+  unsigned long bodySize = headerSize + (unsigned long)((bits + 7) / 8);
+  if (bodySize >= order0Size || bodySize >= size)
+    return huffmanBlockEncode(&work->block, in, size, out, outSize, flags);
+  if (outSize < reserved || outSize - reserved < bodySize)
+    return -1;
+
+  body[0] = (unsigned char)count;
+  body[1] = (unsigned char)(count >> 8);
+  body[2] = (unsigned char)(count >> 16);
+  body[3] = (unsigned char)(count >> 24);
+  unsigned long tablePos = 4;
+  for (int t = 0; t < HUFF_LZ_TABLES; ++t)
+    tablePos += writeTable(body + tablePos, &codes[t]);
+
+  // O espaço já foi conferido: a codificação não verifica limites
+  struct HuffmanBitWriter writer = {body + headerSize, 0, 0};
+  pos = 0;
+  for (unsigned long s = 0; s < count; ++s)
+  {
+    const struct HuffmanLzSequence *seq = &sequences[s];
+    putValue(&writer, &codes[LZ_RUNS], seq->run);
+    putLiterals(&writer, &codes[LZ_LITERALS], data + pos, seq->run);
+    putValue(&writer, &codes[LZ_LENGTHS], seq->length);
+    putValue(&writer, &codes[LZ_DISTANCES], seq->distance);
+    pos += seq->run + seq->length + HUFF_LZ_MIN_MATCH;
+  }
+  putLiterals(&writer, &codes[LZ_LITERALS], data + pos, size - pos);
+  huffmanFlushBits(&writer);
+
+  flags |= (int)((8 - bits % 8) % 8);
+  return huffmanBlockFinish(out, HUFF_BLOCK_LZ, flags, size, bodySize);
+}
+
+/**
+ * Lê a tabela t (byte n e comprimentos) e prepara codes e lookups.
+ *
+ * @param p Início da tabela.
+ * @param available Bytes disponíveis a partir de p.
+ * @return Bytes lidos, ou 0 se a tabela for inválida.
+ */
+static unsigned long readTable(struct HuffmanLzWork *work,
+                               const unsigned char *p, unsigned long available,
+                               int t)
+{
+  int symbols;
+  unsigned long tableSize;
+
+  if (available == 0)
+    return 0;
+  symbols = p[0] ? p[0] : 256;
+  tableSize = 1 + (unsigned long)(symbols + 1) / 2;
+  if (symbols > HUFF_ALPHABET_SIZE || tableSize > available ||
+      huffmanReadLengths(p + 1, symbols, &work->codes[t],
+                         &work->lookups[t]) != 0)
+    return 0;
+  return tableSize;
+}
+
+// Lê um valor (código da tabela lookup e bits extras), ou retorna -1
+static long readValue(struct HuffmanBitReader *reader,
+                      const struct HuffmanLookupTable *lookup)
+{
+  int code = huffmanReadSymbol(reader, lookup);
+
+  if (code < 16)
+    return code;
+  if (code >= LZ_CODES)
+    return -1;
+
+  int n = 4 + (code - 16) / 2;
+  unsigned long value = (unsigned long)(2 | ((code - 16) & 1)) << (n - 1);
+  if (reader->bitCount < n - 1)
+    return -1;
+  reader->bitCount -= n - 1;
+  value |= (unsigned long)(reader->bitBuffer >> reader->bitCount) &
+           ((1ul << (n - 1)) - 1);
+  return (long)value;
+}
+
+// Decodifica count literais em out
+static int readLiterals(struct HuffmanBitReader *reader,
+                        const struct HuffmanLookupTable *lookup, char *out,
+                        unsigned long count)
+{
+  for (unsigned long i = 0; i < count; ++i)
+  {
+    int c = huffmanReadSymbol(reader, lookup);
+    if (c < 0)
+      return -1;
+    out[i] = (char)c;
+  }
+  return 0;
+}
+
+/**
+ * Decodifica o corpo de um bloco HUFF_BLOCK_LZ.
+ *
+ * @param body Início do corpo.
+ * @param info Campos do cabeçalho.
+ * @param out Buffer de saída, com ao menos info->rawSize bytes.
+ * @return 0 em caso de sucesso, -1 se o corpo for inválido.
+ */
+static int decodeLzBody(struct HuffmanLzWork *work, const unsigned char *body,
+                        const struct HuffmanBlockInfo *info, char *out)
+{
+  const struct HuffmanLookupTable *lookups = work->lookups;
+  struct HuffmanBitReader reader = {0};
+  unsigned long headerSize = 4;
+  unsigned long pos = 0;
+  unsigned long count;
+
+  if (info->compressedSize < 4)
+    return -1;
+  count = (unsigned long)body[0] | (unsigned long)body[1] << 8 |
+          (unsigned long)body[2] << 16 | (unsigned long)body[3] << 24;
+  if (count > info->rawSize / HUFF_LZ_MIN_MATCH)
+    return -1;
+  for (int t = 0; t < HUFF_LZ_TABLES; ++t)
+  {
+    unsigned long tableSize = readTable(work, body + headerSize,
+                                        info->compressedSize - headerSize, t);
+    if (tableSize == 0)
+      return -1;
+    headerSize += tableSize;
+  }
+
+  reader.in = body + headerSize;
+  reader.size = info->compressedSize - headerSize;
+  for (unsigned long s = 0; s < count; ++s)
+  {
+    long run = readValue(&reader, &lookups[LZ_RUNS]);
+    if (run < 0 || (unsigned long)run > info->rawSize - pos ||
+        readLiterals(&reader, &lookups[LZ_LITERALS], out + pos,
+                     (unsigned long)run) != 0)
+      return -1;
+    pos += (unsigned long)run;
+
+    long length = readValue(&reader, &lookups[LZ_LENGTHS]);
+    long distance = readValue(&reader, &lookups[LZ_DISTANCES]);
+    if (length < 0 || distance < 0 ||
+        (unsigned long)length + HUFF_LZ_MIN_MATCH > info->rawSize - pos ||
+        (unsigned long)distance + 1 > pos)
+      return -1;
+    length += HUFF_LZ_MIN_MATCH;
+    distance += 1;
+
+    // Cópias sobrepostas (distância menor que o comprimento) repetem o trecho
+    if (distance >= length)
+      memcpy(out + pos, out + pos - distance, (size_t)length);
+    else
+    {
+      for (long i = 0; i < length; ++i)
+        out[pos + (unsigned long)i] = out[pos + (unsigned long)i - (unsigned long)distance];
+    }
+    pos += (unsigned long)length;
+  }
+  if (readLiterals(&reader, &lookups[LZ_LITERALS], out + pos,
+                   info->rawSize - pos) != 0)
+    return -1;
+
+  return huffmanCheckPadding(&reader, info);
+}
+
+long huffmanLzDecode(struct HuffmanLzWork *work, const unsigned char *in,
+                     unsigned long size, char *out, unsigned long outSize)
+{
+  struct HuffmanBlockInfo info;
+
+  if (huffmanBlockParse(in, size, &info) != 0)
+    return -1;
+  if (info.type != HUFF_BLOCK_LZ)
+    return huffmanBlockDecode(&work->decode, in, size, out, outSize);
+
+  if (huffmanBlockVerify(in, &info) != 0 || info.rawSize > outSize ||
+      decodeLzBody(work, in + HUFF_BLOCK_HEADER_SIZE, &info, out) != 0)
+    return -1;
+  return (long)info.rawSize;
+}
@@ -0,0 +1,149 @@
+/*
+ * Algoritmo de Codificação de Huffman - LZ77 + Huffman
+ *
+ * Descrição:
+ * O Huffman de ordem 0 não passa da entropia de cada byte isolado, e em logs
+ * repetitivos a maior parte da redundância está em linhas e campos que se
+ * repetem. Este módulo procura essas repetições com cadeias de hash (LZ77)
+ * e gera blocos em que literais, comprimentos e distâncias são codificados
+ * com tabelas de Huffman.
+ *
+ * A entrada vira uma lista de sequências: uma corrida de literais seguida de
+ * uma cópia (comprimento, distância) de dados já decodificados. Os literais
+ * que sobram depois da última cópia não formam sequência. Corridas,
+ * comprimentos e distâncias são reduzidos a um código e bits extras, para
+ * que cada tabela caiba no alfabeto do perfil: valores abaixo de 16 são o
+ * próprio código; acima disso, o código 16 + 2 * (n - 4) + m indica o bit
+ * mais alto n do valor e o bit seguinte m, e os n - 1 bits restantes vão
+ * como extras. O comprimento é gravado menos HUFF_LZ_MIN_MATCH, e a
+ * distância menos 1.
+ *
+ * Corpo de um bloco HUFF_BLOCK_LZ: 4 bytes (little-endian) com a quantidade
+ * de sequências, as tabelas de comprimentos dos literais, das corridas, dos
+ * comprimentos e das distâncias (cada uma com o byte n, como em
+ * HUFF_BLOCK_HUFFMAN) e um único fluxo de bits. Cada sequência é gravada
+ * como código e extras da corrida, os literais, código e extras do
+ * comprimento e código e extras da distância; os extras vão logo após o
+ * código, o bit mais significativo primeiro. Os literais finais vêm por
+ * último, sem contagem: são os que faltam para o tamanho original.
+ *
+ * Níveis: cada busca visita até um número fixo de posições da cadeia e
+ * fica com a cópia mais longa, parando antes se achar uma longa o bastante.
+ * HUFF_LZ_FAST visita 4 posições (para em 32 bytes) e grava a cópia achada
+ * logo (greedy); HUFF_LZ_DEFAULT (32 posições, para em 128 bytes) e
+ * HUFF_LZ_BEST (1024 posições e bytes) adiam a decisão em uma posição
+ * (lazy), se a cópia seguinte for maior.
+ *
+ * As cadeias de hash e as sequências ocupam cerca de 2,5 MB, numa
+ * HuffmanLzWork do chamador: o módulo é para o host, como huffman_context.c.
+ */
+#ifndef HUFFMAN_LZ_H
+#define HUFFMAN_LZ_H
+
+#include "huffman_coder.h"
+
+#define HUFF_BLOCK_LZ 6 // Sequências LZ77 com literais e cópias em Huffman
+
+#define HUFF_LZ_WINDOW (1ul << 16)    // Janela: distância máxima + 1
+#define HUFF_LZ_MIN_MATCH 4           // Menor cópia (bytes comparados no hash)
+#define HUFF_LZ_MAX_MATCH 65539ul     // Maior cópia (comprimento - 4 em 16 bits)
+#define HUFF_LZ_MAX_BLOCK (1ul << 20) // Maior entrada de um bloco LZ
+#define HUFF_LZ_HASH_BITS 15          // Entradas das cabeças de cadeia: 2^15
+#define HUFF_LZ_TABLES 4 // Literais, corridas, comprimentos e distâncias
+#define HUFF_LZ_MAX_SEQUENCES (HUFF_LZ_MAX_BLOCK / HUFF_LZ_MIN_MATCH)
+
+// Níveis de huffmanLzEncode
+#define HUFF_LZ_FAST 1    // Greedy, cadeias curtas
+#define HUFF_LZ_DEFAULT 2 // Lazy
+#define HUFF_LZ_BEST 3    // Lazy, cadeias longas
+
+// Sequência LZ77: run literais seguidos de uma cópia
+struct HuffmanLzSequence
+{
+  unsigned run;            // Literais antes da cópia
+  unsigned short length;   // Comprimento - HUFF_LZ_MIN_MATCH
+  unsigned short distance; // Distância - 1
+};
+
+// Cadeias de hash de huffmanLzParse
+struct HuffmanLzMatchWork
+{
+  unsigned head[1 << HUFF_LZ_HASH_BITS]; // Última posição + 1 (0 = nenhuma)
+  unsigned chain[HUFF_LZ_WINDOW];        // Anterior + 1 com o mesmo hash
+};
+
+// Memória de trabalho de huffmanLzEncode e huffmanLzDecode. Grande demais
+// para a pilha: aloque com calloc (ou como estática do programa), zerada, e
+// use uma por thread.
+struct HuffmanLzWork
+{
+  struct HuffmanLzSequence sequences[HUFF_LZ_MAX_SEQUENCES];
+  unsigned freq[HUFF_LZ_TABLES][HUFF_ALPHABET_SIZE];
+  struct HuffmanCodeTable codes[HUFF_LZ_TABLES];
+  struct HuffmanLookupTable lookups[HUFF_LZ_TABLES];
+  struct HuffmanLzMatchWork match;
+  struct HuffmanTreeWork tree;
+  // Blocos de huffman_frame.c, quando as cópias não compensam
+  struct HuffmanBlockEncodeWork block;
+  struct HuffmanBlockDecodeWork decode;
+};
+
+/**
+ * Divide in[start, end) em sequências LZ77. Os bytes anteriores a start (até
+ * window deles) servem só de histórico para as cópias, o que permite
+ * processar uma entrada longa em partes sem perder as repetições entre elas.
+ * Os literais depois da última cópia não formam sequência.
+ *
+ * @param work Cadeias de hash.
+ * @param in Dados de entrada (histórico incluso).
+ * @param start Primeira posição a dividir.
+ * @param end Fim da entrada.
+ * @param level HUFF_LZ_FAST, HUFF_LZ_DEFAULT ou HUFF_LZ_BEST.
+ * @param window Distância máxima + 1 (no máximo HUFF_LZ_WINDOW).
+ * @param maxLength Maior cópia (no máximo HUFF_LZ_MAX_MATCH).
+ * @param sequences Recebe as sequências, com espaço para ao menos
+ *                  (end - start) / HUFF_LZ_MIN_MATCH delas.
+ * @return Quantidade de sequências.
+ */
+unsigned long huffmanLzParse(struct HuffmanLzMatchWork *work, const char *in,
+                            unsigned long start, unsigned long end, int level,
+                            unsigned long window, unsigned long maxLength,
+                            struct HuffmanLzSequence sequences[]);
+
+/**
+ * Comprime a entrada em um bloco HUFF_BLOCK_LZ. Se a entrada passar de
+ * HUFF_LZ_MAX_BLOCK ou as cópias não deixarem o bloco menor que o de ordem
+ * 0, gera o bloco de huffmanBlockEncode.
+ *
+ * @param work Memória de trabalho.
+ * @param in Dados de entrada.
+ * @param size Tamanho dos dados de entrada.
+ * @param out Buffer de saída, com ao menos huffmanBlockBound(size) bytes
+ *            para nunca falhar.
+ * @param outSize Capacidade do buffer de saída.
+ * @param flags HUFF_BLOCK_FLAG_CRC para acrescentar o CRC32C, ou 0.
+ * @param level HUFF_LZ_FAST, HUFF_LZ_DEFAULT ou HUFF_LZ_BEST.
+ * @return Tamanho do bloco, ou -1 se não couber em out ou se algum
+ *         caractere estiver fora do alfabeto.
+ */
+long huffmanLzEncode(struct HuffmanLzWork *work, const char *in,
+                     unsigned long size, unsigned char *out,
+                     unsigned long outSize, int flags, int level);
+
+/**
+ * Decodifica um bloco HUFF_BLOCK_LZ, conferindo o CRC32C se presente. Os
+ * tipos de huffman_frame.c, que huffmanLzEncode gera quando as cópias não
+ * compensam, são repassados a huffmanBlockDecode; os demais são recusados
+ * (ver huffmanDecodeAnyBlock).
+ *
+ * @param work Memória de trabalho.
+ * @param in Início do bloco.
+ * @param size Bytes disponíveis a partir de in.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @return Tamanho original, ou -1 se o bloco for inválido ou não couber em out.
+ */
+long huffmanLzDecode(struct HuffmanLzWork *work, const unsigned char *in,
+                     unsigned long size, char *out, unsigned long outSize);
+
+#endif
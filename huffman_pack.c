@@ -0,0 +1,76 @@
+/*
+ * Algoritmo de Codificação de Huffman - Gerador de recursos comprimidos
+ *
+ * Descrição:
+ * Ferramenta de host que comprime um arquivo em tempo de compilação e gera
+ * um .c com o bloco comprimido (tabela canônica com comprimento limitado +
+ * dados) e um struct HuffmanAsset para descompressão na placa com
+ * huffmanAssetUnpack (ver huffman_asset.h).
+ *
+ * Uso (compilar com o perfil do firmware):
+ * gcc -DHUFF_PROFILE=STM32F030 huffman_pack.c huffman.c huffman_encode.c huffman_decode.c huffman_frame.c huffman_frame_decode.c huffman_cpu.c huffman_bitio.c -o huffman_pack
+ * ./huffman_pack texto.txt texto > texto_asset.c
+ *
+ * O .c gerado define texto_data[] e texto (struct HuffmanAsset) e deve ser
+ * compilado junto com huffman_asset.c, huffman_frame_decode.c e huffman_decode.c
+ * (ver README).
+ */
+#include <stdio.h>
+#include "huffman_frame.h"
+
+#define MAX_INPUT (1024 * 1024)
+
+static char input[MAX_INPUT];
+static unsigned char block[HUFF_BLOCK_HEADER_SIZE + MAX_INPUT + HUFF_BLOCK_CRC_SIZE];
+static struct HuffmanBlockEncodeWork work;
+
+int main(int argc, char *argv[])
+{
+  FILE *file;
+  unsigned long size;
+  long blockSize;
+
+  if (argc != 3)
+  {
+    fprintf(stderr, "Uso: %s <arquivo> <nome>\n", argv[0]);
+    return 1;
+  }
+
+  file = fopen(argv[1], "rb");
+  if (file == NULL)
+  {
+    fprintf(stderr, "Nao foi possivel abrir %s\n", argv[1]);
+    return 1;
+  }
+  size = (unsigned long)fread(input, 1, MAX_INPUT, file);
+  if (fgetc(file) != EOF)
+  {
+    fprintf(stderr, "%s passa de %d bytes\n", argv[1], MAX_INPUT);
+    fclose(file);
+    return 1;
+  }
+  fclose(file);
+
+  // Sem CRC: a flash já é verificada na gravação
+  blockSize = huffmanBlockEncode(&work, input, size, block, sizeof(block), 0);
+  if (blockSize < 0)
+  {
+    fprintf(stderr, "%s tem simbolos fora do alfabeto do perfil (%d)\n",
+            argv[1], HUFF_ALPHABET_SIZE);
+    return 1;
+  }
+
+  printf("/* Gerado por huffman_pack a partir de %s: %lu -> %ld bytes */\n",
+         argv[1], size, blockSize);
+  printf("#include \"huffman_asset.h\"\n\n");
+  printf("static const unsigned char %s_data[%ld] = {", argv[2], blockSize);
+  for (long i = 0; i < blockSize; ++i)
+    printf("%s0x%02X%s", i % 12 == 0 ? "\n    " : "", block[i],
+           i + 1 < blockSize ? "," : "");
+  printf("};\n\n");
+  printf("const struct HuffmanAsset %s = {%s_data, %ld, %lu};\n", argv[2],
+         argv[2], blockSize, size);
+
+  fprintf(stderr, "%s: %lu -> %ld bytes\n", argv[2], size, blockSize);
+  return 0;
+}
@@ -22,7 +22,8 @@
  * Livre para uso e modificação com atribuição ao autor.
  *
  * Uso:
- * Compile o código usando um compilador C direcionado ao STM32F030.
+ * Compile o código junto com os módulos huffman*.c (ver README) usando um
+ * compilador C direcionado ao STM32F030 (perfil de RAM em huffman_config.h).
  * Personalize os dados de entrada e execute o programa para observar a saída.
  *
  * Histórico de Modificações:
@@ -67,404 +68,25 @@
  * --  Autor: Enzo Girão de Cerqueira
  * --  Motivo: Reduzido MAX_CHAR para 128.
  * -------------------------------------------------------------
+ * --  #9.
+ * --  Data: 16 de Out, 2026
+ * --  Motivo: Desempate determinístico no heap (frequência, símbolo e
+ * --          profundidade), como descrito em #2.
+ * -------------------------------------------------------------
+ * --  #10.
+ * --  Data: 16 de Out, 2026
+ * --  Motivo: Núcleo do codificador movido para huffman.c, com arrays
+ * --          dimensionados pelo perfil de RAM de huffman_config.h.
+ * -------------------------------------------------------------
  */
 #include <stdio.h>
-#include <string.h>
 //#include <windows.h>
 //#include <psapi.h>
 #include <time.h>
+#include "huffman.h"
 
-#define MAX_TREE_HT 100
-#define MAX_CHAR 128
-#define EOF_CHAR '\0'
 #define SIZE 8000
 
-// Um nó na árvore de Huffman
-struct MinHeapNode
-{
-  char data;                 // Caractere armazenado neste nó
-  unsigned freq;             // Frequência do caractere
-  struct MinHeapNode *left;  // Ponteiro para o filho esquerdo
-  struct MinHeapNode *right; // Ponteiro para o filho direito
-};
-
-// Um MinHeap para armazenar ponteiros para MinHeapNode
-struct MinHeap
-{
-  unsigned size;                       // Número atual de elementos no heap
-  unsigned capacity;                   // Capacidade máxima do heap
-  struct MinHeapNode *array[MAX_CHAR]; // Array de ponteiros para MinHeapNode
-};
-
-// Array estático para nós (otimização de memória)
-static struct MinHeapNode nodes[MAX_CHAR];
-static int nodeIndex = 0; // Rastrea o próximo índice de nó livre
-
-// Variáveis globais para frequências de caracteres e códigos
-static int freq[MAX_CHAR] = {0};
-static char uniqueData[MAX_CHAR];
-static int uniqueFreq[MAX_CHAR];
-static char codes[MAX_CHAR][MAX_TREE_HT] = {{0}};
-static char compressed[MAX_TREE_HT * MAX_CHAR] = {0};
-static struct MinHeapNode *stack[MAX_TREE_HT];
-static int arr[MAX_TREE_HT];
-static int visited[MAX_TREE_HT] = {0};
-static char padded_data[MAX_TREE_HT * MAX_CHAR] = {0};
-static char output[MAX_TREE_HT * MAX_CHAR / 8] = {0};
-
-/**
- * Aloca um novo MinHeapNode.
- *
- * @param data Caractere para o nó.
- * @param freq Frequência do caractere.
- * @return Ponteiro para o novo nó.
- */
-struct MinHeapNode *newNode(char data, unsigned freq)
-{
-  struct MinHeapNode *temp = &nodes[nodeIndex++];
-  temp->left = temp->right = NULL;
-  temp->data = data;
-  temp->freq = freq;
-  return temp;
-}
-
-/**
- * Cria e inicializa um MinHeap.
- *
- * @param minHeap Ponteiro para a estrutura MinHeap.
- * @param capacity Capacidade máxima do heap.
- */
-void createMinHeap(struct MinHeap *minHeap, unsigned capacity)
-{
-  minHeap->size = 0;
-  minHeap->capacity = capacity;
-}
-
-// Função utilitária para trocar dois nós de min heap
-void swapMinHeapNode(struct MinHeapNode **a, struct MinHeapNode **b)
-{
-  struct MinHeapNode *t = *a;
-  *a = *b;
-  *b = t;
-}
-
-/**
- * Função MinHeapify para manter a propriedade do heap.
- *
- * @param minHeap Ponteiro para a estrutura MinHeap.
- * @param idx Índice do nó atual para aplicar heapify.
- */
-void minHeapify(struct MinHeap *minHeap, int idx)
-{
-  int smallest = idx;
-  int left = 2 * idx + 1;
-  int right = 2 * idx + 2;
-
-  if (left < (int)minHeap->size &&
-      minHeap->array[left]->freq < minHeap->array[smallest]->freq)
-    smallest = left;
-
-  if (right < (int)minHeap->size &&
-      minHeap->array[right]->freq < minHeap->array[smallest]->freq)
-    smallest = right;
-
-  if (smallest != idx)
-  {
-    swapMinHeapNode(&minHeap->array[smallest], &minHeap->array[idx]);
-    minHeapify(minHeap, smallest);
-  }
-}
-
-/**
- * Verifica se o tamanho do MinHeap é um.
- *
- * @param minHeap Ponteiro para a estrutura MinHeap.
- * @return 1 se o tamanho for um, 0 caso contrário.
- */
-int isSizeOne(struct MinHeap *minHeap) { return (minHeap->size == 1); }
-
-/**
- * Extrai o nó com a frequência mínima do heap.
- *
- * @param minHeap Ponteiro para a estrutura MinHeap.
- * @return Ponteiro para o nó extraído.
- */
-struct MinHeapNode *extractMin(struct MinHeap *minHeap)
-{
-  struct MinHeapNode *temp = minHeap->array[0];
-  minHeap->array[0] = minHeap->array[minHeap->size - 1];
-  --minHeap->size;
-  minHeapify(minHeap, 0);
-  return temp;
-}
-
-/**
- * Insere um novo nó no MinHeap.
- *
- * @param minHeap Ponteiro para a estrutura MinHeap.
- * @param minHeapNode Ponteiro para o nó a ser inserido.
- */
-void insertMinHeap(struct MinHeap *minHeap, struct MinHeapNode *minHeapNode)
-{
-  ++minHeap->size;
-  int i = minHeap->size - 1;
-
-  while (i && minHeapNode->freq < minHeap->array[(i - 1) / 2]->freq)
-  {
-    minHeap->array[i] = minHeap->array[(i - 1) / 2];
-    i = (i - 1) / 2;
-  }
-  minHeap->array[i] = minHeapNode;
-}
-
-/**
- * Constrói um MinHeap a partir dos nós dados.
- *
- * @param minHeap Ponteiro para a estrutura MinHeap.
- */
-void buildMinHeap(struct MinHeap *minHeap)
-{
-  int n = minHeap->size - 1;
-  for (int i = (n - 1) / 2; i >= 0; --i)
-    minHeapify(minHeap, i);
-}
-
-/**
- * Verifica se um nó é uma folha.
- *
- * @param root Ponteiro para a estrutura MinHeapNode.
- * @return 1 se for folha, 0 caso contrário.
- */
-int isLeaf(struct MinHeapNode *root) { return !(root->left) && !(root->right); }
-
-/**
- * Cria e constrói um MinHeap a partir dos dados fornecidos.
- *
- * @param minHeap Ponteiro para a estrutura MinHeap.
- * @param data Array de caracteres.
- * @param freq Array de frequências.
- * @param size Tamanho do array de caracteres.
- */
-void createAndBuildMinHeap(struct MinHeap *minHeap, char data[], int freq[],
-                           int size)
-{
-  createMinHeap(minHeap, size);
-
-  for (int i = 0; i < size; ++i)
-    minHeap->array[i] = newNode(data[i], freq[i]);
-
-  minHeap->size = size;
-  buildMinHeap(minHeap);
-}
-
-/**
- * Constrói uma Árvore de Huffman a partir dos dados de entrada.
- *
- * @param data Array de caracteres únicos.
- * @param freq Array de frequências dos caracteres.
- * @param size Número de caracteres únicos.
- * @return Ponteiro para a raiz da Árvore de Huffman.
- */
-struct MinHeapNode *buildHuffmanTree(char data[], int freq[], int size)
-{
-  struct MinHeapNode *left, *right, *top;
-  struct MinHeap minHeap;
-
-  createAndBuildMinHeap(&minHeap, data, freq, size);
-
-  while (minHeap.size > 1)
-  {
-    left = extractMin(&minHeap);
-    right = extractMin(&minHeap);
-
-    top = newNode('$', left->freq + right->freq);
-    top->left = left;
-    top->right = right;
-
-    insertMinHeap(&minHeap, top);
-  }
-
-  return extractMin(&minHeap);
-}
-
-// Função utilitária para calcular a frequência dos caracteres por partes (ex: 1000 caracteres por vez)
-void calculateFrequencyInChunks(const char data[], int freq[], int size, int chunkSize)
-{
-  for (int start = 0; start < size; start += chunkSize)
-  {
-    int end = (start + chunkSize < size) ? start + chunkSize : size; // Garante que não ultrapasse o tamanho total
-    for (int i = start; i < end; ++i)
-    {
-      freq[(int)data[i]]++; // Acessa diretamente a memória Flash
-    }
-  }
-}
-
-/**
- * Gera os códigos de Huffman para cada caractere.
- *
- * @param root Ponteiro para a raiz da árvore de Huffman.
- * @param codes Matriz para armazenar os códigos gerados.
- */
-void generateCodes(struct MinHeapNode *root, char codes[][MAX_TREE_HT])
-{
-  int stackTop = 0;
-  struct MinHeapNode *current = root;
-  int top = 0;
-
-  while (stackTop > 0 || current != NULL)
-  {
-    while (current != NULL)
-    {
-      stack[stackTop++] = current;
-      arr[top++] = 0;
-      current = current->left;
-    }
-
-    current = stack[stackTop - 1];
-
-    if (current->right != NULL && !visited[stackTop - 1])
-    {
-      visited[stackTop - 1] = 1;
-      current = current->right;
-      arr[top - 1] = 1;
-    }
-    else
-    {
-      stackTop--;
-      top--;
-
-      if (isLeaf(current))
-      {
-        for (int i = 0; i < top; ++i)
-          codes[(int)current->data][i] = arr[i] + '0';
-        codes[(int)current->data][top] = '\0';
-      }
-
-      current = NULL;
-    }
-  }
-}
-
-// Função para realizar a compressão
-void compressInput(const char input[], int size, char codes[][MAX_TREE_HT],
-                   char *compressed)
-{
-  int bitIndex = 0;
-  for (int i = 0; i < size; ++i)
-  {
-    for (int j = 0; codes[(int)input[i]][j] != '\0'; ++j)
-    {
-      compressed[bitIndex++] = codes[(int)input[i]][j];
-    }
-  }
-}
-
-// Função para converter uma string binária para caracteres ASCII
-char binary_to_char(const char *binary)
-{
-  int value = 0;
-  for (int i = 0; i < 8; ++i)
-  {
-    value = value * 2 + (binary[i] - '0');
-  }
-  return (char)value;
-}
-
-// Função para alinhar a string binária e converter para caracteres
-void convertToAscii(char *compressed)
-{
-  int length = strlen(compressed);
-  int padded_length = ((length + 7) / 8) * 8;
-  int padding = padded_length - length;
-
-  memset(padded_data, '0', padding);
-  strcpy(padded_data + padding, compressed);
-
-  int index = 0;
-
-  for (int i = 0; i < padded_length; i += 8)
-  {
-    output[index++] = binary_to_char(&padded_data[i]);
-  }
-
-  // Exibe a string convertida
-  printf("Compressed (ASCII):\n");
-  for (int i = 0; i < index; ++i)
-  {
-    putchar(output[i]);
-  }
-  putchar('\n');
-
-  // Exibe a contagem de caracteres ASCII gerados, excluindo o EOF
-  printf("Number of ASCII characters generated: %d\n", index - 1);
-}
-
-// Função para imprimir os códigos de Huffman gerados
-void printHuffmanCodes(char codes[][MAX_TREE_HT])
-{
-  printf("Huffman Codes:\n");
-  for (int i = 0; i < MAX_CHAR; ++i)
-  {
-    if (codes[i][0] != '\0')
-    {
-      if (i == (int)EOF_CHAR)
-      {
-        printf("EOF: %s\n", codes[i]);
-      }
-      else
-      {
-        printf("%c: %s\n", i, codes[i]);
-      }
-    }
-  }
-}
-
-/**
- * Gera os códigos de Huffman e realiza a compressão.
- *
- * @param data Dados de entrada (texto).
- * @param size Tamanho dos dados de entrada.
- */
-void HuffmanCodes(const char data[], int size)
-{
-  memset(freq, 0, sizeof(freq));
-
-  // Chama a função que calcula a frequência em partes (1000 caracteres por vez)
-  calculateFrequencyInChunks(data, freq, size, 1000);
-
-  // Adiciona o símbolo EOF ao conjunto de caracteres
-  freq[(int)EOF_CHAR] = 1;
-
-  int uniqueSize = 0;
-  for (int i = 0; i < MAX_CHAR; ++i)
-  {
-    if (freq[i] > 0)
-    {
-      uniqueData[uniqueSize] = (char)i;
-      uniqueFreq[uniqueSize] = freq[i];
-      uniqueSize++;
-    }
-  }
-
-  struct MinHeapNode *root =
-      buildHuffmanTree(uniqueData, uniqueFreq, uniqueSize);
-  generateCodes(root, codes);
-
-  // Imprime os códigos de Huffman gerados
-  printHuffmanCodes(codes);
-
-  compressInput(data, size, codes, compressed);
-
-  // Adiciona o código do EOF ao final do fluxo comprimido
-  for (int j = 0; codes[(int)EOF_CHAR][j] != '\0'; ++j)
-  {
-    compressed[strlen(compressed)] = codes[(int)EOF_CHAR][j];
-  }
-
-  convertToAscii(compressed);
-}
-
 // Programa principal
 int main()
 {
@@ -0,0 +1,1715 @@
+/*
+ * Algoritmo de Codificação de Huffman - Testes de ida e volta
+ *
+ * Descrição:
+ * Ferramenta de host que comprime entradas de conteúdo e tamanho variados
+ * e confere o resultado byte a byte.
+ *
+ * Entradas: vazia, de 1 byte, com todos os símbolos do alfabeto do perfil,
+ * uma corrida, texto de telemetria, dados aleatórios, um arquivo misto e um
+ * histograma que força o limite de comprimento dos códigos. Para cada uma:
+ * - o codificador em fluxo, alimentado 1 byte por vez e em partes de
+ *   tamanho aleatório, gera o mesmo fluxo que huffmanEncodeBuffer, entregue
+ *   em blocos de HUFF_OUT_CHUNK bytes; partes recusadas não alteram o
+ *   estado do codificador;
+ * - o decodificador em fluxo, alimentado 1 byte por vez e com buffers de
+ *   saída pequenos (guardados por um canário), devolve a entrada e recusa
+ *   fluxos truncados ou com o preenchimento errado;
+ * - a tabela canônica, montada só com os comprimentos, decodifica a saída de
+ *   huffmanEncodeBuffer e recusa o fluxo sem o último byte;
+ * - com -DHUFF_TEST_TABLES, as tabelas que huffman_gen gerou em
+ *   teste_tables.h comprimem e descomprimem a entrada como na placa, e
+ *   conferem com assignCanonicalCodes e buildDecodeTable;
+ * - cada codificador de blocos (HUFFMAN, STREAMS, ordem 1, segmentos,
+ *   divisão automática, LZ77 nos três níveis e BWT), com e sem CRC, é
+ *   decodificado por huffmanDecodeAnyBlock e comparado byte a byte; com
+ *   buffers de saída pequenos demais, não grava além da capacidade, e
+ *   blocos truncados ou com um byte alterado sob CRC são recusados;
+ *   entradas de um símbolo só viram blocos RLE e, no alfabeto de 256, as
+ *   de símbolos equiprováveis viram STORED;
+ * - o mesmo bloco, empacotado como em huffman_pack.c, é descomprimido por
+ *   huffmanAssetUnpack, que recusa recursos truncados, de outro tipo ou sem
+ *   espaço na saída;
+ * - a saída DEFLATE e gzip (níveis 0 a 3) é descomprimida por um inflate
+ *   mínimo (RFC 1951) deste arquivo e, com -DHUFF_TEST_ZLIB (e -lz), também
+ *   pela zlib; com cópias, ela nunca passa da de só literais;
+ * - o índice de acesso aleatório, sobre blocos HUFFMAN e STREAMS, serve
+ *   trechos ao acaso iguais à entrada, também depois de gravado e lido de
+ *   volta por huffmanSeekIndexWrite/huffmanSeekIndexRead, e, num arquivo
+ *   que alterna blocos HUFFMAN, CONTEXT, SEGMENTS, LZ e BWT,
+ *   huffmanDecodeAnyRange serve os mesmos trechos.
+ * Confere também blocos corrompidos ao acaso, que devem ser recusados ou
+ * decodificados sem sair dos buffers (compile com -fsanitize=address), e
+ * índices gravados truncados, alterados ou de outra versão, e tabelas
+ * canônicas com comprimentos inválidos, que devem ser recusados; posições
+ * acima de 4 GB voltam intactas. No HOST, os blocos HUFFMAN e STREAMS são
+ * decodificados por cada caminho de huffman_cpu.c (portável, x86-64, BMI2 e
+ * AVX2, conforme a CPU).
+ *
+ * Uso:
+ * gcc -O2 -fsanitize=address,undefined huffman_test.c huffman.c huffman_encode.c huffman_decode.c huffman_frame.c huffman_frame_decode.c huffman_cpu.c huffman_bitio.c huffman_coder.c huffman_context.c huffman_lz.c huffman_bwt.c huffman_blocks.c huffman_deflate.c huffman_asset.c -o huffman_test
+ * ./huffman_test
+ * Retorna 0 se todos os testes passarem. Repita com -DHUFF_PROFILE=STM32F030.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "huffman_asset.h"
+#include "huffman_blocks.h"
+#include "huffman_deflate.h"
+#ifdef HUFF_TEST_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HUFF_TEST_TABLES
+#include "teste_tables.h" // ./huffman_gen teste corpus.txt (ver README)
+#endif
+
+#define MAX_INPUT (256 * 1024)
+#define MAX_CODED (2 * MAX_INPUT + 65536)
+#define CANARY 0xA5
+#define CANARY_SIZE 64
+#define STREAM_PART 300 // Maior parte entregue de uma vez ao fluxo
+#define FUZZ_INPUT 12288 // Acima de HUFF_CONTEXT_MIN_BLOCK: gera blocos CONTEXT
+#define FUZZ_ROUNDS 200
+#define SEEK_BLOCK 16384
+#define SEEK_POINTS 1024
+#define SEEK_SAVED (HUFF_SEEK_HEADER_SIZE + SEEK_POINTS * HUFF_SEEK_POINT_SIZE + \
+                    HUFF_BLOCK_CRC_SIZE)
+
+static char input[MAX_INPUT];
+static unsigned char coded[MAX_CODED + CANARY_SIZE];
+static unsigned char other[MAX_CODED];
+static char output[MAX_INPUT + CANARY_SIZE];
+static struct HuffmanTreeWork tree;
+static struct HuffmanCanonicalTable canonical;
+static struct HuffmanBlockEncodeWork blockWork;
+static struct HuffmanBlockDecodeWork decodeWork;
+static struct HuffmanSplitWork splitWork;
+static struct HuffmanAnyWork anyWork;
+static struct HuffmanDeflateWork deflateWork;
+static struct HuffmanSeekPoint seekPoints[SEEK_POINTS];
+static struct HuffmanSeekPoint readPoints[SEEK_POINTS];
+static unsigned char savedIndex[SEEK_SAVED];
+
+// Codificador de blocos, com a memória de trabalho já escolhida
+typedef long (*BlockEncoder)(const char *in, unsigned long size,
+                             unsigned char *out, unsigned long outSize,
+                             int flags);
+static unsigned long state = 1;
+static int tests;
+static int failures;
+
+// Gerador congruente linear: as entradas são sempre as mesmas
+static unsigned long nextRandom(void)
+{
+  state = (state * 1103515245ul + 12345ul) & 0x7FFFFFFF;
+  return state >> 8;
+}
+
+static void check(int ok, const char *input, const char *name,
+                  const char *what)
+{
+  tests++;
+  if (!ok)
+  {
+    failures++;
+    printf("FALHA: %s, %s: %s\n", input, name, what);
+  }
+}
+
+static int canaryIntact(const unsigned char *p)
+{
+  for (int i = 0; i < CANARY_SIZE; ++i)
+  {
+    if (p[i] != CANARY)
+      return 0;
+  }
+  return 1;
+}
+
+/* ------------------------------------------------------------------------ */
+/* Entradas                                                                 */
+/* ------------------------------------------------------------------------ */
+
+static unsigned long makeEmpty(void)
+{
+  return 0;
+}
+
+static unsigned long makeOne(void)
+{
+  input[0] = 'A';
+  return 1;
+}
+
+// Cada símbolo do alfabeto uma vez, em ordem
+static unsigned long makeAlphabet(void)
+{
+  for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+    input[i] = (char)i;
+  return HUFF_ALPHABET_SIZE;
+}
+
+// 64 permutações do alfabeto
+static unsigned long makeShuffled(void)
+{
+  unsigned long size = 0;
+
+  for (int round = 0; round < 64; ++round)
+  {
+    char *p = input + size;
+    for (int i = 0; i < HUFF_ALPHABET_SIZE; ++i)
+      p[i] = (char)i;
+    for (int i = HUFF_ALPHABET_SIZE - 1; i > 0; --i)
+    {
+      int j = (int)(nextRandom() % (unsigned long)(i + 1));
+      char t = p[i];
+      p[i] = p[j];
+      p[j] = t;
+    }
+    size += HUFF_ALPHABET_SIZE;
+  }
+  return size;
+}
+
+static unsigned long makeRun(void)
+{
+  memset(input, 'x', 5000);
+  return 5000;
+}
+
+// Leituras de sensores em texto, variando devagar
+static unsigned long makeTelemetry(unsigned long limit)
+{
+  unsigned long size = 0;
+  long temperature = 2350, humidity = 550, pressure = 10132, voltage = 330;
+  char line[64];
+
+  for (;;)
+  {
+    temperature += (long)(nextRandom() % 21) - 10;
+    humidity += (long)(nextRandom() % 7) - 3;
+    pressure += (long)(nextRandom() % 5) - 2;
+    voltage += (long)(nextRandom() % 3) - 1;
+    int len = snprintf(line, sizeof(line), "T=%ld.%02ld,H=%ld.%ld,P=%ld.%ld,V=%ld.%02ld\n",
+                       temperature / 100, labs(temperature % 100),
+                       humidity / 10, labs(humidity % 10), pressure / 10,
+                       labs(pressure % 10), voltage / 100, labs(voltage % 100));
+    if (size + (unsigned long)len > limit)
+      return size;
+    memcpy(input + size, line, (size_t)len);
+    size += (unsigned long)len;
+  }
+}
+
+static unsigned long makeText(void)
+{
+  return makeTelemetry(200000);
+}
+
+static unsigned long makeRandom(void)
+{
+  for (unsigned long i = 0; i < 70000; ++i)
+    input[i] = (char)(nextRandom() % HUFF_ALPHABET_SIZE);
+  return 70000;
+}
+
+// Trechos de texto alternados com trechos aleatórios
+static unsigned long makeMixed(void)
+{
+  unsigned long size = makeTelemetry(150000);
+
+  for (unsigned long start = 20000; start + 10000 <= size; start += 40000)
+  {
+    for (unsigned long i = start; i < start + 10000; ++i)
+      input[i] = (char)(nextRandom() % HUFF_ALPHABET_SIZE);
+  }
+  return size;
+}
+
+// Símbolo i repetido 2^i vezes: sem limite, o código mais longo passaria de
+// HUFF_MAX_CODE_LEN bits
+static unsigned long makeSkewed(void)
+{
+  unsigned long size = 0;
+
+  for (int i = 0; i <= HUFF_MAX_CODE_LEN + 1; ++i)
+  {
+    memset(input + size, 'a' + i, 1ul << i);
+    size += 1ul << i;
+  }
+  for (unsigned long i = size - 1; i > 0; --i)
+  {
+    unsigned long j = nextRandom() % (i + 1);
+    char t = input[i];
+    input[i] = input[j];
+    input[j] = t;
+  }
+  return size;
+}
+
+static const struct
+{
+  const char *name;
+  unsigned long (*make)(void);
+} inputs[] = {
+    {"vazia", makeEmpty},
+    {"1 byte", makeOne},
+    {"alfabeto", makeAlphabet},
+    {"permutacoes", makeShuffled},
+    {"corrida", makeRun},
+    {"texto", makeText},
+    {"aleatoria", makeRandom},
+    {"misto", makeMixed},
+    {"desbalanceada", makeSkewed},
+};
+
+#define INPUTS (int)(sizeof(inputs) / sizeof(inputs[0]))
+
+/* ------------------------------------------------------------------------ */
+/* Codificador em fluxo                                                     */
+/* ------------------------------------------------------------------------ */
+
+// Destino do codificador em fluxo: junta os blocos recebidos em coded
+struct Collector
+{
+  unsigned long size; // Bytes recebidos
+  int last;           // Tamanho do bloco anterior (0 antes do primeiro)
+  int bad;            // 1 se um bloco veio vazio ou depois de um incompleto
+};
+
+static void collect(const unsigned char *chunk, int size, void *context)
+{
+  struct Collector *collector = (struct Collector *)context;
+
+  // Só o último bloco pode ter menos de HUFF_OUT_CHUNK bytes
+  if ((collector->last != 0 && collector->last != HUFF_OUT_CHUNK) ||
+      size <= 0 || size > HUFF_OUT_CHUNK ||
+      collector->size + (unsigned long)size > MAX_CODED)
+  {
+    collector->bad = 1;
+    return;
+  }
+  memcpy(coded + collector->size, chunk, (size_t)size);
+  collector->size += (unsigned long)size;
+  collector->last = size;
+}
+
+/**
+ * Monta em other o fluxo esperado (cabeçalho + huffmanEncodeBuffer) para a
+ * entrada e os códigos dados.
+ *
+ * @return Tamanho do fluxo.
+ */
+static unsigned long referenceStream(unsigned long size, const unsigned freq[],
+                                     const struct HuffmanCodeTable *table)
+{
+  unsigned long long bits = huffmanEncodedBits(freq, table);
+
+  other[0] = (unsigned char)size;
+  other[1] = (unsigned char)(size >> 8);
+  other[2] = (unsigned char)(size >> 16);
+  other[3] = (unsigned char)(size >> 24);
+  other[4] = (unsigned char)((8 - bits % 8) % 8);
+  huffmanEncodeBuffer(table, input, size, other + HUFF_FRAME_HEADER_SIZE);
+  return HUFF_FRAME_HEADER_SIZE + (unsigned long)((bits + 7) / 8);
+}
+
+/**
+ * Codifica a entrada em partes de até maxPart bytes (1 para um byte por
+ * vez) e confere o fluxo e os blocos entregues ao sink.
+ */
+static unsigned long testStreamEncoder(const char *inputName,
+                                       unsigned long size,
+                                       unsigned long maxPart)
+{
+  static struct HuffmanEncoder encoder;
+  const char *name = maxPart == 1 ? "fluxo/1" : "fluxo/var";
+  unsigned freq[HUFF_ALPHABET_SIZE] = {0};
+  struct HuffmanCodeTable table;
+  struct Collector collector = {0, 0, 0};
+  unsigned long expected;
+  int ok = 1;
+
+  check(calculateFrequencyInChunks(input, freq, (int)size, 1000) == 0,
+        inputName, name, "entrada fora do alfabeto");
+  buildCodeTable(&tree, freq, &table);
+  expected = referenceStream(size, freq, &table);
+
+  huffmanEncoderInit(&encoder, &table, freq, collect, &collector);
+  for (unsigned long pos = 0; pos < size;)
+  {
+    unsigned long part = maxPart == 1 ? 1 : nextRandom() % (maxPart + 1);
+    if (part > size - pos)
+      part = size - pos;
+    ok &= huffmanEncodeUpdate(&encoder, input + pos, (int)part) == 0;
+    pos += part;
+  }
+  ok &= huffmanEncoderFinish(&encoder) == 0;
+
+  check(ok, inputName, name, "codificacao falhou");
+  check(!collector.bad, inputName, name, "bloco fora de HUFF_OUT_CHUNK");
+  check(collector.size == expected && encoder.total == expected &&
+            memcmp(coded, other, expected) == 0,
+        inputName, name, "fluxo difere de huffmanEncodeBuffer");
+  if (maxPart == 1)
+    printf("%-14s %-10s %7lu -> %7lu\n", inputName, name, size, expected);
+  return expected;
+}
+
+/**
+ * Decodifica o fluxo de other em fragmentos de até maxIn bytes (1 para um
+ * byte por vez), com um buffer de saída de outSize bytes seguido de um
+ * canário, e confere o resultado com a entrada.
+ *
+ * @param codedSize Tamanho do fluxo em other.
+ */
+static void testStreamDecoder(const char *inputName, unsigned long size,
+                              unsigned long codedSize, unsigned long maxIn,
+                              int outSize)
+{
+  static struct HuffmanDecodeTable decodeTable;
+  static struct HuffmanDecoder decoder;
+  char name[16];
+  char out[STREAM_PART + CANARY_SIZE];
+  unsigned freq[HUFF_ALPHABET_SIZE] = {0};
+  struct HuffmanCodeTable table;
+  unsigned long in = 0, pos = 0;
+  int status = HUFF_DECODE_NEED_INPUT;
+  int ok = 1;
+
+  snprintf(name, sizeof(name), "dec/%lu/%d", maxIn, outSize);
+  calculateFrequencyInChunks(input, freq, (int)size, 1000);
+  buildCodeTable(&tree, freq, &table);
+  check(buildDecodeTable(&table, &decodeTable) == 0, inputName, name,
+        "tabela de decodificacao recusada");
+  huffmanDecoderInit(&decoder, &decodeTable);
+  memset(out, CANARY, sizeof(out));
+
+  while (ok && status != HUFF_DECODE_DONE)
+  {
+    unsigned long part = maxIn == 1 ? 1 : nextRandom() % (maxIn + 1);
+    int consumed, produced;
+
+    if (part > codedSize - in)
+      part = codedSize - in;
+    status = huffmanDecodeUpdate(&decoder, other + in, (int)part, &consumed,
+                                 out, outSize, &produced);
+    ok &= status != HUFF_DECODE_ERROR && consumed >= 0 &&
+          (unsigned long)consumed <= part && produced >= 0 &&
+          produced <= outSize && pos + (unsigned long)produced <= size &&
+          memcmp(out, input + pos, (size_t)produced) == 0;
+    for (int i = outSize; i < outSize + CANARY_SIZE; ++i)
+      ok &= (unsigned char)out[i] == CANARY;
+
+    // Sem progresso só se toda a entrada já foi entregue
+    if (consumed == 0 && produced == 0 && in == codedSize)
+      break;
+    in += (unsigned long)consumed;
+    pos += (unsigned long)produced;
+  }
+
+  check(ok, inputName, name, "saida difere da entrada");
+  check(status == HUFF_DECODE_DONE && pos == size && in == codedSize,
+        inputName, name, "fluxo nao terminou no ultimo byte");
+}
+
+/**
+ * Fluxos truncados ou com preenchimento errado no cabeçalho não chegam a
+ * HUFF_DECODE_DONE.
+ */
+static void testStreamDecoderErrors(const char *inputName, unsigned long size,
+                                    unsigned long codedSize)
+{
+  static struct HuffmanDecodeTable decodeTable;
+  static struct HuffmanDecoder decoder;
+  const char *name = "dec/erro";
+  unsigned freq[HUFF_ALPHABET_SIZE] = {0};
+  struct HuffmanCodeTable table;
+  int consumed, produced, status;
+
+  calculateFrequencyInChunks(input, freq, (int)size, 1000);
+  buildCodeTable(&tree, freq, &table);
+  buildDecodeTable(&table, &decodeTable);
+
+  // Sem o último byte
+  huffmanDecoderInit(&decoder, &decodeTable);
+  status = huffmanDecodeUpdate(&decoder, other, (int)codedSize - 1, &consumed,
+                               (char *)coded, MAX_CODED, &produced);
+  check(status == HUFF_DECODE_NEED_INPUT, inputName, name,
+        "fluxo truncado terminou");
+
+  // Preenchimento anunciado diferente do que sobra no último byte
+  other[4] ^= 1;
+  huffmanDecoderInit(&decoder, &decodeTable);
+  status = huffmanDecodeUpdate(&decoder, other, (int)codedSize, &consumed,
+                               (char *)coded, MAX_CODED, &produced);
+  check(status == HUFF_DECODE_ERROR, inputName, name,
+        "preenchimento errado aceito");
+  other[4] ^= 1;
+}
+
+/**
+ * Partes recusadas (símbolo sem código, fora do alfabeto, além do tamanho
+ * anunciado) não consomem nada: depois delas, o restante da entrada ainda
+ * gera o fluxo completo.
+ */
+static void testStreamEncoderErrors(void)
+{
+  static struct HuffmanEncoder encoder;
+  const char *name = "fluxo";
+  unsigned freq[HUFF_ALPHABET_SIZE] = {0};
+  struct HuffmanCodeTable table;
+  struct Collector collector = {0, 0, 0};
+  unsigned long size, half, expected;
+  char bad[16];
+  int missing = -1;
+
+  state = 3;
+  size = makeTelemetry(20000);
+  half = size / 2;
+  calculateFrequencyInChunks(input, freq, (int)size, 1000);
+  buildCodeTable(&tree, freq, &table);
+  expected = referenceStream(size, freq, &table);
+  for (int c = 0; c < HUFF_ALPHABET_SIZE && missing < 0; ++c)
+  {
+    if (table.len[c] == 0)
+      missing = c;
+  }
+
+  huffmanEncoderInit(&encoder, &table, freq, collect, &collector);
+  check(huffmanEncodeUpdate(&encoder, input, (int)half) == 0, "recusa", name,
+        "primeira metade recusada");
+
+  // Símbolo sem código no meio da parte: nada dela é codificado
+  memcpy(bad, input + half, sizeof(bad));
+  bad[sizeof(bad) / 2] = (char)missing;
+  check(huffmanEncodeUpdate(&encoder, bad, (int)sizeof(bad)) == -1 &&
+            encoder.remaining == size - half,
+        "recusa", name, "simbolo sem codigo consumiu a parte");
+#if HUFF_ALPHABET_SIZE < 256
+  bad[sizeof(bad) / 2] = (char)HUFF_ALPHABET_SIZE;
+  check(huffmanEncodeUpdate(&encoder, bad, (int)sizeof(bad)) == -1 &&
+            encoder.remaining == size - half,
+        "recusa", name, "simbolo fora do alfabeto consumiu a parte");
+#endif
+
+  // Mais símbolos que os anunciados, ou tamanho negativo
+  check(huffmanEncodeUpdate(&encoder, input, (int)(size - half + 1)) == -1 &&
+            huffmanEncodeUpdate(&encoder, input, -1) == -1 &&
+            encoder.remaining == size - half,
+        "recusa", name, "parte alem do anunciado consumida");
+
+  check(huffmanEncodeUpdate(&encoder, input + half, (int)(size - half)) == 0 &&
+            huffmanEncoderFinish(&encoder) == 0 && !collector.bad &&
+            collector.size == expected && memcmp(coded, other, expected) == 0,
+        "recusa", name, "fluxo difere depois das partes recusadas");
+
+  // Faltando símbolos, Finish acusa
+  collector.size = 0;
+  collector.last = 0;
+  huffmanEncoderInit(&encoder, &table, freq, collect, &collector);
+  check(huffmanEncodeUpdate(&encoder, input, (int)half) == 0 &&
+            huffmanEncoderFinish(&encoder) == -1,
+        "recusa", name, "fluxo incompleto aceito");
+}
+
+/* ------------------------------------------------------------------------ */
+/* Decodificação canônica                                                   */
+/* ------------------------------------------------------------------------ */
+
+/**
+ * Decodifica com a tabela canônica, montada só com os comprimentos, o que
+ * huffmanEncodeBuffer gerou, e confere que o fluxo sem o último byte é
+ * recusado.
+ */
+static void testCanonical(const char *inputName, unsigned long size)
+{
+  const char *name = "canonica";
+  unsigned freq[HUFF_ALPHABET_SIZE] = {0};
+  struct HuffmanCodeTable table;
+  unsigned long long bits;
+  unsigned long bytes;
+
+  calculateFrequencyInChunks(input, freq, (int)size, 1000);
+  buildCodeTable(&tree, freq, &table);
+  bits = huffmanEncodeBuffer(&table, input, size, other);
+  bytes = (unsigned long)((bits + 7) / 8);
+  check(buildCanonicalTable(table.len, &canonical) == 0, inputName, name,
+        "comprimentos recusados");
+
+  memset(output + size, CANARY, CANARY_SIZE);
+  check(huffmanDecodeCanonical(&canonical, other, bytes, output, size) ==
+                (long long)bits &&
+            memcmp(output, input, size) == 0 &&
+            canaryIntact((unsigned char *)output + size),
+        inputName, name, "decodificacao difere da entrada");
+
+  // Cópia no tamanho exato, para o AddressSanitizer acusar leituras além
+  if (bytes > 0)
+  {
+    unsigned char *copy = malloc(bytes - 1 ? bytes - 1 : 1);
+    memcpy(copy, other, bytes - 1);
+    check(huffmanDecodeCanonical(&canonical, copy, bytes - 1, output, size) ==
+              -1,
+          inputName, name, "aceitou fluxo truncado");
+    free(copy);
+  }
+}
+
+/**
+ * Comprimentos acima de HUFF_MAX_CODE_LEN ou que violam a desigualdade de
+ * Kraft são recusados, e um código que não existe num prefixo incompleto
+ * não é decodificado.
+ */
+static void testCanonicalErrors(void)
+{
+  const char *name = "canonica";
+  unsigned char len[HUFF_ALPHABET_SIZE] = {0};
+  const unsigned char ones = 0xFF;
+  char out[4];
+
+  len[0] = HUFF_MAX_CODE_LEN + 1;
+  check(buildCanonicalTable(len, &canonical) == -1, "recusa", name,
+        "comprimento acima do limite aceito");
+
+  len[0] = len[1] = len[2] = 1;
+  check(buildCanonicalTable(len, &canonical) == -1, "recusa", name,
+        "comprimentos fora de Kraft aceitos");
+
+  // Só 00 e 01: nenhum código começa com 1
+  len[0] = len[1] = 2;
+  len[2] = 0;
+  check(buildCanonicalTable(len, &canonical) == 0 &&
+            huffmanDecodeCanonical(&canonical, &ones, 1, out, 1) == -1,
+        "recusa", name, "codigo inexistente decodificado");
+}
+
+#ifdef HUFF_TEST_TABLES
+/* ------------------------------------------------------------------------ */
+/* Tabelas constantes (huffman_gen)                                         */
+/* ------------------------------------------------------------------------ */
+
+/**
+ * As tabelas geradas dão código a todo símbolo do alfabeto, os códigos são
+ * os canônicos dos comprimentos e a árvore é a que buildDecodeTable monta.
+ */
+static void testTables(void)
+{
+  static struct HuffmanDecodeTable decodeTable;
+  const char *name = "gen";
+  struct HuffmanCodeTable codes = teste_codes;
+  int missing = 0;
+
+  for (int c = 0; c < HUFF_ALPHABET_SIZE; ++c)
+    missing |= teste_codes.len[c] == 0;
+  check(!missing, "tabelas", name, "simbolo sem codigo");
+  check(assignCanonicalCodes(&codes) == 0 &&
+            memcmp(&codes, &teste_codes, sizeof(codes)) == 0,
+        "tabelas", name, "codigos nao canonicos");
+  check(buildDecodeTable(&teste_codes, &decodeTable) == 0 &&
+            memcmp(&decodeTable, &teste_decode, sizeof(decodeTable)) == 0,
+        "tabelas", name, "arvore difere de buildDecodeTable");
+}
+
+/**
+ * Comprime a entrada com as tabelas geradas, como na placa (sem histograma,
+ * dentro de huffmanEncodedBound), e descomprime com huffmanDecoderInitRaw;
+ * as entradas fora do corpus usam os códigos longos.
+ */
+static void testTablesInput(const char *inputName, unsigned long size)
+{
+  static struct HuffmanDecoder decoder;
+  const char *name = "gen";
+  unsigned long long bits;
+  unsigned long bytes;
+  int consumed, produced, status;
+
+  bits = huffmanEncodeBuffer(&teste_codes, input, size, other);
+  bytes = (unsigned long)((bits + 7) / 8);
+  check(HUFF_FRAME_HEADER_SIZE + bytes <= huffmanEncodedBound(size),
+        inputName, name, "saida acima de huffmanEncodedBound");
+
+  memset(output + size, CANARY, CANARY_SIZE);
+  huffmanDecoderInitRaw(&decoder, &teste_decode, size,
+                        (int)((8 - bits % 8) % 8));
+  status = huffmanDecodeUpdate(&decoder, other, (int)bytes, &consumed, output,
+                               (int)size, &produced);
+  check(status == HUFF_DECODE_DONE && consumed == (int)bytes &&
+            produced == (int)size && memcmp(output, input, size) == 0 &&
+            canaryIntact((unsigned char *)output + size),
+        inputName, name, "decodificacao difere da entrada");
+  printf("%-14s %-10s %7lu -> %7lu\n", inputName, name, size, bytes);
+}
+#endif
+
+/* ------------------------------------------------------------------------ */
+/* Blocos                                                                   */
+/* ------------------------------------------------------------------------ */
+
+static long encodeHuffman(const char *in, unsigned long size,
+                          unsigned char *out, unsigned long outSize, int flags)
+{
+  return huffmanBlockEncode(&blockWork, in, size, out, outSize, flags);
+}
+
+static long encodeStreams(const char *in, unsigned long size,
+                          unsigned char *out, unsigned long outSize, int flags)
+{
+  return huffmanBlockEncode(&blockWork, in, size, out, outSize,
+                            flags | HUFF_BLOCK_FLAG_STREAMS);
+}
+
+static long encodeContext(const char *in, unsigned long size,
+                          unsigned char *out, unsigned long outSize, int flags)
+{
+  return huffmanContextEncode(&anyWork.bwt.context, in, size, out, outSize,
+                              flags);
+}
+
+static long encodeSegments(const char *in, unsigned long size,
+                           unsigned char *out, unsigned long outSize, int flags)
+{
+  return huffmanSegmentsEncode(&anyWork.bwt.context, in, size, out, outSize,
+                               flags);
+}
+
+static long encodeSplit(const char *in, unsigned long size,
+                        unsigned char *out, unsigned long outSize, int flags)
+{
+  return huffmanSplitEncode(&splitWork, in, size, out, outSize, flags);
+}
+
+static long encodeLzFast(const char *in, unsigned long size,
+                         unsigned char *out, unsigned long outSize, int flags)
+{
+  return huffmanLzEncode(&anyWork.lz, in, size, out, outSize, flags,
+                         HUFF_LZ_FAST);
+}
+
+static long encodeLzDefault(const char *in, unsigned long size,
+                            unsigned char *out, unsigned long outSize,
+                            int flags)
+{
+  return huffmanLzEncode(&anyWork.lz, in, size, out, outSize, flags,
+                         HUFF_LZ_DEFAULT);
+}
+
+static long encodeLzBest(const char *in, unsigned long size,
+                         unsigned char *out, unsigned long outSize, int flags)
+{
+  return huffmanLzEncode(&anyWork.lz, in, size, out, outSize, flags,
+                         HUFF_LZ_BEST);
+}
+
+static long encodeBwt(const char *in, unsigned long size,
+                      unsigned char *out, unsigned long outSize, int flags)
+{
+  return huffmanBwtEncode(&anyWork.bwt, in, size, out, outSize, flags);
+}
+
+static const struct
+{
+  const char *name;
+  BlockEncoder encode;
+} encoders[] = {
+    {"huffman", encodeHuffman},
+    {"streams", encodeStreams},
+    {"contexto", encodeContext},
+    {"segmentos", encodeSegments},
+    {"divisao", encodeSplit},
+    {"lz1", encodeLzFast},
+    {"lz2", encodeLzDefault},
+    {"lz3", encodeLzBest},
+    {"bwt", encodeBwt},
+};
+
+#define ENCODERS (int)(sizeof(encoders) / sizeof(encoders[0]))
+
+/**
+ * Decodifica uma sequência de blocos de qualquer tipo.
+ *
+ * @param in Blocos.
+ * @param size Tamanho dos blocos.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @return Tamanho total decodificado, ou -1 se algum bloco falhar.
+ */
+static long decodeBlocks(const unsigned char *in, unsigned long size,
+                         char *out, unsigned long outSize)
+{
+  unsigned long pos = 0;
+  unsigned long done = 0;
+
+  while (pos < size)
+  {
+    struct HuffmanBlockInfo info;
+    if (huffmanBlockParse(in + pos, size - pos, &info) != 0)
+      return -1;
+    long n = huffmanDecodeAnyBlock(&anyWork, in + pos, size - pos, out + done,
+                                   outSize - done);
+    if (n < 0)
+      return -1;
+    pos += info.blockSize;
+    done += (unsigned long)n;
+  }
+  return (long)done;
+}
+
+// Confere que os blocos decodificam exatamente para a entrada
+static int roundTrips(const unsigned char *in, unsigned long size,
+                      unsigned long rawSize)
+{
+  memset(output + rawSize, CANARY, CANARY_SIZE);
+  return decodeBlocks(in, size, output, rawSize) == (long)rawSize &&
+         memcmp(output, input, rawSize) == 0 &&
+         canaryIntact((unsigned char *)output + rawSize);
+}
+
+/**
+ * Decodifica uma cópia dos blocos alocada no tamanho exato, para o
+ * AddressSanitizer acusar leituras além do fim.
+ *
+ * @return Tamanho decodificado, ou -1; -2 se a saída passou da capacidade.
+ */
+static long decodeCopy(const unsigned char *in, unsigned long size,
+                       unsigned long outSize)
+{
+  unsigned char *copy = malloc(size ? size : 1);
+  long n;
+
+  memcpy(copy, in, size);
+  memset(output + outSize, CANARY, CANARY_SIZE);
+  n = decodeBlocks(copy, size, output, outSize);
+  free(copy);
+  if (!canaryIntact((unsigned char *)output + outSize) ||
+      n > (long)outSize)
+    return -2;
+  return n;
+}
+
+/**
+ * Codifica a entrada com o codificador e, com buffers de saída pequenos
+ * demais, blocos truncados e (com CRC) um byte alterado, confere que nada é
+ * gravado além da capacidade e que os blocos inválidos são recusados.
+ */
+static void testEncoder(const char *inputName, unsigned long size, int e,
+                        int flags)
+{
+  const char *name = encoders[e].name;
+  BlockEncoder encode = encoders[e].encode;
+  long len;
+
+  len = encode(input, size, coded, MAX_CODED, flags);
+  check(len > 0, inputName, name, "codificacao falhou");
+  if (len <= 0)
+    return;
+  check(roundTrips(coded, (unsigned long)len, size), inputName, name,
+        "decodificacao difere da entrada");
+  if (flags == 0)
+    printf("%-14s %-10s %7lu -> %7ld\n", inputName, name, size, len);
+
+  // Saída do codificador pequena demais: -1, ou blocos válidos que caibam
+  unsigned long caps[] = {0, HUFF_BLOCK_HEADER_SIZE, (unsigned long)len / 2,
+                          (unsigned long)len - 1};
+  for (int i = 0; i < 4; ++i)
+  {
+    memset(coded + caps[i], CANARY, CANARY_SIZE);
+    long small = encode(input, size, coded, caps[i], flags);
+    check(canaryIntact(coded + caps[i]), inputName, name,
+          "codificador gravou alem da capacidade");
+    if (small >= 0)
+      check((unsigned long)small <= caps[i] &&
+                roundTrips(coded, (unsigned long)small, size),
+            inputName, name, "bloco invalido em buffer pequeno");
+  }
+  len = encode(input, size, coded, MAX_CODED, flags);
+
+  // Saída do decodificador pequena demais
+  if (size > 0)
+    check(decodeCopy(coded, (unsigned long)len, size - 1) == -1, inputName,
+          name, "decodificou em buffer pequeno demais");
+
+  // Bloco truncado
+  for (unsigned long cut = 1; cut <= 16 && cut < (unsigned long)len; ++cut)
+    check(decodeCopy(coded, (unsigned long)len - cut, size) == -1, inputName,
+          name, "aceitou bloco truncado");
+
+  // Com CRC, qualquer byte alterado no corpo é recusado
+  if (flags & HUFF_BLOCK_FLAG_CRC)
+  {
+    struct HuffmanBlockInfo info;
+    if (huffmanBlockParse(coded, (unsigned long)len, &info) == 0 &&
+        info.compressedSize > 0)
+    {
+      unsigned long pos = HUFF_BLOCK_HEADER_SIZE + info.compressedSize / 2;
+      coded[pos] ^= 0x10;
+      check(decodeCopy(coded, (unsigned long)len, size) == -1, inputName,
+            name, "CRC nao detectou byte alterado");
+      coded[pos] ^= 0x10;
+    }
+  }
+}
+
+/**
+ * Entradas de um símbolo só viram RLE, de 1 byte de corpo, e as sem ganho
+ * (todos os símbolos com a mesma frequência no alfabeto de 256), STORED,
+ * com o corpo do tamanho da entrada.
+ */
+static void testFallbacks(void)
+{
+  struct HuffmanBlockInfo info;
+  unsigned long size;
+  long len;
+
+  size = makeRun();
+  len = huffmanBlockEncode(&blockWork, input, size, coded, MAX_CODED, 0);
+  check(len == HUFF_BLOCK_HEADER_SIZE + 1 &&
+            huffmanBlockParse(coded, (unsigned long)len, &info) == 0 &&
+            info.type == HUFF_BLOCK_RLE &&
+            roundTrips(coded, (unsigned long)len, size),
+        "corrida", "huffman", "bloco RLE esperado");
+
+  // Com 128 símbolos, os códigos de 7 bits ainda ganham de 1/8 do tamanho
+  state = 1;
+  size = makeShuffled();
+  len = huffmanBlockEncode(&blockWork, input, size, coded, MAX_CODED, 0);
+  check(len > 0 && huffmanBlockParse(coded, (unsigned long)len, &info) == 0 &&
+            (HUFF_ALPHABET_SIZE == 256
+                 ? info.type == HUFF_BLOCK_STORED &&
+                       info.compressedSize == size
+                 : info.type == HUFF_BLOCK_HUFFMAN) &&
+            roundTrips(coded, (unsigned long)len, size),
+        "permutacoes", "huffman", "tipo de bloco inesperado");
+}
+
+/**
+ * Empacota a entrada como huffman_pack.c (huffmanBlockEncode, sem CRC) e
+ * descomprime com huffmanAssetUnpack; recursos truncados, de outro tipo de
+ * bloco, com o tamanho declarado errado ou sem espaço na saída são
+ * recusados.
+ */
+static void testAsset(const char *inputName, unsigned long size)
+{
+  const char *name = "recurso";
+  struct HuffmanAsset asset;
+  unsigned char *copy;
+  long len;
+
+  len = huffmanBlockEncode(&blockWork, input, size, coded, MAX_CODED, 0);
+  check(len > 0, inputName, name, "codificacao falhou");
+  if (len <= 0)
+    return;
+
+  // Cópias no tamanho exato, para o AddressSanitizer acusar leituras além
+  copy = malloc((size_t)len);
+  memcpy(copy, coded, (size_t)len);
+  asset.data = copy;
+  asset.size = (unsigned long)len;
+  asset.rawSize = size;
+  memset(output + size, CANARY, CANARY_SIZE);
+  check(huffmanAssetUnpack(&asset, output, size) == (long)size &&
+            memcmp(output, input, size) == 0 &&
+            canaryIntact((unsigned char *)output + size),
+        inputName, name, "descompressao difere da entrada");
+
+  if (size > 0)
+    check(huffmanAssetUnpack(&asset, output, size - 1) == -1, inputName, name,
+          "descomprimiu em buffer pequeno demais");
+  asset.rawSize = size + 1;
+  check(huffmanAssetUnpack(&asset, output, MAX_INPUT) == -1, inputName, name,
+        "tamanho declarado errado aceito");
+  asset.rawSize = size;
+
+  // Só HUFFMAN, STORED e RLE saem de huffman_pack.c
+  copy[3] = HUFF_BLOCK_LZ;
+  check(huffmanAssetUnpack(&asset, output, size) == -1, inputName, name,
+        "tipo de bloco inesperado aceito");
+  free(copy);
+
+  copy = malloc((size_t)len - 1 ? (size_t)len - 1 : 1);
+  memcpy(copy, coded, (size_t)len - 1);
+  asset.data = copy;
+  asset.size = (unsigned long)len - 1;
+  check(huffmanAssetUnpack(&asset, output, size) == -1, inputName, name,
+        "aceitou recurso truncado");
+  free(copy);
+}
+
+/**
+ * Altera bytes ao acaso em blocos válidos: o decodificador deve recusar o
+ * bloco ou decodificar sem sair dos buffers.
+ */
+static void testCorruption(void)
+{
+  unsigned long size;
+
+  state = 7;
+  size = makeTelemetry(FUZZ_INPUT);
+  for (int e = 0; e < ENCODERS; ++e)
+  {
+    long len = encoders[e].encode(input, size, coded, MAX_CODED, 0);
+    check(len > 0, "corrompida", encoders[e].name, "codificacao falhou");
+    if (len <= 0)
+      continue;
+    memcpy(other, coded, (size_t)len);
+    for (int round = 0; round < FUZZ_ROUNDS; ++round)
+    {
+      int changes = 1 + (int)(nextRandom() % 4);
+      for (int i = 0; i < changes; ++i)
+      {
+        unsigned long pos = nextRandom() % (unsigned long)len;
+        // Preserva o tipo às vezes, para chegar ao corpo de cada módulo
+        if (pos == 3 && round % 2 == 0)
+          continue;
+        other[pos] ^= (unsigned char)(1 + nextRandom() % 255);
+      }
+      check(decodeCopy(other, (unsigned long)len, size) != -2, "corrompida",
+            encoders[e].name, "decodificacao saiu do buffer");
+      memcpy(other, coded, (size_t)len);
+    }
+    printf("%-14s %-10s %d alteracoes\n", "corrompida", encoders[e].name,
+           FUZZ_ROUNDS);
+  }
+}
+
+/* ------------------------------------------------------------------------ */
+/* Inflate mínimo (RFC 1951)                                                */
+/* ------------------------------------------------------------------------ */
+
+// Fluxo de bits DEFLATE, o menos significativo primeiro
+struct Inflate
+{
+  const unsigned char *in;
+  unsigned long size;
+  unsigned long pos;
+  unsigned long bitBuffer;
+  int bitCount;
+  unsigned char *out;
+  unsigned long outSize;
+  unsigned long outPos;
+};
+
+// Código canônico: quantidade por comprimento e símbolos em ordem
+struct InflateTable
+{
+  short count[HUFF_DEFLATE_MAX_CODE_LEN + 1];
+  short symbol[288];
+};
+
+static const short lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13,
+                                     15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+                                     67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const short lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                      1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                      4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const unsigned short distBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289,
+    16385, 24577};
+static const short distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3,
+                                    4, 4, 5, 5, 6, 6, 7, 7, 8, 8,
+                                    9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static long inflateBits(struct Inflate *s, int need)
+{
+  unsigned long value = s->bitBuffer;
+
+  while (s->bitCount < need)
+  {
+    if (s->pos == s->size)
+      return -1;
+    value |= (unsigned long)s->in[s->pos++] << s->bitCount;
+    s->bitCount += 8;
+  }
+  s->bitBuffer = value >> need;
+  s->bitCount -= need;
+  return (long)(value & ((1ul << need) - 1));
+}
+
+/**
+ * Prepara a tabela de um conjunto de comprimentos.
+ *
+ * @return 0 se o código for completo, > 0 se incompleto, < 0 se houver
+ *         códigos demais.
+ */
+static int inflateBuild(struct InflateTable *table,
+                        const unsigned char *lengths, int n)
+{
+  short offset[HUFF_DEFLATE_MAX_CODE_LEN + 1];
+  int left = 1;
+
+  memset(table->count, 0, sizeof(table->count));
+  for (int i = 0; i < n; ++i)
+    table->count[lengths[i]]++;
+  if (table->count[0] == n)
+    return 0;
+  for (int len = 1; len <= HUFF_DEFLATE_MAX_CODE_LEN; ++len)
+  {
+    left = (left << 1) - table->count[len];
+    if (left < 0)
+      return left;
+  }
+  offset[1] = 0;
+  for (int len = 1; len < HUFF_DEFLATE_MAX_CODE_LEN; ++len)
+    offset[len + 1] = (short)(offset[len] + table->count[len]);
+  for (int i = 0; i < n; ++i)
+  {
+    if (lengths[i] != 0)
+      table->symbol[offset[lengths[i]]++] = (short)i;
+  }
+  return left;
+}
+
+static int inflateSymbol(struct Inflate *s, const struct InflateTable *table)
+{
+  int code = 0, first = 0, index = 0;
+
+  for (int len = 1; len <= HUFF_DEFLATE_MAX_CODE_LEN; ++len)
+  {
+    long bit = inflateBits(s, 1);
+    if (bit < 0)
+      return -1;
+    code |= (int)bit;
+    int count = table->count[len];
+    if (code - first < count)
+      return table->symbol[index + code - first];
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+  return -1;
+}
+
+static int inflateCodes(struct Inflate *s, const struct InflateTable *lencode,
+                        const struct InflateTable *distcode)
+{
+  for (;;)
+  {
+    int symbol = inflateSymbol(s, lencode);
+    if (symbol < 0)
+      return -1;
+    if (symbol < 256)
+    {
+      if (s->outPos == s->outSize)
+        return -1;
+      s->out[s->outPos++] = (unsigned char)symbol;
+      continue;
+    }
+    if (symbol == 256)
+      return 0;
+    symbol -= 257;
+    if (symbol >= 29)
+      return -1;
+    long extra = inflateBits(s, lengthExtra[symbol]);
+    if (extra < 0)
+      return -1;
+    unsigned long len = (unsigned long)(lengthBase[symbol] + extra);
+    symbol = inflateSymbol(s, distcode);
+    if (symbol < 0 || symbol >= 30)
+      return -1;
+    extra = inflateBits(s, distExtra[symbol]);
+    if (extra < 0)
+      return -1;
+    unsigned long dist = distBase[symbol] + (unsigned long)extra;
+    if (dist > s->outPos || len > s->outSize - s->outPos)
+      return -1;
+    for (; len > 0; --len, ++s->outPos)
+      s->out[s->outPos] = s->out[s->outPos - dist];
+  }
+}
+
+static int inflateStored(struct Inflate *s)
+{
+  s->bitBuffer = 0;
+  s->bitCount = 0;
+  if (s->size - s->pos < 4)
+    return -1;
+  unsigned len = s->in[s->pos] | (unsigned)s->in[s->pos + 1] << 8;
+  unsigned nlen = s->in[s->pos + 2] | (unsigned)s->in[s->pos + 3] << 8;
+  s->pos += 4;
+  if (len != (~nlen & 0xFFFF) || len > s->size - s->pos ||
+      len > s->outSize - s->outPos)
+    return -1;
+  memcpy(s->out + s->outPos, s->in + s->pos, len);
+  s->pos += len;
+  s->outPos += len;
+  return 0;
+}
+
+static int inflateFixed(struct Inflate *s)
+{
+  unsigned char lengths[288];
+  struct InflateTable lencode, distcode;
+
+  memset(lengths, 8, 144);
+  memset(lengths + 144, 9, 112);
+  memset(lengths + 256, 7, 24);
+  memset(lengths + 280, 8, 8);
+  inflateBuild(&lencode, lengths, 288);
+  memset(lengths, 5, 30);
+  inflateBuild(&distcode, lengths, 30);
+  return inflateCodes(s, &lencode, &distcode);
+}
+
+static int inflateDynamic(struct Inflate *s)
+{
+  static const unsigned char order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5,
+                                          11, 4, 12, 3, 13, 2, 14, 1, 15};
+  unsigned char lengths[320];
+  struct InflateTable lencode, distcode;
+  long nlen = inflateBits(s, 5);
+  long ndist = inflateBits(s, 5);
+  long ncode = inflateBits(s, 4);
+
+  if (nlen < 0 || ndist < 0 || ncode < 0)
+    return -1;
+  nlen += 257;
+  ndist += 1;
+  ncode += 4;
+  if (nlen > 286 || ndist > 30)
+    return -1;
+
+  memset(lengths, 0, sizeof(lengths));
+  for (int i = 0; i < ncode; ++i)
+  {
+    long len = inflateBits(s, 3);
+    if (len < 0)
+      return -1;
+    lengths[order[i]] = (unsigned char)len;
+  }
+  if (inflateBuild(&lencode, lengths, 19) != 0)
+    return -1;
+
+  for (int index = 0; index < nlen + ndist;)
+  {
+    int symbol = inflateSymbol(s, &lencode);
+    long repeat;
+    unsigned char value = 0;
+    if (symbol < 0)
+      return -1;
+    if (symbol < 16)
+    {
+      lengths[index++] = (unsigned char)symbol;
+      continue;
+    }
+    if (symbol == 16)
+    {
+      if (index == 0)
+        return -1;
+      value = lengths[index - 1];
+      repeat = inflateBits(s, 2);
+      repeat = repeat < 0 ? -1 : 3 + repeat;
+    }
+    else if (symbol == 17)
+    {
+      repeat = inflateBits(s, 3);
+      repeat = repeat < 0 ? -1 : 3 + repeat;
+    }
+    else
+    {
+      repeat = inflateBits(s, 7);
+      repeat = repeat < 0 ? -1 : 11 + repeat;
+    }
+    if (repeat < 0 || index + repeat > nlen + ndist)
+      return -1;
+    while (repeat-- > 0)
+      lengths[index++] = value;
+  }
+  if (lengths[256] == 0)
+    return -1;
+
+  // Como na zlib: código incompleto só se for um único código de 1 bit
+  int err = inflateBuild(&lencode, lengths, (int)nlen);
+  if (err < 0 || (err > 0 && nlen - lencode.count[0] != 1))
+    return -1;
+  err = inflateBuild(&distcode, lengths + nlen, (int)ndist);
+  if (err < 0 || (err > 0 && ndist - distcode.count[0] != 1))
+    return -1;
+  return inflateCodes(s, &lencode, &distcode);
+}
+
+/**
+ * Descomprime um fluxo DEFLATE bruto.
+ *
+ * @param in Fluxo comprimido.
+ * @param size Bytes disponíveis.
+ * @param out Buffer de saída.
+ * @param outSize Capacidade do buffer de saída.
+ * @param used Recebe os bytes de in consumidos.
+ * @return Tamanho descomprimido, ou -1 se o fluxo for inválido.
+ */
+static long inflateRaw(const unsigned char *in, unsigned long size,
+                       unsigned char *out, unsigned long outSize,
+                       unsigned long *used)
+{
+  struct Inflate s = {in, size, 0, 0, 0, out, outSize, 0};
+  long last;
+
+  do
+  {
+    last = inflateBits(&s, 1);
+    long type = inflateBits(&s, 2);
+    int err;
+    if (last < 0 || type < 0)
+      return -1;
+    if (type == 0)
+      err = inflateStored(&s);
+    else if (type == 1)
+      err = inflateFixed(&s);
+    else if (type == 2)
+      err = inflateDynamic(&s);
+    else
+      err = -1;
+    if (err != 0)
+      return -1;
+  } while (!last);
+  *used = s.pos;
+  return (long)s.outPos;
+}
+
+static unsigned long readLe32(const unsigned char *p)
+{
+  return p[0] | (unsigned long)p[1] << 8 | (unsigned long)p[2] << 16 |
+         (unsigned long)p[3] << 24;
+}
+
+/**
+ * Descomprime um arquivo gzip de um membro sem campos opcionais, como os
+ * de huffmanGzipEncode, conferindo o CRC-32 e o tamanho.
+ *
+ * @return Tamanho descomprimido, ou -1 se o arquivo for inválido.
+ */
+static long gunzip(const unsigned char *in, unsigned long size,
+                   unsigned char *out, unsigned long outSize)
+{
+  unsigned long used;
+  long n;
+
+  if (size < HUFF_GZIP_OVERHEAD || in[0] != 0x1F || in[1] != 0x8B ||
+      in[2] != 8 || in[3] != 0)
+    return -1;
+  n = inflateRaw(in + 10, size - 10, out, outSize, &used);
+  if (n < 0 || 10 + used + 8 != size ||
+      readLe32(in + 10 + used) != huffmanCrc32(0, out, (unsigned long)n) ||
+      readLe32(in + 10 + used + 4) != ((unsigned long)n & 0xFFFFFFFF))
+    return -1;
+  return n;
+}
+
+#ifdef HUFF_TEST_ZLIB
+// Descomprime com a zlib (windowBits -15 para DEFLATE bruto, 31 para gzip)
+static long zlibInflate(const unsigned char *in, unsigned long size,
+                        unsigned char *out, unsigned long outSize,
+                        int windowBits)
+{
+  z_stream z;
+  long n = -1;
+
+  memset(&z, 0, sizeof(z));
+  if (inflateInit2(&z, windowBits) != Z_OK)
+    return -1;
+  z.next_in = (unsigned char *)in;
+  z.avail_in = (uInt)size;
+  z.next_out = out;
+  z.avail_out = (uInt)outSize;
+  if (inflate(&z, Z_FINISH) == Z_STREAM_END && z.avail_in == 0)
+    n = (long)z.total_out;
+  inflateEnd(&z);
+  return n;
+}
+#endif
+
+
+/**
+ * Comprime em DEFLATE e gzip em cada nível e confere com o inflate deste
+ * arquivo (e a zlib, se disponível). Com cópias, o fluxo nunca passa do de
+ * só literais, e níveis fora de 0 a 3 são recusados.
+ */
+static void testDeflate(const char *inputName, unsigned long size)
+{
+  static const char *names[] = {"deflate0", "deflate1", "deflate2",
+                                "deflate3"};
+  long literals = 0;
+
+  for (int level = HUFF_DEFLATE_LITERALS; level <= HUFF_LZ_BEST; ++level)
+  {
+    const char *name = names[level];
+    unsigned long used = 0;
+    long len = huffmanDeflateEncode(&deflateWork, input, size, coded,
+                                    MAX_CODED, level);
+    long n;
+
+    check(len > 0, inputName, name, "codificacao falhou");
+    if (len <= 0)
+      continue;
+    printf("%-14s %-10s %7lu -> %7ld\n", inputName, name, size, len);
+    if (level == HUFF_DEFLATE_LITERALS)
+      literals = len;
+    check(len <= literals, inputName, name, "copias maiores que os literais");
+    n = inflateRaw(coded, (unsigned long)len, (unsigned char *)output,
+                   MAX_INPUT, &used);
+    check(n == (long)size && used == (unsigned long)len &&
+              memcmp(output, input, size) == 0,
+          inputName, name, "inflate difere da entrada");
+#ifdef HUFF_TEST_ZLIB
+    n = zlibInflate(coded, (unsigned long)len, (unsigned char *)output,
+                    MAX_INPUT, -15);
+    check(n == (long)size && memcmp(output, input, size) == 0, inputName,
+          name, "zlib difere da entrada");
+#endif
+
+    memset(coded + len - 1, CANARY, CANARY_SIZE);
+    check(huffmanDeflateEncode(&deflateWork, input, size, coded,
+                               (unsigned long)len - 1, level) == -1 &&
+              canaryIntact(coded + len - 1),
+          inputName, name, "saida pequena demais aceita");
+
+    len = huffmanGzipEncode(&deflateWork, input, size, coded, MAX_CODED, level);
+    check(len > 0, inputName, name, "gzip falhou");
+    if (len <= 0)
+      continue;
+    n = gunzip(coded, (unsigned long)len, (unsigned char *)output, MAX_INPUT);
+    check(n == (long)size && memcmp(output, input, size) == 0, inputName,
+          name, "gzip difere da entrada");
+#ifdef HUFF_TEST_ZLIB
+    n = zlibInflate(coded, (unsigned long)len, (unsigned char *)output,
+                    MAX_INPUT, 31);
+    check(n == (long)size && memcmp(output, input, size) == 0, inputName,
+          name, "zlib (gzip) difere da entrada");
+#endif
+  }
+
+  check(huffmanDeflateEncode(&deflateWork, input, size, coded, MAX_CODED,
+                             -1) == -1 &&
+            huffmanDeflateEncode(&deflateWork, input, size, coded, MAX_CODED,
+                                 HUFF_LZ_BEST + 1) == -1 &&
+            huffmanGzipEncode(&deflateWork, input, size, coded, MAX_CODED,
+                              HUFF_LZ_BEST + 1) == -1,
+        inputName, "deflate", "nivel invalido aceito");
+}
+
+/* ------------------------------------------------------------------------ */
+/* Índice de acesso aleatório                                               */
+/* ------------------------------------------------------------------------ */
+
+// Mesmos campos e pontos nos dois índices
+static int sameIndex(const struct HuffmanSeekIndex *a,
+                     const struct HuffmanSeekIndex *b)
+{
+  if (a->count != b->count || a->interval != b->interval ||
+      a->rawSize != b->rawSize || a->archiveSize != b->archiveSize)
+    return 0;
+  for (unsigned long i = 0; i < a->count; ++i)
+  {
+    const struct HuffmanSeekPoint *p = &a->points[i];
+    const struct HuffmanSeekPoint *q = &b->points[i];
+    if (p->rawOffset != q->rawOffset || p->blockRawOffset != q->blockRawOffset ||
+        p->blockOffset != q->blockOffset || p->byteOffset != q->byteOffset ||
+        p->bit != q->bit)
+      return 0;
+  }
+  return 1;
+}
+
+// Intervalos ao acaso decodificados por huffmanDecodeRange
+static void checkRanges(const char *inputName, const char *name,
+                        const struct HuffmanSeekIndex *index,
+                        unsigned long archiveSize, unsigned long size)
+{
+  for (int i = 0; i < 200 && size > 0; ++i)
+  {
+    unsigned long offset = nextRandom() % size;
+    unsigned long n = 1 + nextRandom() % 3000;
+    if (n > size - offset)
+      n = size - offset;
+    check(huffmanDecodeRange(&decodeWork, coded, archiveSize, index, offset,
+                             output, n) == 0 &&
+              memcmp(output, input + offset, n) == 0,
+          inputName, name, "intervalo difere da entrada");
+  }
+  check(huffmanDecodeRange(&decodeWork, coded, archiveSize, index, size,
+                           output, 1) == -1,
+        inputName, name, "intervalo alem do fim aceito");
+}
+
+/**
+ * Comprime a entrada em blocos de SEEK_BLOCK bytes, indexa cada um e
+ * confere intervalos ao acaso, com o índice montado e com o mesmo índice
+ * gravado e lido de volta.
+ */
+static void testSeek(const char *inputName, unsigned long size, int flags)
+{
+  const char *name = flags & HUFF_BLOCK_FLAG_STREAMS ? "indice/str" : "indice";
+  struct HuffmanSeekIndex index;
+  struct HuffmanSeekIndex loaded;
+  unsigned long archiveSize = 0;
+  long saved;
+
+  huffmanSeekIndexInit(&index, seekPoints, SEEK_POINTS, 1024);
+  for (unsigned long start = 0; start < size; start += SEEK_BLOCK)
+  {
+    unsigned long n = size - start < SEEK_BLOCK ? size - start : SEEK_BLOCK;
+    long len = huffmanBlockEncode(&blockWork, input + start, n,
+                                  coded + archiveSize, MAX_CODED - archiveSize,
+                                  flags);
+    check(len > 0 && huffmanSeekIndexAddBlock(&index, coded + archiveSize,
+                                              (unsigned long)len,
+                                              input + start) == 0,
+          inputName, name, "bloco nao indexado");
+    if (len <= 0)
+      return;
+    archiveSize += (unsigned long)len;
+  }
+  checkRanges(inputName, name, &index, archiveSize, size);
+
+  // Gravado e lido de volta, o índice é o mesmo e serve os mesmos trechos
+  saved = huffmanSeekIndexWrite(&index, savedIndex, SEEK_SAVED);
+  check(saved == (long)huffmanSeekIndexSize(index.count) &&
+            huffmanSeekIndexWrite(&index, savedIndex, (unsigned long)saved - 1) ==
+                -1,
+        inputName, name, "tamanho do indice gravado");
+  if (saved < 0)
+    return;
+  check(huffmanSeekIndexRead(&loaded, readPoints, SEEK_POINTS, savedIndex,
+                             (unsigned long)saved) == 0 &&
+            sameIndex(&index, &loaded),
+        inputName, name, "indice lido difere do gravado");
+  checkRanges(inputName, name, &loaded, archiveSize, size);
+  printf("%-14s %-10s %lu pontos, %ld bytes\n", inputName, name, index.count,
+         saved);
+}
+
+/**
+ * Arquivo com blocos de cada módulo (HUFFMAN, CONTEXT, SEGMENTS, LZ e BWT,
+ * alternados): huffmanDecodeAnyRange serve trechos ao acaso, e
+ * huffmanDecodeRange recusa os que passam por entradas de bloco inteiro.
+ */
+static void testSeekAny(const char *inputName, unsigned long size)
+{
+  const char *name = "indice/any";
+  struct HuffmanSeekIndex index;
+  unsigned long archiveSize = 0;
+  unsigned long wholeStart = 0; // Início da primeira entrada de bloco inteiro
+  int wholeBlocks = 0;
+
+  huffmanSeekIndexInit(&index, seekPoints, SEEK_POINTS, 1024);
+  for (unsigned long start = 0, k = 0; start < size; start += SEEK_BLOCK, ++k)
+  {
+    unsigned long n = size - start < SEEK_BLOCK ? size - start : SEEK_BLOCK;
+    unsigned char *block = coded + archiveSize;
+    unsigned long room = MAX_CODED - archiveSize;
+    const char *in = input + start;
+    long len;
+
+    switch (k % 5)
+    {
+    case 0:
+      len = huffmanBlockEncode(&blockWork, in, n, block, room, 0);
+      break;
+    case 1:
+      len = huffmanContextEncode(&anyWork.bwt.context, in, n, block, room,
+                                 HUFF_BLOCK_FLAG_CRC);
+      break;
+    case 2:
+      len = huffmanSegmentsEncode(&anyWork.bwt.context, in, n, block, room, 0);
+      break;
+    case 3:
+      len = huffmanLzEncode(&anyWork.lz, in, n, block, room, 0,
+                            HUFF_LZ_DEFAULT);
+      break;
+    default:
+      len = huffmanBwtEncode(&anyWork.bwt, in, n, block, room, 0);
+      break;
+    }
+    check(len > 0 && huffmanSeekIndexAddBlock(&index, block, (unsigned long)len,
+                                              in) == 0,
+          inputName, name, "bloco nao indexado");
+    if (len <= 0)
+      return;
+
+    // Os tipos a partir de CONTEXT são dos módulos de host
+    if (block[3] >= HUFF_BLOCK_CONTEXT && wholeBlocks++ == 0)
+      wholeStart = start;
+    archiveSize += (unsigned long)len;
+  }
+
+  for (int i = 0; i < 200 && size > 0; ++i)
+  {
+    unsigned long offset = nextRandom() % size;
+    unsigned long n = 1 + nextRandom() % 3000;
+    if (n > size - offset)
+      n = size - offset;
+    check(huffmanDecodeAnyRange(&anyWork, coded, archiveSize, &index, offset,
+                                output, n) == 0 &&
+              memcmp(output, input + offset, n) == 0,
+          inputName, name, "intervalo difere da entrada");
+  }
+  check(huffmanDecodeAnyRange(&anyWork, coded, archiveSize, &index, 0, output,
+                              size) == 0 &&
+            memcmp(output, input, size) == 0 &&
+            huffmanDecodeAnyRange(&anyWork, coded, archiveSize, &index, size,
+                                  output, 1) == -1,
+        inputName, name, "arquivo inteiro ou alem do fim");
+  if (wholeBlocks > 0)
+    check(huffmanDecodeRange(&decodeWork, coded, archiveSize, &index,
+                             wholeStart, output, 1) == -1,
+          inputName, name, "entrada de bloco inteiro aceita");
+  printf("%-14s %-10s %d blocos inteiros\n", inputName, name, wholeBlocks);
+}
+
+/**
+ * Índices gravados recusados na leitura: truncados, com um byte alterado,
+ * de outra versão, com mais pontos que a capacidade ou fora de ordem. As
+ * posições acima de 4 GB voltam intactas.
+ */
+static void testSeekSaved(void)
+{
+  const char *name = "indice";
+  struct HuffmanSeekIndex index;
+  struct HuffmanSeekIndex loaded;
+  unsigned long size, crc;
+  long saved;
+
+  // Pontos de um arquivo de 5 GB, sem os blocos
+  huffmanSeekIndexInit(&index, seekPoints, SEEK_POINTS, 1024);
+  for (unsigned long i = 0; i < 4; ++i)
+  {
+    struct HuffmanSeekPoint *point = &seekPoints[i];
+    point->rawOffset = (uint64_t)(i + 1) << 30;
+    point->blockRawOffset = point->rawOffset;
+    point->blockOffset = point->rawOffset / 2;
+    point->byteOffset = 0;
+    point->bit = 0;
+  }
+  seekPoints[3].rawOffset += 5000;
+  seekPoints[3].blockRawOffset = seekPoints[2].blockRawOffset;
+  seekPoints[3].blockOffset = seekPoints[2].blockOffset;
+  seekPoints[3].byteOffset = 2000;
+  seekPoints[3].bit = 5;
+  index.count = 4;
+  index.rawSize = 5ull << 30;
+  index.archiveSize = 3ull << 30;
+
+  saved = huffmanSeekIndexWrite(&index, savedIndex, SEEK_SAVED);
+  size = saved > 0 ? (unsigned long)saved : 0;
+  check(size == HUFF_SEEK_HEADER_SIZE + 4 * HUFF_SEEK_POINT_SIZE +
+                    HUFF_BLOCK_CRC_SIZE &&
+            huffmanSeekIndexRead(&loaded, readPoints, SEEK_POINTS, savedIndex,
+                                 size) == 0 &&
+            sameIndex(&index, &loaded),
+        "5 GB", name, "posicoes de 64 bits perdidas");
+  if (size == 0)
+    return;
+
+  check(huffmanSeekIndexRead(&loaded, readPoints, SEEK_POINTS, savedIndex,
+                             size - 1) == -1 &&
+            huffmanSeekIndexRead(&loaded, readPoints, SEEK_POINTS, savedIndex,
+                                 HUFF_SEEK_HEADER_SIZE) == -1 &&
+            huffmanSeekIndexRead(&loaded, readPoints, 3, savedIndex, size) == -1,
+        "recusa", name, "indice truncado ou grande demais aceito");
+  for (unsigned long i = 0; i < size; ++i)
+  {
+    savedIndex[i] ^= 0x10;
+    check(huffmanSeekIndexRead(&loaded, readPoints, SEEK_POINTS, savedIndex,
+                               size) == -1,
+          "recusa", name, "byte alterado aceito");
+    savedIndex[i] ^= 0x10;
+  }
+
+  // Pontos fora de ordem, gravados com um CRC válido
+  index.points[1].rawOffset = index.points[0].rawOffset;
+  huffmanSeekIndexWrite(&index, savedIndex, SEEK_SAVED);
+  check(huffmanSeekIndexRead(&loaded, readPoints, SEEK_POINTS, savedIndex,
+                             size) == -1,
+        "recusa", name, "pontos fora de ordem aceitos");
+
+  // Outra versão, com o CRC refeito: só a versão é recusada
+  index.points[1].rawOffset = 2ull << 30;
+  huffmanSeekIndexWrite(&index, savedIndex, SEEK_SAVED);
+  savedIndex[2] = HUFF_SEEK_VERSION + 1;
+  crc = crc32c(0, savedIndex, size - HUFF_BLOCK_CRC_SIZE);
+  for (int b = 0; b < 4; ++b)
+    savedIndex[size - HUFF_BLOCK_CRC_SIZE + b] = (unsigned char)(crc >> 8 * b);
+  check(huffmanSeekIndexRead(&loaded, readPoints, SEEK_POINTS, savedIndex,
+                             size) == -1,
+        "recusa", name, "outra versao aceita");
+}
+
+int main(void)
+{
+  printf("Perfil: alfabeto de %d simbolos, codigos de ate %d bits\n\n",
+         HUFF_ALPHABET_SIZE, HUFF_MAX_CODE_LEN);
+
+  for (int i = 0; i < INPUTS; ++i)
+  {
+    unsigned long size, codedSize;
+    state = 1 + (unsigned long)i;
+    size = inputs[i].make();
+    testStreamEncoder(inputs[i].name, size, 1);
+    codedSize = testStreamEncoder(inputs[i].name, size, STREAM_PART);
+    testStreamDecoder(inputs[i].name, size, codedSize, 1, 1);
+    testStreamDecoder(inputs[i].name, size, codedSize, 1, 7);
+    testStreamDecoder(inputs[i].name, size, codedSize, STREAM_PART, 64);
+    testStreamDecoder(inputs[i].name, size, codedSize, STREAM_PART,
+                      STREAM_PART);
+    if (size > 0)
+      testStreamDecoderErrors(inputs[i].name, size, codedSize);
+    testCanonical(inputs[i].name, size);
+#ifdef HUFF_TEST_TABLES
+    testTablesInput(inputs[i].name, size);
+#endif
+    for (int e = 0; e < ENCODERS; ++e)
+    {
+      testEncoder(inputs[i].name, size, e, 0);
+      testEncoder(inputs[i].name, size, e, HUFF_BLOCK_FLAG_CRC);
+    }
+    testAsset(inputs[i].name, size);
+    testDeflate(inputs[i].name, size);
+    testSeek(inputs[i].name, size, 0);
+    testSeek(inputs[i].name, size, HUFF_BLOCK_FLAG_STREAMS);
+    testSeekAny(inputs[i].name, size);
+  }
+  testStreamEncoderErrors();
+  testCanonicalErrors();
+#ifdef HUFF_TEST_TABLES
+  testTables();
+#endif
+  testSeekSaved();
+  testFallbacks();
+  testCorruption();
+
+#if HUFF_ALPHABET_SIZE < 256
+  // Caractere fora do alfabeto: todos os codificadores de blocos recusam
+  state = 1;
+  unsigned long size = makeTelemetry(FUZZ_INPUT);
+  input[size / 2] = (char)HUFF_ALPHABET_SIZE;
+  for (int e = 0; e < ENCODERS; ++e)
+    check(encoders[e].encode(input, size, coded, MAX_CODED, 0) == -1,
+          "fora do alfabeto", encoders[e].name, "entrada aceita");
+#endif
+
+  // Cada caminho de huffman_cpu.c decodifica os mesmos blocos, com uma
+  // KernelWork reaproveitada de um caminho para o outro
+  static const unsigned masks[] = {
+      0, HUFF_CPU_X86_64, HUFF_CPU_X86_64 | HUFF_CPU_BMI2,
+      HUFF_CPU_X86_64 | HUFF_CPU_BMI2 | HUFF_CPU_AVX2};
+  state = 1;
+  unsigned long text = makeTelemetry(100000);
+  for (int m = 0; m < 4; ++m)
+  {
+    huffmanSetCpuFeatures(masks[m]);
+    check((huffmanCpuFeatures() & ~masks[m]) == 0, "cpu",
+          huffmanKernels()->decodeName, "recurso fora da mascara");
+    for (int e = 0; e < 2; ++e)
+    {
+      long len = encoders[e].encode(input, text, coded, MAX_CODED, 0);
+      check(len > 0 && roundTrips(coded, (unsigned long)len, text), "cpu",
+            encoders[e].name, "decodificacao difere da entrada");
+    }
+  }
+  huffmanSetCpuFeatures(~0u);
+
+  printf("\n%d testes, %d falhas\n", tests, failures);
+  return failures != 0;
+}
@@ -0,0 +1,350 @@
+/*
+ * Algoritmo de Codificação de Huffman - Testes da biblioteca C++
+ *
+ * Descrição:
+ * Ferramenta de host que confere huffman.hpp contra o núcleo em C, com o
+ * alfabeto e o comprimento máximo de código do perfil. Para cada entrada
+ * (vazia, de 1 byte, com todos os símbolos do alfabeto, texto de
+ * telemetria, dados aleatórios e um histograma que força o limite de
+ * comprimento):
+ * - makeCodeTable gera os mesmos comprimentos e códigos que buildCodeTable;
+ * - Encoder::encode gera o mesmo fluxo que huffmanEncodeBuffer, dentro de
+ *   Encoder::bound e do tamanho dado por encodedBits;
+ * - Decoder::decode devolve a entrada e recusa o fluxo sem o último byte.
+ * Confere também que comprimentos fora da desigualdade de Kraft, códigos que
+ * são prefixo de outros e códigos inexistentes são recusados, e que as
+ * tabelas calculadas pelo compilador (makeTables, ou compileTables em
+ * C++20), conferidas com static_assert, são as que o núcleo em C gera em
+ * execução para o mesmo histograma.
+ *
+ * Uso (o núcleo em C é compilado como C e ligado ao teste):
+ * gcc -O2 -fsanitize=address,undefined -c huffman.c huffman_encode.c huffman_decode.c
+ * g++ -std=c++17 -O2 -fsanitize=address,undefined huffman_test.cpp huffman.o huffman_encode.o huffman_decode.o -o huffman_test_cpp
+ * ./huffman_test_cpp
+ * Retorna 0 se todos os testes passarem. Repita com -DHUFF_PROFILE=STM32F030
+ * nos dois comandos e, para compileTables, com -std=c++20.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "huffman.hpp"
+
+extern "C"
+{
+#include "huffman.h"
+}
+
+constexpr std::size_t kAlphabet = HUFF_ALPHABET_SIZE;
+constexpr unsigned kMaxBits = HUFF_MAX_CODE_LEN;
+constexpr std::size_t kMaxInput = 128 * 1024;
+constexpr std::size_t kMaxCoded = 2 * kMaxInput + 64;
+
+using Codes = huffman::CodeTable<kAlphabet, kMaxBits>;
+using Encoder = huffman::Encoder<kAlphabet, kMaxBits>;
+using Decoder = huffman::Decoder<kAlphabet, kMaxBits>;
+
+static char input[kMaxInput];
+static unsigned char expected[kMaxCoded];
+static unsigned char coded[kMaxCoded];
+static unsigned char output[kMaxInput];
+static HuffmanTreeWork tree;
+static unsigned long state = 1;
+static int tests;
+static int failures;
+
+// Gerador congruente linear: as entradas são sempre as mesmas
+static unsigned long nextRandom()
+{
+  state = (state * 1103515245ul + 12345ul) & 0x7FFFFFFF;
+  return state >> 8;
+}
+
+static void check(bool ok, const char *input, const char *name,
+                  const char *what)
+{
+  tests++;
+  if (!ok)
+  {
+    failures++;
+    std::printf("FALHA: %s, %s: %s\n", input, name, what);
+  }
+}
+
+/* ------------------------------------------------------------------------ */
+/* Entradas                                                                 */
+/* ------------------------------------------------------------------------ */
+
+static std::size_t makeEmpty()
+{
+  return 0;
+}
+
+static std::size_t makeOne()
+{
+  input[0] = 'A';
+  return 1;
+}
+
+// Cada símbolo do alfabeto uma vez, em ordem
+static std::size_t makeAlphabet()
+{
+  for (std::size_t i = 0; i < kAlphabet; ++i)
+    input[i] = static_cast<char>(i);
+  return kAlphabet;
+}
+
+// Leituras de sensores em texto, variando devagar
+static std::size_t makeTelemetry()
+{
+  std::size_t size = 0;
+  long temperature = 2350, humidity = 550, voltage = 330;
+  char line[64];
+
+  for (;;)
+  {
+    temperature += static_cast<long>(nextRandom() % 21) - 10;
+    humidity += static_cast<long>(nextRandom() % 7) - 3;
+    voltage += static_cast<long>(nextRandom() % 3) - 1;
+    int len = std::snprintf(line, sizeof(line),
+                            "T=%ld.%02ld,H=%ld.%ld,V=%ld.%02ld\n",
+                            temperature / 100, std::labs(temperature % 100),
+                            humidity / 10, std::labs(humidity % 10),
+                            voltage / 100, std::labs(voltage % 100));
+    if (size + static_cast<std::size_t>(len) > kMaxInput)
+      return size;
+    std::memcpy(input + size, line, static_cast<std::size_t>(len));
+    size += static_cast<std::size_t>(len);
+  }
+}
+
+static std::size_t makeRandom()
+{
+  for (std::size_t i = 0; i < 70000; ++i)
+    input[i] = static_cast<char>(nextRandom() % kAlphabet);
+  return 70000;
+}
+
+// Símbolo i repetido 2^i vezes: sem limite, o código mais longo passaria de
+// kMaxBits bits
+static std::size_t makeSkewed()
+{
+  std::size_t size = 0;
+
+  for (unsigned i = 0; i <= kMaxBits + 1; ++i)
+  {
+    std::memset(input + size, 'a' + static_cast<int>(i), std::size_t{1} << i);
+    size += std::size_t{1} << i;
+  }
+  return size;
+}
+
+static const struct
+{
+  const char *name;
+  std::size_t (*make)();
+} inputs[] = {{"vazia", makeEmpty},
+              {"1 byte", makeOne},
+              {"alfabeto", makeAlphabet},
+              {"texto", makeTelemetry},
+              {"aleatoria", makeRandom},
+              {"desbalanceada", makeSkewed}};
+
+/* ------------------------------------------------------------------------ */
+/* Comparação com o núcleo em C                                             */
+/* ------------------------------------------------------------------------ */
+
+/**
+ * Gera os códigos da entrada nas duas bibliotecas e confere tabelas, fluxo
+ * e decodificação.
+ */
+static void testInput(const char *inputName, std::size_t size)
+{
+  const char *name = "hpp";
+  unsigned freq[HUFF_ALPHABET_SIZE] = {0};
+  huffman::Histogram<kAlphabet> histogram{};
+  HuffmanCodeTable table;
+  bool same = true;
+
+  calculateFrequencyInChunks(input, freq, static_cast<int>(size), 1000);
+  buildCodeTable(&tree, freq, &table);
+  for (std::size_t i = 0; i < kAlphabet; ++i)
+    histogram[i] = freq[i];
+
+  const Codes codes = huffman::makeCodeTable<kAlphabet, kMaxBits>(histogram);
+  for (std::size_t i = 0; i < kAlphabet; ++i)
+    same &= codes.len[i] == table.len[i] &&
+            (codes.len[i] == 0 || codes.bits[i] == table.bits[i]);
+  check(same, inputName, name, "codigos diferentes de buildCodeTable");
+
+  const Encoder encoder(codes);
+  const auto *in = reinterpret_cast<const unsigned char *>(input);
+  unsigned long long expectedBits =
+      huffmanEncodeBuffer(&table, input, size, expected);
+  std::uint64_t bits = encoder.encode(in, size, coded);
+  std::size_t bytes = static_cast<std::size_t>((bits + 7) / 8);
+  check(bits == expectedBits && bits == encoder.encodedBits(histogram) &&
+            bytes <= Encoder::bound(size) &&
+            std::memcmp(coded, expected, bytes) == 0,
+        inputName, name, "fluxo diferente de huffmanEncodeBuffer");
+
+  const Decoder decoder(codes);
+  check(decoder.valid() && decoder.decode(coded, bytes, output, size) &&
+            std::memcmp(output, input, size) == 0,
+        inputName, name, "decodificacao difere da entrada");
+
+  // Cópia no tamanho exato, para o AddressSanitizer acusar leituras além
+  if (bytes > 0)
+  {
+    auto *copy =
+        static_cast<unsigned char *>(std::malloc(bytes - 1 ? bytes - 1 : 1));
+    std::memcpy(copy, coded, bytes - 1);
+    check(!decoder.decode(copy, bytes - 1, output, size), inputName, name,
+          "aceitou fluxo truncado");
+    std::free(copy);
+  }
+
+  std::printf("%-14s %-10s %7zu -> %7zu\n", inputName, name, size, bytes);
+}
+
+/**
+ * Comprimentos fora da desigualdade de Kraft, um código que é prefixo de
+ * outro e um código que não existe num prefixo incompleto são recusados.
+ */
+static void testErrors()
+{
+  const char *name = "hpp";
+  const unsigned char ones = 0xFF;
+  unsigned char out[4];
+  Codes codes{};
+
+  codes.len[0] = codes.len[1] = codes.len[2] = 1;
+  check(!huffman::assignCanonicalCodes(codes), "recusa", name,
+        "comprimentos fora de Kraft aceitos");
+
+  // 0 e 01: o primeiro é prefixo do segundo
+  codes = Codes{};
+  codes.len[0] = 1;
+  codes.len[1] = 2;
+  codes.bits[1] = 1;
+  const Decoder prefix(codes);
+  check(!prefix.valid() && !prefix.decode(&ones, 1, out, 1), "recusa", name,
+        "codigo prefixo de outro aceito");
+
+  // Só 00 e 01: nenhum código começa com 1
+  codes = Codes{};
+  codes.len[0] = codes.len[1] = 2;
+  check(huffman::assignCanonicalCodes(codes), "recusa", name,
+        "comprimentos validos recusados");
+  const Decoder incomplete(codes);
+  check(incomplete.valid() && !incomplete.decode(&ones, 1, out, 1), "recusa",
+        name, "codigo inexistente decodificado");
+}
+
+/* ------------------------------------------------------------------------ */
+/* Tabelas em tempo de compilação                                           */
+/* ------------------------------------------------------------------------ */
+
+using Tables = huffman::Tables<kAlphabet, kMaxBits>;
+
+constexpr std::string_view kSample = "T=23.51,H=45.20,V=3.301\n"
+                                     "T=-4.07,H=88.90,V=3.298\n"
+                                     "T=31.66,H=12.45,V=3.287\n";
+
+// Símbolo i com peso 2^i, como makeSkewed: força o limite de comprimento
+constexpr huffman::Histogram<kAlphabet> makeSkewedHistogram()
+{
+  huffman::Histogram<kAlphabet> freq{};
+
+  for (unsigned i = 0; i <= kMaxBits + 1; ++i)
+    freq['a' + i] = std::uint32_t{1} << i;
+  return freq;
+}
+
+constexpr auto kSampleFreq = huffman::makeHistogram<kAlphabet>(kSample);
+constexpr auto kSkewedFreq = makeSkewedHistogram();
+
+#if __cplusplus >= 202002L
+constexpr Tables kSampleTables =
+    huffman::compileTables<kAlphabet, kMaxBits>(kSampleFreq);
+constexpr Tables kSkewedTables =
+    huffman::compileTables<kAlphabet, kMaxBits>(kSkewedFreq);
+#else
+constexpr Tables kSampleTables =
+    huffman::makeTables<kAlphabet, kMaxBits>(kSampleFreq);
+constexpr Tables kSkewedTables =
+    huffman::makeTables<kAlphabet, kMaxBits>(kSkewedFreq);
+#endif
+
+static_assert(huffman::fitsAlphabet<kAlphabet>(kSample),
+              "A amostra tem símbolos fora do alfabeto");
+static_assert(huffman::verifyTables(kSampleTables, kSampleFreq),
+              "Tabelas da amostra inconsistentes");
+static_assert(huffman::verifyTables(kSkewedTables, kSkewedFreq),
+              "Tabelas desbalanceadas inconsistentes");
+static_assert(kSkewedTables.codes.len['a'] == kMaxBits,
+              "O símbolo mais raro deve ficar no limite de comprimento");
+
+/**
+ * As tabelas calculadas pelo compilador são as que buildCodeTable e
+ * buildDecodeTable geram em execução para o mesmo histograma, e o par
+ * Encoder/Decoder montado com elas faz a ida e volta sem reconstruir a
+ * árvore.
+ */
+static void testCompileTime(const char *inputName, const Tables &tables,
+                            const huffman::Histogram<kAlphabet> &histogram)
+{
+  const char *name = "constexpr";
+  unsigned freq[HUFF_ALPHABET_SIZE] = {0};
+  HuffmanCodeTable table;
+  HuffmanDecodeTable decodeTable;
+  std::size_t size = 0;
+  bool same = true;
+
+  for (std::size_t i = 0; i < kAlphabet; ++i)
+  {
+    freq[i] = histogram[i];
+    std::memset(input + size, static_cast<int>(i), histogram[i]);
+    size += histogram[i];
+  }
+  buildCodeTable(&tree, freq, &table);
+  for (std::size_t i = 0; i < kAlphabet; ++i)
+    same &= tables.codes.len[i] == table.len[i] &&
+            (table.len[i] == 0 || tables.codes.bits[i] == table.bits[i]);
+  check(same, inputName, name, "codigos diferentes de buildCodeTable");
+
+  same = buildDecodeTable(&table, &decodeTable) == 0;
+  for (std::size_t i = 0; i < kAlphabet; ++i)
+    same &= tables.decode.child[i][0] == decodeTable.child[i][0] &&
+            tables.decode.child[i][1] == decodeTable.child[i][1];
+  check(same, inputName, name, "arvore diferente de buildDecodeTable");
+
+  const Encoder encoder(tables);
+  const Decoder decoder(tables);
+  const auto *in = reinterpret_cast<const unsigned char *>(input);
+  std::uint64_t bits = encoder.encode(in, size, coded);
+  std::size_t bytes = static_cast<std::size_t>((bits + 7) / 8);
+  check(bits == encoder.encodedBits(histogram) && decoder.valid() &&
+            decoder.decode(coded, bytes, output, size) &&
+            std::memcmp(output, input, size) == 0,
+        inputName, name, "decodificacao difere da entrada");
+
+  std::printf("%-14s %-10s %7zu -> %7zu\n", inputName, name, size, bytes);
+}
+
+int main()
+{
+  std::printf("Perfil: alfabeto de %zu simbolos, codigos de ate %u bits\n\n",
+              kAlphabet, kMaxBits);
+
+  for (std::size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i)
+  {
+    state = 1 + i;
+    testInput(inputs[i].name, inputs[i].make());
+  }
+  testErrors();
+  testCompileTime("amostra", kSampleTables, kSampleFreq);
+  testCompileTime("desbalanceada", kSkewedTables, kSkewedFreq);
+
+  std::printf("\n%d testes, %d falhas\n", tests, failures);
+  return failures != 0;
+}